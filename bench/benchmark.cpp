@@ -0,0 +1,244 @@
+// Include corresponding header
+#include "benchmark.hpp"
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+// JSON includes
+#include <nlohmann/json.hpp>
+// Memory usage
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace bench {
+
+namespace {
+    // Every benchmark registered, in the order the files registered them
+    std::vector<std::pair<std::string, Function>>& registry() {
+        static std::vector<std::pair<std::string, Function>> functions;
+        return functions;
+    }
+
+    // Run times counted into buckets 1% wide from a nanosecond up, so that keeping them takes the same memory however
+    // many runs there are and none of it is counted against the benchmark's own
+    class RunTimes {
+    public:
+        RunTimes() : buckets(static_cast<size_t>(std::log(1e12) / std::log(GROWTH)) + 1, 0) {}
+
+        // Counts the run time into its bucket
+        void add(double seconds) {
+            const double scaled = std::max(seconds * 1e9, 1.0);
+            buckets[std::min(buckets.size() - 1, static_cast<size_t>(std::log(scaled) / std::log(GROWTH)))]++;
+            runs++;
+        }
+        // The run time at the given rank in time order, as the middle of its bucket
+        double at(unsigned long rank) const {
+            unsigned long counted = 0;
+            size_t bucket = 0;
+            while ((counted += buckets[bucket]) <= rank) { bucket++; }
+            return std::pow(GROWTH, bucket + 0.5) * 1e-9;
+        }
+
+        unsigned long runs = 0;
+
+    private:
+        static constexpr double GROWTH = 1.01;
+        std::vector<unsigned long> buckets;
+    };
+}
+
+// Runs the body once to warm up, then as many times as fit in min_seconds
+void Runner::measure(const std::string &name, size_t items, const std::function<void()> &body,
+                     const std::function<void()> &setup) {
+    RunTimes run_times;
+    reset_peak_memory();
+    const double start_memory = current_memory_mb();
+    if (setup) { setup(); }
+    body();
+
+    double timed = 0;
+    while (run_times.runs == 0 || timed < config.min_seconds) {
+        if (setup) { setup(); }
+        auto start = std::chrono::steady_clock::now();
+        body();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        run_times.add(seconds);
+        timed += seconds;
+    }
+    // Throughput is taken at the median run, so one run disturbed by the rest of the machine does not skew it
+    const unsigned long runs = run_times.runs;
+    const double median = run_times.at(runs / 2);
+    const double p99 = run_times.at(std::min(runs - 1, runs * 99 / 100));
+
+    // Memory is counted from the resident set at the start, so whatever earlier benchmarks left behind is not
+    Result result{name, runs, timed / runs, p99, items / median, std::max(0.0, peak_memory_mb() - start_memory)};
+    std::cout << std::left << std::setw(48) << name << std::right << std::setw(8) << runs
+              << std::setw(14) << std::fixed << std::setprecision(3) << result.seconds_per_run * 1e3
+              << std::setw(16) << std::setprecision(0) << result.items_per_second
+              << std::setw(12) << std::setprecision(1) << result.peak_memory_mb << std::endl;
+    results.push_back(result);
+}
+
+// Splits the filter on commas
+bool Config::matches(const std::string &name) const {
+    size_t start = 0;
+    while (true) {
+        const size_t comma = filter.find(',', start);
+        const std::string part = filter.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        if (name.find(part) != std::string::npos) { return true; }
+        if (comma == std::string::npos) { return false; }
+        start = comma + 1;
+    }
+}
+
+// Scales by factors of ten from 10 symbols
+std::vector<size_t> Runner::symbol_counts() const {
+    std::vector<size_t> counts;
+    for (size_t count = 10; count <= config.max_symbols && count <= 10000; count *= 10) { counts.push_back(count); }
+    return counts;
+}
+
+// Adds the benchmark to the registry
+int add(const char* name, Function function) {
+    registry().emplace_back(name, function);
+    return static_cast<int>(registry().size()) - 1;
+}
+
+// Numbers the symbols with leading zeroes so they sort in order
+std::vector<std::string> symbols(size_t n) {
+    std::vector<std::string> names;
+    names.reserve(n);
+    char name[32];
+    for (size_t i = 0; i < n; ++i) {
+        snprintf(name, sizeof(name), "SYN%05zu US EQUITY", i);
+        names.emplace_back(name);
+    }
+    return names;
+}
+
+// Asks the operating system for the high water mark of the resident set
+double peak_memory_mb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) { return 0; }
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+#ifdef __linux__
+    // The high water mark in the status file is the one reset_peak_memory resets
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line);) {
+        if (line.compare(0, 6, "VmHWM:") == 0) { return std::strtod(line.c_str() + 6, nullptr) / 1024.0; }
+    }
+#endif
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+// Asks the operating system for the current size of the resident set
+double current_memory_mb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) { return 0; }
+    return counters.WorkingSetSize / (1024.0 * 1024.0);
+#else
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line);) {
+        if (line.compare(0, 6, "VmRSS:") == 0) { return std::strtod(line.c_str() + 6, nullptr) / 1024.0; }
+    }
+#endif
+    // Without a way to read the current size, growth is measured from nothing
+    return 0;
+#endif
+}
+
+// Writing 5 to clear_refs resets the high water mark of the resident set. The memory the allocator is holding onto
+// from earlier benchmarks is handed back first, so that it is not counted against this one.
+void reset_peak_memory() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+#ifdef __linux__
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    if (clear_refs) { clear_refs << "5"; }
+#endif
+}
+
+}
+
+// Runs every registered benchmark matching the filter. Takes --filter=, --max-symbols=, --min-time= and --json=. With
+// --baseline=, runs the scenarios the baseline was recorded with and fails if any has regressed past its tolerance,
+// or with --update-baseline as well, records the results as the new baseline.
+int main(int argc, char* argv[]) {
+    bench::Config config;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&arg](const char* option) { return arg.substr(std::strlen(option)); };
+        if (arg.rfind("--filter=", 0) == 0) { config.filter = value("--filter="); }
+        else if (arg.rfind("--max-symbols=", 0) == 0) { config.max_symbols = std::stoul(value("--max-symbols=")); }
+        else if (arg.rfind("--min-time=", 0) == 0) { config.min_seconds = std::stod(value("--min-time=")); }
+        else if (arg.rfind("--json=", 0) == 0) { config.json = value("--json="); }
+        else if (arg.rfind("--baseline=", 0) == 0) { config.baseline = value("--baseline="); }
+        else if (arg == "--update-baseline") { config.update_baseline = true; }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--filter=NAME[,NAME...]] [--max-symbols=N] [--min-time=SECONDS]"
+                      << " [--json=FILE] [--baseline=FILE [--update-baseline]]" << std::endl;
+            return 1;
+        }
+    }
+    try {
+        if (!config.baseline.empty()) { bench::read_baseline_config(config); }
+    } catch (const std::exception& e) {
+        // A missing baseline is only fine when about to record one
+        if (!config.update_baseline) { std::cerr << e.what() << std::endl; return 1; }
+    }
+
+    bench::Runner runner(config);
+    std::cout << std::left << std::setw(48) << "Benchmark" << std::right << std::setw(8) << "runs"
+              << std::setw(14) << "ms/run" << std::setw(16) << "items/sec" << std::setw(12) << "peak MB" << std::endl;
+    for (const auto& benchmark : bench::registry()) {
+        if (!config.matches(benchmark.first)) { continue; }
+        benchmark.second(runner);
+    }
+
+    if (!config.json.empty()) {
+        nlohmann::json output = nlohmann::json::array();
+        for (const bench::Result& result : runner.results) {
+            output.push_back({{"name", result.name},
+                              {"runs", result.runs},
+                              {"seconds_per_run", result.seconds_per_run},
+                              {"p99_seconds", result.p99_seconds},
+                              {"items_per_second", result.items_per_second},
+                              {"peak_memory_mb", result.peak_memory_mb}});
+        }
+        std::ofstream file(config.json, std::ios_base::out | std::ios_base::trunc);
+        if (!file.is_open()) { std::cerr << "Could not open " << config.json << "!" << std::endl; return 1; }
+        file << std::setw(4) << output << std::endl;
+    }
+
+    if (config.baseline.empty()) { return 0; }
+    if (config.update_baseline) {
+        bench::write_baseline(config, runner.results);
+        std::cout << "Recorded baseline " << config.baseline << std::endl;
+        return 0;
+    }
+    return bench::check_baseline(config, runner.results, std::cout) ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+#ifndef BACKTESTER_BENCHMARK_HPP
+#define BACKTESTER_BENCHMARK_HPP
+// STL includes
+#include <functional>
+#include <string>
+#include <vector>
+
+// A small benchmark harness for the backtester. Every benchmark is a function registered with the BENCHMARK macro,
+// which sets up whatever it needs (usually on a synthetic market, so nothing needs a Bloomberg terminal) and then
+// hands the code to time to Runner::measure. Measurements are repeated until they have taken long enough to be
+// stable, and are reported as time per run, items per second, and how far the peak memory of the process rose over
+// what it was using when the measurement started.
+namespace bench {
+    // Options from the command line
+    struct Config {
+        // Only benchmarks whose names contain one of these comma-separated names are run
+        std::string filter;
+        // The largest number of symbols to scale up to, out of 10, 100, 1000 and 10000
+        size_t max_symbols = 1000;
+        // How long to keep repeating each measurement, in seconds
+        double min_seconds = 0.5;
+        // Where to write the results as JSON, if anywhere
+        std::string json;
+        // The baseline to compare the results against (see regression.cpp), and whether to overwrite it instead
+        std::string baseline;
+        bool update_baseline = false;
+
+        // Whether the benchmark of the given name passes the filter
+        bool matches(const std::string& name) const;
+    };
+
+    // One measurement
+    struct Result {
+        std::string name;
+        unsigned long runs;
+        double seconds_per_run;
+        // The 99th percentile of the run times (to within 1%): the slowest run when there are fewer than a hundred
+        double p99_seconds;
+        // Items per second at the median run time
+        double items_per_second;
+        // The rise of the peak resident memory over the resident memory at the start of the measurement
+        double peak_memory_mb;
+    };
+
+    // Times the code handed to it and collects the results
+    class Runner {
+    public:
+        explicit Runner(const Config& p_config) : config(p_config) {}
+
+        // Times the body, repeating it until min_seconds have passed, where each run processes the given number of
+        // items. The setup is run untimed before every run, for benchmarks whose body uses up its input.
+        void measure(const std::string& name, size_t items, const std::function<void()>& body,
+                     const std::function<void()>& setup = nullptr);
+
+        // The symbol counts to scale over, up to the configured maximum
+        std::vector<size_t> symbol_counts() const;
+
+        const Config& config;
+        std::vector<Result> results;
+    };
+
+    // Registers a benchmark, returning its index
+    typedef void (*Function)(Runner&);
+    int add(const char* name, Function function);
+
+    // Names for n generated symbols, e.g. "SYN00042 US EQUITY"
+    std::vector<std::string> symbols(size_t n);
+    // The peak resident memory of the process in megabytes, since the last reset where the platform allows one
+    double peak_memory_mb();
+    // The current resident memory of the process in megabytes, or 0 where the platform cannot tell
+    double current_memory_mb();
+    // Resets the peak resident memory to the current resident memory, so the peak of each measurement is its own
+    // rather than that of every benchmark before it. Only possible on Linux; elsewhere the peak is the process's.
+    void reset_peak_memory();
+
+    // Performance regression gate. A baseline file holds the config the benchmarks were run with, the tolerances
+    // allowed, and the results to compare against:
+    //
+    //      {"config": {"filter": ..., "max_symbols": ..., "min_seconds": ...},
+    //       "tolerance": {"items_per_second": 0.35, "p99_seconds": 1.0, "peak_memory_mb": 0.25},
+    //       "allowance": {"peak_memory_mb": 2.0},
+    //       "results": [{"name": ..., "items_per_second": ..., "p99_seconds": ..., "peak_memory_mb": ...}, ...]}
+    //
+    // Each tolerance is the fraction a result may be worse than its baseline by: lower throughput, or higher p99
+    // run time or peak memory. A result can carry its own "tolerance" object to loosen or tighten them for itself.
+    // A metric past its tolerance only regresses when it is also worse by more than its allowance, an amount in the
+    // metric's own units, so that scenarios which allocate next to nothing do not fail on the odd page the allocator
+    // keeps. Results can carry their own "allowance" too, e.g. where how far a background writer falls behind
+    // depends on how the threads were scheduled.
+    //
+    // Replaces the filter, symbol count and run time of the config with the ones the baseline was recorded with, so
+    // the same scenarios are run
+    void read_baseline_config(Config& config);
+    // Prints the comparison of every result against the baseline, returning false if any crossed its tolerance or
+    // a baseline scenario was not run
+    bool check_baseline(const Config& config, const std::vector<Result>& results, std::ostream& out);
+    // Records the results as the new baseline, keeping the tolerances and allowances of the old one if there was one
+    void write_baseline(const Config& config, const std::vector<Result>& results);
+}
+
+// Defines and registers a benchmark function
+#define BENCHMARK(name) \
+    static void bench_##name(bench::Runner& runner); \
+    static const int bench_registered_##name = bench::add(#name, &bench_##name); \
+    static void bench_##name(bench::Runner& runner)
+
+#endif //BACKTESTER_BENCHMARK_HPP
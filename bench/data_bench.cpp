@@ -0,0 +1,151 @@
+// Include the harness
+#include "benchmark.hpp"
+// Custom class includes
+#include "data.hpp"
+#include "daterules.hpp"
+#include "pipeline.hpp"
+
+// Benchmarks of the data side: generating the synthetic market onto the HEAP, merging pulled history into its events,
+// windowed history() and history_panel() calls into it, daily pipeline screens over them, and building schedules
+// from the date rules.
+
+namespace {
+    const BloombergLP::blpapi::Datetime START(2017, 1, 3, 0, 0, 0);
+    const BloombergLP::blpapi::Datetime END(2018, 1, 2, 0, 0, 0);
+    // A week of minute bars
+    const BloombergLP::blpapi::Datetime MINUTE_START(2017, 3, 6, 0, 0, 0);
+    const BloombergLP::blpapi::Datetime MINUTE_END(2017, 3, 11, 0, 0, 0);
+}
+
+// Generates a year of daily closes and a week of minute bars for each number of symbols, and builds their MarketEvents
+BENCHMARK(synthetic_fill_history) {
+    for (bool minute : {false, true}) {
+        SyntheticMarket market;
+        market.bar_minutes = minute ? 1 : 0;
+        market.warmup_days = 0;
+        const BloombergLP::blpapi::Datetime& start = minute ? MINUTE_START : START;
+        const BloombergLP::blpapi::Datetime& end = minute ? MINUTE_END : END;
+        for (size_t count : runner.symbol_counts()) {
+            const std::vector<std::string> symbols = bench::symbols(count);
+            BloombergLP::blpapi::Datetime current_time = start;
+            SyntheticDataManager data(&current_time, market);
+            std::list<std::unique_ptr<events::Event>> heap;
+            data.fillHistory(symbols, start, end, &heap);
+            const size_t bars = data.size();
+            const std::string name = std::string("synthetic_fill_history/") + (minute ? "minute/" : "daily/") +
+                    std::to_string(count);
+            runner.measure(name, bars * count, [&]() {
+                data.fillHistory(symbols, start, end, &heap);
+            }, [&]() { heap.clear(); });
+        }
+    }
+}
+
+// Merges a year of daily closes into MarketEvents as HistoricalDataManager::fillHistory does, with the symbols
+// listing one after another through the first half of the year
+BENCHMARK(merge_market_events) {
+    for (size_t count : runner.symbol_counts()) {
+        const std::vector<std::string> symbols = bench::symbols(count);
+        BloombergLP::blpapi::Datetime current_time = END;
+        SyntheticDataManager data(&current_time);
+        std::list<std::unique_ptr<events::Event>> heap;
+        data.fillHistory(symbols, START, END, &heap);
+        heap.clear();
+        // A copy of the shared history, so the listings can be cut out of it
+        std::unordered_map<std::string, SymbolHistoricalData> history =
+                *data.history(symbols, {"PX_LAST"}, 365, "DAILY");
+        size_t bars = 0;
+        for (size_t j = 0; j < count; ++j) {
+            auto& symbol = history.at(symbols[j]).data;
+            auto listing = symbol.begin();
+            std::advance(listing, std::min(symbol.size(), j * symbol.size() / (2 * count)));
+            symbol.erase(symbol.begin(), listing);
+            bars += symbol.size();
+        }
+        runner.measure("merge_market_events/" + std::to_string(count), bars, [&]() {
+            HistoricalDataManager::merge_market_events(symbols, history, &heap);
+        }, [&]() { heap.clear(); });
+    }
+}
+
+// Asks for 30 days of last prices of every symbol, as a strategy's lookback would, fetching them every time and then
+// again with the memoized result of the first call at the same time
+BENCHMARK(history_window) {
+    for (size_t count : runner.symbol_counts()) {
+        const std::vector<std::string> symbols = bench::symbols(count);
+        BloombergLP::blpapi::Datetime current_time = END;
+        SyntheticDataManager data(&current_time);
+        std::list<std::unique_ptr<events::Event>> heap;
+        data.fillHistory(symbols, START, END, &heap);
+        heap.clear();
+        size_t bars = 0;
+        for (bool memoized : {false, true}) {
+            data.memoize_history(memoized);
+            runner.measure(std::string("history_window/30d/") + (memoized ? "memoized/" : "") + std::to_string(count),
+                           count, [&]() {
+                bars += data.history(symbols, {"PX_LAST"}, 30, "DAILY")->at(symbols[0]).data.size();
+            });
+        }
+    }
+}
+
+// The same 30 days of last prices of every symbol as a dense panel
+BENCHMARK(history_panel) {
+    for (size_t count : runner.symbol_counts()) {
+        const std::vector<std::string> symbols = bench::symbols(count);
+        BloombergLP::blpapi::Datetime current_time = END;
+        SyntheticDataManager data(&current_time);
+        std::list<std::unique_ptr<events::Event>> heap;
+        data.fillHistory(symbols, START, END, &heap);
+        heap.clear();
+        size_t bars = 0;
+        runner.measure("history_panel/30d/" + std::to_string(count), count, [&]() {
+            bars += data.history_panel(symbols, {"PX_LAST"}, 30, "DAILY").times.size();
+        });
+    }
+}
+
+// A typical morning screen (momentum ranked and z-scored, volatility, the spread of the price over its average, and
+// the top tenth by momentum among the less volatile half), on its own over a panel and with the panel drawn for it
+BENCHMARK(pipeline) {
+    for (size_t count : runner.symbol_counts()) {
+        const std::vector<std::string> symbols = bench::symbols(count);
+        BloombergLP::blpapi::Datetime current_time = END;
+        SyntheticDataManager data(&current_time);
+        std::list<std::unique_ptr<events::Event>> heap;
+        data.fillHistory(symbols, START, END, &heap);
+        heap.clear();
+
+        Pipeline pipeline;
+        const Term momentum = pipeline.returns(60);
+        const Term volatility = pipeline.volatility(20);
+        pipeline.column("momentum", pipeline.zscore(momentum));
+        pipeline.column("rank", pipeline.rank(momentum));
+        pipeline.column("volatility", volatility);
+        pipeline.column("spread", pipeline.divide(pipeline.latest(), pipeline.moving_average(50)));
+        pipeline.screen(pipeline.all_of(pipeline.top(momentum, static_cast<unsigned int>(count / 10 + 1)),
+                                        pipeline.less_than(pipeline.rank(volatility), 0.5)));
+        const Panel panel = data.history_panel(symbols, pipeline.fields(), 120, "DAILY");
+        size_t screened = 0;
+        runner.measure("pipeline/panel/" + std::to_string(count), count, [&]() {
+            screened += pipeline.run(panel).size();
+        });
+        runner.measure("pipeline/history/" + std::to_string(count), count, [&]() {
+            screened += pipeline.run(data, symbols).size();
+        });
+    }
+}
+
+// Builds ten years of market open times, and a year of every trading minute
+BENCHMARK(date_rules) {
+    const DateRules rules(BloombergLP::blpapi::Datetime(2008, 1, 2, 0, 0, 0), END);
+    size_t dates = rules.every_day().get_date_times(TimeRules::market_open()).size();
+    runner.measure("date_rules/every_day/10y", dates, [&]() {
+        dates = rules.every_day().get_date_times(TimeRules::market_open()).size();
+    });
+    const DateRules year(START, END);
+    size_t minutes = year.every_day().get_date_times(TimeRules::every_minute()).size();
+    runner.measure("date_rules/every_minute/1y", minutes, [&]() {
+        minutes = year.every_day().get_date_times(TimeRules::every_minute()).size();
+    });
+}
@@ -0,0 +1,115 @@
+// Include the harness
+#include "benchmark.hpp"
+// Custom class includes
+#include "events.hpp"
+#include "data.hpp"
+#include "portfolio.hpp"
+#include "execution.hpp"
+
+// Benchmarks of the pieces of the event loop: moving events through the HEAP and STACK, updating and valuing the
+// portfolio, and turning signals into orders and fills.
+
+namespace {
+    const BloombergLP::blpapi::Datetime START(2017, 1, 3, 16, 0, 0);
+    const BloombergLP::blpapi::Datetime END(2018, 1, 2, 16, 0, 0);
+
+    // One MarketEvent per bar of a synthetic year of daily closes
+    std::vector<std::unique_ptr<events::MarketEvent>> market_events(const std::vector<std::string>& symbols) {
+        BloombergLP::blpapi::Datetime current_time = START;
+        SyntheticMarket no_warmup;
+        no_warmup.warmup_days = 0;
+        SyntheticDataManager data(&current_time, no_warmup);
+        std::list<std::unique_ptr<events::Event>> heap;
+        data.fillHistory(symbols, START, END, &heap);
+        std::vector<std::unique_ptr<events::MarketEvent>> market;
+        for (auto& event : heap) {
+            market.emplace_back(dynamic_cast<events::MarketEvent*>(event.release()));
+        }
+        return market;
+    }
+}
+
+// Takes events off the HEAP, dispatches on their type and passes each through the STACK, as the run loop does
+BENCHMARK(event_queue) {
+    const size_t num_events = 100000;
+    std::list<std::unique_ptr<events::Event>> heap;
+    std::queue<std::unique_ptr<events::Event>> stack;
+    unsigned long dispatched = 0;
+    runner.measure("event_queue/100000", num_events, [&]() {
+        while (!heap.empty()) {
+            std::unique_ptr<events::Event> event = std::move(heap.front());
+            heap.pop_front();
+            if (event->type == "SIGNAL") { stack.push(std::move(event)); }
+            while (!stack.empty()) {
+                dispatched += stack.front()->type == "SIGNAL";
+                stack.pop();
+            }
+        }
+    }, [&]() {
+        for (size_t i = 0; i < num_events; ++i) {
+            heap.emplace_back(std::make_unique<events::SignalEvent>("SYN00000 US EQUITY", 0.5, START));
+        }
+    });
+}
+
+// Marks the portfolio to market on every bar of a year, for each number of symbols
+BENCHMARK(portfolio_update_market) {
+    for (size_t count : runner.symbol_counts()) {
+        const std::vector<std::string> symbols = bench::symbols(count);
+        const std::vector<std::unique_ptr<events::MarketEvent>> market = market_events(symbols);
+        std::unique_ptr<Portfolio> portfolio;
+        runner.measure("portfolio_update_market/" + std::to_string(count), market.size() * count, [&]() {
+            for (const auto& event : market) { portfolio->update_market(*event); }
+        }, [&]() {
+            portfolio = std::make_unique<Portfolio>(symbols, 1000000, START);
+        });
+    }
+}
+
+// Fills an order in every symbol
+BENCHMARK(portfolio_update_fill) {
+    for (size_t count : runner.symbol_counts()) {
+        const std::vector<std::string> symbols = bench::symbols(count);
+        std::vector<events::FillEvent> fills;
+        for (const std::string& symbol : symbols) { fills.emplace_back(symbol, 10, 1000.0, 1.0, 1.0, START); }
+        std::unique_ptr<Portfolio> portfolio;
+        runner.measure("portfolio_update_fill/" + std::to_string(count), count, [&]() {
+            for (const events::FillEvent& fill : fills) { portfolio->update_fill(fill); }
+        }, [&]() {
+            portfolio = std::make_unique<Portfolio>(symbols, 1000000, START);
+        });
+    }
+}
+
+// Sends a signal for an equal weight of every symbol and processes the orders and fills it leads to
+BENCHMARK(execution_signal_order_fill) {
+    for (size_t count : runner.symbol_counts()) {
+        const std::vector<std::string> symbols = bench::symbols(count);
+        BloombergLP::blpapi::Datetime current_time = END;
+        auto data = std::make_shared<SyntheticDataManager>(&current_time);
+        std::list<std::unique_ptr<events::Event>> heap;
+        data->fillHistory(symbols, START, END, &heap);
+        heap.clear();
+        std::queue<std::unique_ptr<events::Event>> stack;
+        std::unique_ptr<Portfolio> portfolio;
+        std::unique_ptr<ExecutionHandler> execution;
+
+        runner.measure("execution_signal_order_fill/" + std::to_string(count), count, [&]() {
+            for (const std::string& symbol : symbols) {
+                execution->process_signal(events::SignalEvent(symbol, 1.0 / count, current_time));
+                while (!stack.empty()) {
+                    std::unique_ptr<events::Event> event = std::move(stack.front());
+                    stack.pop();
+                    if (event->type == "ORDER") {
+                        execution->process_order(*dynamic_cast<events::OrderEvent*>(event.get()));
+                    } else if (event->type == "FILL") {
+                        portfolio->update_fill(*dynamic_cast<events::FillEvent*>(event.get()));
+                    }
+                }
+            }
+        }, [&]() {
+            portfolio = std::make_unique<Portfolio>(symbols, 1000000, START);
+            execution = std::make_unique<ExecutionHandler>(&stack, &heap, data, portfolio.get());
+        });
+    }
+}
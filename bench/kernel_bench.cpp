@@ -0,0 +1,76 @@
+// Include the harness
+#include "benchmark.hpp"
+// STL includes
+#include <cmath>
+#include <random>
+// Custom class includes
+#include "kernels.hpp"
+
+// Benchmarks of the cross-sectional kernels with each instruction set the processor has, on the work a strategy
+// would do every minute: moving the rolling window on by a bar, reading its statistics, and ranking and scoring
+// the universe.
+
+namespace {
+    // A day of random-walk minute prices for each symbol, as rows of one price per symbol
+    std::vector<double> minute_rows(size_t symbols, size_t minutes) {
+        std::mt19937_64 generator(42);
+        std::normal_distribution<double> step(0, 0.001);
+        std::vector<double> rows(symbols * minutes);
+        for (size_t i = 0; i < symbols; ++i) { rows[i] = 50 + static_cast<double>(i % 100); }
+        for (size_t minute = 1; minute < minutes; ++minute) {
+            for (size_t i = 0; i < symbols; ++i) {
+                rows[minute * symbols + i] = rows[(minute - 1) * symbols + i] * std::exp(step(generator));
+            }
+        }
+        return rows;
+    }
+
+    // The instruction sets to compare, which are the scalar loops and AVX2 if the processor has it
+    std::vector<kernels::Isa> instruction_sets() {
+        std::vector<kernels::Isa> sets = {kernels::SCALAR};
+        if (kernels::use_isa(kernels::AVX2) == kernels::AVX2) { sets.push_back(kernels::AVX2); }
+        return sets;
+    }
+}
+
+// Moves a 30 minute window on by every bar of a day and reads its mean, variance and slope after each
+BENCHMARK(kernel_rolling_panel) {
+    const size_t minutes = 390;
+    for (kernels::Isa isa : instruction_sets()) {
+        kernels::use_isa(isa);
+        for (size_t count : runner.symbol_counts()) {
+            const std::vector<double> rows = minute_rows(count, minutes);
+            std::vector<double> mean(count), variance(count), slope(count);
+            runner.measure(std::string("kernel_rolling_panel/") + kernels::isa_name(isa) + "/" + std::to_string(count),
+                           minutes * count, [&]() {
+                kernels::RollingPanel panel(count, 30);
+                for (size_t minute = 0; minute < minutes; ++minute) {
+                    panel.update(rows.data() + minute * count);
+                    panel.mean(mean.data());
+                    panel.variance(variance.data());
+                    panel.slope(slope.data());
+                }
+            });
+        }
+    }
+    kernels::use_isa(kernels::AVX2);
+}
+
+// Z-scores, ranks and winsorizes one value per symbol
+BENCHMARK(kernel_cross_section) {
+    for (kernels::Isa isa : instruction_sets()) {
+        kernels::use_isa(isa);
+        for (size_t count : runner.symbol_counts()) {
+            const std::vector<double> rows = minute_rows(count, 2);
+            std::vector<double> returns(count), scores(count), ranks(count), clamped(count);
+            for (size_t i = 0; i < count; ++i) { returns[i] = rows[count + i] / rows[i] - 1; }
+            runner.measure(std::string("kernel_cross_section/") + kernels::isa_name(isa) + "/" + std::to_string(count),
+                           count, [&]() {
+                kernels::zscore(returns.data(), scores.data(), count);
+                kernels::winsorize(scores.data(), clamped.data(), count, 0.01, 0.99);
+                kernels::rank(returns.data(), ranks.data(), count);
+            });
+        }
+    }
+    kernels::use_isa(kernels::AVX2);
+}
@@ -0,0 +1,124 @@
+// Include the harness
+#include "benchmark.hpp"
+// STL includes
+#include <fstream>
+#include <iomanip>
+#include <unordered_map>
+// JSON includes
+#include <nlohmann/json.hpp>
+
+namespace bench {
+
+namespace {
+    // Tolerances used when a baseline does not give its own
+    const nlohmann::json DEFAULT_TOLERANCE = {{"items_per_second", 0.35},
+                                              {"p99_seconds", 1.0},
+                                              {"peak_memory_mb", 0.25}};
+    // Absolute allowances used when a baseline does not give its own, in each metric's units
+    const nlohmann::json DEFAULT_ALLOWANCE = {{"peak_memory_mb", 2.0}};
+
+    // Reads the whole baseline file
+    nlohmann::json load(const std::string& filepath) {
+        std::ifstream file(filepath);
+        if (!file.is_open()) { throw std::runtime_error("Could not open baseline " + filepath + "!"); }
+        nlohmann::json baseline;
+        file >> baseline;
+        return baseline;
+    }
+}
+
+// Takes the scenario from the baseline's config
+void read_baseline_config(Config &config) {
+    const nlohmann::json recorded = load(config.baseline).at("config");
+    config.filter = recorded.at("filter").get<std::string>();
+    config.max_symbols = recorded.at("max_symbols").get<size_t>();
+    config.min_seconds = recorded.at("min_seconds").get<double>();
+}
+
+// Compares each metric of each baseline result against the run, printing a row per metric and marking those past
+// their tolerance
+bool check_baseline(const Config &config, const std::vector<Result> &results, std::ostream &out) {
+    const nlohmann::json baseline = load(config.baseline);
+    const nlohmann::json tolerance = baseline.value("tolerance", DEFAULT_TOLERANCE);
+    const nlohmann::json allowance = baseline.value("allowance", DEFAULT_ALLOWANCE);
+    std::unordered_map<std::string, const Result*> by_name;
+    for (const Result& result : results) { by_name[result.name] = &result; }
+
+    bool passed = true;
+    out << "\nComparing against " << config.baseline << "\n"
+        << std::left << std::setw(48) << "Benchmark" << std::setw(18) << "metric" << std::right
+        << std::setw(14) << "baseline" << std::setw(14) << "current" << std::setw(10) << "change" << "\n";
+    for (const nlohmann::json& expected : baseline.at("results")) {
+        const std::string name = expected.at("name").get<std::string>();
+        auto found = by_name.find(name);
+        if (found == by_name.end()) {
+            out << std::left << std::setw(48) << name << "MISSING: scenario was not run\n";
+            passed = false;
+            continue;
+        }
+        // Throughput regresses by going down, run time and memory by going up
+        const std::vector<std::pair<const char*, double>> metrics = {
+                {"items_per_second", found->second->items_per_second},
+                {"p99_seconds", found->second->p99_seconds},
+                {"peak_memory_mb", found->second->peak_memory_mb}};
+        for (const auto& metric : metrics) {
+            if (!expected.count(metric.first)) { continue; }
+            const double before = expected.at(metric.first).get<double>();
+            const double after = metric.second;
+            const double change = before != 0 ? (after - before) / before : 0;
+            const double allowed = expected.value("tolerance", tolerance).value(
+                    metric.first, tolerance.value(metric.first, DEFAULT_TOLERANCE.at(metric.first).get<double>()));
+            const bool higher_is_better = std::string(metric.first) == "items_per_second";
+            const double worse_by = higher_is_better ? before - after : after - before;
+            const double slack = expected.value("allowance", allowance).value(
+                    metric.first, allowance.value(metric.first, 0.0));
+            const bool regressed = (higher_is_better ? change < -allowed : change > allowed) && worse_by > slack;
+            out << std::left << std::setw(48) << name << std::setw(18) << metric.first << std::right
+                << std::setw(14) << std::setprecision(6) << std::defaultfloat << before
+                << std::setw(14) << after
+                << std::setw(9) << std::fixed << std::setprecision(1) << change * 100 << "%"
+                << (regressed ? "  REGRESSED (allowed " + std::to_string(static_cast<int>(allowed * 100)) + "%)" : "")
+                << "\n";
+            passed = passed && !regressed;
+        }
+    }
+    out << (passed ? "No performance regressions." : "Performance regressed past the baseline!") << std::endl;
+    return passed;
+}
+
+// Overwrites the baseline with the config and results of this run, keeping the old tolerances and allowances
+void write_baseline(const Config &config, const std::vector<Result> &results) {
+    nlohmann::json tolerance = DEFAULT_TOLERANCE;
+    nlohmann::json allowance = DEFAULT_ALLOWANCE;
+    std::unordered_map<std::string, nlohmann::json> overrides;
+    try {
+        const nlohmann::json previous = load(config.baseline);
+        tolerance = previous.value("tolerance", DEFAULT_TOLERANCE);
+        allowance = previous.value("allowance", DEFAULT_ALLOWANCE);
+        for (const nlohmann::json& result : previous.at("results")) {
+            for (const char* key : {"tolerance", "allowance"}) {
+                if (result.count(key)) { overrides[result.at("name").get<std::string>()][key] = result.at(key); }
+            }
+        }
+    } catch (const std::exception&) {}
+
+    nlohmann::json baseline;
+    baseline["config"] = {{"filter", config.filter},
+                          {"max_symbols", config.max_symbols},
+                          {"min_seconds", config.min_seconds}};
+    baseline["tolerance"] = tolerance;
+    baseline["allowance"] = allowance;
+    baseline["results"] = nlohmann::json::array();
+    for (const Result& result : results) {
+        baseline["results"].push_back({{"name", result.name},
+                                       {"items_per_second", result.items_per_second},
+                                       {"p99_seconds", result.p99_seconds},
+                                       {"peak_memory_mb", result.peak_memory_mb}});
+        if (overrides.count(result.name)) { baseline["results"].back().update(overrides.at(result.name)); }
+    }
+    std::ofstream file(config.baseline, std::ios_base::out | std::ios_base::trunc);
+    if (!file.is_open()) { throw std::runtime_error("Could not open baseline " + config.baseline + "!"); }
+    file << std::setw(4) << baseline << std::endl;
+}
+
+}
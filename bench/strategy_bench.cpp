@@ -0,0 +1,192 @@
+// Include the harness
+#include "benchmark.hpp"
+// Custom class includes
+#include "strategy.hpp"
+#include "strategyhost.hpp"
+#include "vectorized.hpp"
+// STL includes
+#include <thread>
+
+// End to end benchmarks: whole backtests of a rebalancing strategy over a synthetic market, from the first event on
+// the HEAP to the last, the same strategy many times over one market, and the same rebalances run through the
+// vectorized engine.
+
+namespace {
+    // Rebalances into an equal weight of a rotating basket of up to twenty symbols every day at the open, so every
+    // day has signals, orders and fills on top of the market events. Batched, the whole day is one rebalance.
+    class RebalanceBench : public Strategy {
+    public:
+        RebalanceBench(const std::vector<std::string>& symbols, const BloombergLP::blpapi::Datetime& start,
+                       const BloombergLP::blpapi::Datetime& end, const SyntheticMarket& market,
+                       bool p_batched = false) :
+                Strategy(symbols, 1000000, start, end, market), batched(p_batched) { schedule(); }
+        // Built on a host's data manager instead
+        RebalanceBench(const std::vector<std::string>& symbols, const BloombergLP::blpapi::Datetime& start,
+                       const BloombergLP::blpapi::Datetime& end, std::shared_ptr<DataManager> shared_data) :
+                Strategy(symbols, 1000000, start, end, std::move(shared_data)), batched(true) { schedule(); }
+
+        void schedule() {
+            schedule_function([](Strategy* x)->void {
+                auto b = dynamic_cast<RebalanceBench*>(x);
+                if (b) b->rebalance();
+            }, date_rules.every_day(), TimeRules::market_open(0, 1));
+        }
+
+        void rebalance() {
+            const size_t basket = std::min<size_t>(20, symbol_list.size());
+            std::unordered_map<std::string, double> targets;
+            for (size_t i = 0; i < basket; ++i) {
+                if (batched) { targets[symbol_list[(day + i) % symbol_list.size()]] = 0; }
+                else { order_target_percent(symbol_list[(day + i) % symbol_list.size()], 0); }
+            }
+            day += basket / 2;
+            for (size_t i = 0; i < basket; ++i) {
+                if (batched) { targets[symbol_list[(day + i) % symbol_list.size()]] = 1.0 / basket; }
+                else { order_target_percent(symbol_list[(day + i) % symbol_list.size()], 1.0 / basket); }
+            }
+            if (batched) { order_target_percents(targets); }
+        }
+
+        // The number of bars waiting on the HEAP
+        size_t bars() const {
+            size_t count = 0;
+            for (const auto& event : heap_eventlist) { count += event->type == "MARKET"; }
+            return count;
+        }
+
+    private:
+        const bool batched;
+        size_t day = 0;
+    };
+}
+
+// Runs a year of daily closes and a week of minute bars for each number of symbols. The strategy is rebuilt, and so
+// its market regenerated, untimed before every run.
+BENCHMARK(strategy_run) {
+    for (bool minute : {false, true}) {
+        SyntheticMarket market;
+        market.bar_minutes = minute ? 1 : 0;
+        // Enough warmup for the execution handler's pricing lookback, without a year of minute bars
+        market.warmup_days = minute ? 7 : 30;
+        const BloombergLP::blpapi::Datetime start = minute ? BloombergLP::blpapi::Datetime(2017, 3, 6, 0, 0, 0) :
+                                                    BloombergLP::blpapi::Datetime(2017, 1, 3, 0, 0, 0);
+        const BloombergLP::blpapi::Datetime end = minute ? BloombergLP::blpapi::Datetime(2017, 3, 11, 0, 0, 0) :
+                                                  BloombergLP::blpapi::Datetime(2018, 1, 2, 0, 0, 0);
+        for (size_t count : runner.symbol_counts()) {
+            const std::vector<std::string> symbols = bench::symbols(count);
+            std::unique_ptr<RebalanceBench> strategy;
+            auto setup = [&]() {
+                strategy.reset();
+                strategy = std::make_unique<RebalanceBench>(symbols, start, end, market);
+            };
+            setup();
+            // Items are the price updates processed, one per symbol per bar
+            const size_t bars = strategy->bars();
+            runner.measure(std::string("strategy_run/") + (minute ? "minute/" : "daily/") + std::to_string(count),
+                           bars * count, [&]() { strategy->run(); }, setup);
+        }
+    }
+}
+
+// The daily strategy_run, with each day's rebalance ordered as one batch
+BENCHMARK(strategy_run_batched) {
+    SyntheticMarket market;
+    market.warmup_days = 30;
+    const BloombergLP::blpapi::Datetime start(2017, 1, 3, 0, 0, 0), end(2018, 1, 2, 0, 0, 0);
+    for (size_t count : runner.symbol_counts()) {
+        const std::vector<std::string> symbols = bench::symbols(count);
+        std::unique_ptr<RebalanceBench> strategy;
+        auto setup = [&]() {
+            strategy.reset();
+            strategy = std::make_unique<RebalanceBench>(symbols, start, end, market, true);
+        };
+        setup();
+        const size_t bars = strategy->bars();
+        runner.measure("strategy_run_batched/daily/" + std::to_string(count), bars * count,
+                       [&]() { strategy->run(); }, setup);
+    }
+}
+
+// Twenty batched daily strategy_runs, each built and run as a backtest of its own, then all run by one host over a
+// single market, on one thread and on every core. The market and the strategies are built inside the timing here,
+// as building them is most of what the host saves. Twenty runs over a thousand symbols take too long to repeat, so
+// the universes stop at a hundred.
+BENCHMARK(strategy_host) {
+    const size_t strategies = 20;
+    SyntheticMarket market;
+    market.warmup_days = 30;
+    const BloombergLP::blpapi::Datetime start(2017, 1, 3, 0, 0, 0), end(2018, 1, 2, 0, 0, 0);
+    std::vector<unsigned int> thread_counts = {1};
+    if (std::thread::hardware_concurrency() > 1) { thread_counts.push_back(std::thread::hardware_concurrency()); }
+    for (size_t count : runner.symbol_counts()) {
+        if (count > 100) { continue; }
+        const std::vector<std::string> symbols = bench::symbols(count);
+        const size_t bars = RebalanceBench(symbols, start, end, market, true).bars();
+        runner.measure("strategy_host/separate/" + std::to_string(count), bars * count * strategies, [&]() {
+            for (size_t i = 0; i < strategies; ++i) { RebalanceBench(symbols, start, end, market, true).run(); }
+        });
+        for (unsigned int threads : thread_counts) {
+            runner.measure("strategy_host/hosted/" + std::to_string(threads) + "t/" + std::to_string(count),
+                           bars * count * strategies, [&]() {
+                StrategyHost host(symbols, start, end, market);
+                for (size_t i = 0; i < strategies; ++i) {
+                    host.add(std::make_unique<RebalanceBench>(symbols, start, end, host.data()));
+                }
+                host.run(threads);
+            });
+        }
+    }
+}
+
+// The batched daily strategy_run on its own, compared against three symbols it does not trade in the same run, and
+// followed by a run holding each of the three, as the comparison was made before the overlay. The strategies are
+// built inside the timing, as pulling the benchmarks' prices is part of the overlay's cost.
+BENCHMARK(benchmark_overlay) {
+    SyntheticMarket market;
+    market.warmup_days = 30;
+    const BloombergLP::blpapi::Datetime start(2017, 1, 3, 0, 0, 0), end(2018, 1, 2, 0, 0, 0);
+    const std::vector<std::string> benchmarks = {"BENCH0 US EQUITY", "BENCH1 US EQUITY", "BENCH2 US EQUITY"};
+    for (size_t count : runner.symbol_counts()) {
+        if (count > 100) { continue; }
+        const std::vector<std::string> symbols = bench::symbols(count);
+        const size_t bars = RebalanceBench(symbols, start, end, market, true).bars();
+        runner.measure("benchmark_overlay/none/" + std::to_string(count), bars * count, [&]() {
+            RebalanceBench(symbols, start, end, market, true).run();
+        });
+        runner.measure("benchmark_overlay/overlay/" + std::to_string(count), bars * count, [&]() {
+            RebalanceBench strategy(symbols, start, end, market, true);
+            for (const std::string& benchmark : benchmarks) { strategy.compare_to(benchmark); }
+            strategy.run();
+        });
+        runner.measure("benchmark_overlay/separate/" + std::to_string(count), bars * count, [&]() {
+            RebalanceBench(symbols, start, end, market, true).run();
+            for (const std::string& benchmark : benchmarks) { RebalanceBench({benchmark}, start, end, market).run(); }
+        });
+    }
+}
+
+// The daily strategy_run rebalances, as target weights for the vectorized engine. The prices are built untimed.
+BENCHMARK(vectorized_run) {
+    SyntheticMarket market;
+    market.warmup_days = 30;
+    const BloombergLP::blpapi::Datetime start(2017, 1, 3, 0, 0, 0), end(2018, 1, 2, 0, 0, 0);
+    for (size_t count : runner.symbol_counts()) {
+        const std::vector<std::string> symbols = bench::symbols(count);
+        BloombergLP::blpapi::Datetime current_time = start;
+        SyntheticDataManager data(&current_time, market);
+        std::list<std::unique_ptr<events::Event>> heap;
+        data.fillHistory(symbols, start, end, &heap);
+        const VectorizedBacktest backtest(PriceMatrix::from_events(symbols, heap), 1000000);
+
+        const size_t basket = std::min<size_t>(20, count);
+        runner.measure("vectorized_run/daily/" + std::to_string(count), backtest.prices().times.size() * count, [&]() {
+            size_t day = 0;
+            backtest.run([&](size_t, const PriceMatrix&, double* weights) {
+                for (size_t i = 0; i < basket; ++i) { weights[(day + i) % count] = 0; }
+                day += basket / 2;
+                for (size_t i = 0; i < basket; ++i) { weights[(day + i) % count] = 1.0 / basket; }
+                return true;
+            });
+        });
+    }
+}
@@ -0,0 +1,155 @@
+#ifndef BACKTESTER_ANALYTICS_HPP
+#define BACKTESTER_ANALYTICS_HPP
+// Bloomberg includes
+#include "bloombergincludes.hpp"
+// STL includes
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+// Custom class includes
+#include "events.hpp"
+#include "checkpoint.hpp"
+
+// Performance statistics of a run at one point in time. Ratios and volatilities are annualized.
+struct PerformanceStats {
+    unsigned long periods = 0;
+    double total_return = 0;
+    double annualized_return = 0;
+    double volatility = 0;
+    double sharpe = 0;
+    double sortino = 0;
+    // Largest fall from a peak as a fraction of the peak, and the most periods spent below a previous peak
+    double max_drawdown = 0;
+    unsigned long max_drawdown_periods = 0;
+    double current_drawdown = 0;
+    // Volatility over the last rolling_window periods only
+    double rolling_volatility = 0;
+    // Value traded per year as a multiple of the average equity
+    double turnover = 0;
+    // Average and latest gross exposure (sum of absolute holdings over equity)
+    double exposure = 0;
+    double current_exposure = 0;
+    // Closed trades, and the fraction of them which made money
+    unsigned long trades = 0;
+    double hit_rate = 0;
+    // Against the benchmark, when one was given
+    bool has_benchmark = false;
+    double beta = 0;
+    double alpha = 0;
+    double correlation = 0;
+    double tracking_error = 0;
+    double information_ratio = 0;
+};
+
+// Streaming analytics over the returns of a run. Every update is folded into running moments (Welford's algorithm
+// for the mean and variance of the returns, and the co-moment with the benchmark's returns), running drawdown state,
+// and a fixed window of recent returns for the rolling volatility, so each update takes constant time and nothing is
+// kept of the history. The statistics can be asked for at any point, e.g. live while a strategy runs.
+//
+// Updates are taken as periods of the given length in seconds: an update less than one period after the start of
+// the current one only replaces its closing values. With a length of 0 (the default, for bar data) every update is
+// its own period. periods_per_year annualizes the statistics, so should match: 252 for daily bars, 252 * 390 for
+// minute bars.
+class Analytics {
+public:
+    explicit Analytics(double periods_per_year = 252, unsigned int period_seconds = 0, unsigned int rolling_window = 21,
+                       double risk_free_rate = 0);
+
+    // Changes how periods are counted and annualized, before the first update
+    void set_periods(double periods_per_year, unsigned int period_seconds = 0);
+
+    // Takes the equity, the gross value of the positions, and optionally the level of the benchmark at a time
+    void update(const BloombergLP::blpapi::Datetime& time, double equity, double gross_exposure,
+                double benchmark = std::numeric_limits<double>::quiet_NaN());
+    // Takes a fill into the turnover, and into the hit rate when it reduces a position
+    void update_fill(const events::FillEvent& fill);
+
+    // The statistics as of the last update
+    PerformanceStats stats() const;
+    // Prints the statistics
+    void report(std::ostream& out) const;
+
+    // Write and read the running state into a checkpoint, so a resumed run carries on the same statistics
+    void write_checkpoint(checkpoint::Writer& writer) const;
+    void read_checkpoint(checkpoint::Reader& reader);
+
+private:
+    // Folds the return of a finished period into the running statistics
+    void add_period(double portfolio_return, double benchmark_return);
+
+    double periods_per_year;
+    unsigned int period_seconds;
+    const unsigned int rolling_window;
+    const double risk_free_rate;
+
+    // The period being built, and the closing values of the one before it
+    bool started = false;
+    long long period_start = 0;
+    double open_equity = 0, close_equity = 0, start_equity = 0;
+    double open_benchmark = 0, close_benchmark = 0;
+    double gross = 0;
+
+    // Running moments of the returns (count, mean, sum of squared deviations, and of squared downside returns)
+    unsigned long periods = 0;
+    double mean = 0, m2 = 0, downside = 0;
+    // Running moments of the benchmark returns and their co-moment with the portfolio's
+    unsigned long benchmark_periods = 0;
+    double benchmark_mean = 0, benchmark_m2 = 0, comoment = 0, portfolio_mean = 0, portfolio_m2 = 0;
+    double active_mean = 0, active_m2 = 0;
+    // Drawdown state
+    double peak = 0, max_drawdown = 0;
+    unsigned long drawdown_periods = 0, max_drawdown_periods = 0;
+    // The most recent returns, as a ring with their running sums
+    std::vector<double> window;
+    size_t window_next = 0;
+    double window_sum = 0, window_sum_squares = 0;
+    // Running sums of exposure and equity, and the value traded
+    double exposure_sum = 0, equity_sum = 0, traded = 0;
+    // Quantity and average cost of each position for finding when a trade is closed, and the closed trades
+    std::unordered_map<std::string, std::pair<int, double>> positions;
+    unsigned long trades = 0, winning_trades = 0;
+};
+
+// A benchmark a strategy is compared against while it runs, without trading it. Its level at each market event is
+// the symbol's price in the event when the strategy trades the symbol, and otherwise the latest price at or before
+// the event in a series pulled once before the run, walked forward with a cursor so that no later price is ever
+// seen and each event costs amortized constant time. Statistics against the benchmark are kept in analytics of its
+// own, which start out as a copy of the strategy's so they count periods the same way.
+class BenchmarkOverlay {
+public:
+    // A benchmark priced by the market events
+    explicit BenchmarkOverlay(std::string symbol);
+    // A benchmark priced by the series of times and prices, in time order
+    BenchmarkOverlay(std::string symbol, std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> series);
+
+    const std::string& symbol() const { return benchmark_symbol; }
+    // The level as of the event, or NaN if there has been none yet
+    double level(const events::MarketEvent& event);
+    // Takes the strategy's equity and gross exposure at the event, against the benchmark's level, into the
+    // statistics against the benchmark, copying the strategy's analytics into them on the first update
+    void update(const events::MarketEvent& event, double equity, double gross_exposure, const Analytics& strategy);
+    // The statistics against the benchmark as of the last update
+    PerformanceStats stats() const;
+
+    // Write and read the latest level and the statistics into a checkpoint. The series is pulled again by the
+    // strategy being restored, so only its position is rebuilt, on the next event.
+    void write_checkpoint(checkpoint::Writer& writer) const;
+    void read_checkpoint(checkpoint::Reader& reader, const Analytics& strategy);
+
+private:
+    std::string benchmark_symbol;
+    // Whether the level comes from the market events rather than the series
+    bool from_events;
+    std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> series;
+    // The next point of the series not yet reached, and the latest level
+    size_t next = 0;
+    double latest = std::numeric_limits<double>::quiet_NaN();
+    // The statistics against the benchmark, from the first update on
+    std::unique_ptr<Analytics> analytics;
+};
+
+#endif //BACKTESTER_ANALYTICS_HPP
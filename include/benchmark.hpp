@@ -10,7 +10,8 @@
 #include "strategy.hpp"
 
 // Contains the logic for a simple Benchmark strategy, in which 100% of the strategy will be invested
-// into SPY upon initialization and left to grow over the period of the backtest.
+// into SPY upon initialization and left to grow over the period of the backtest. To measure another strategy against
+// SPY, compare_to("SPY US EQUITY") on that strategy does so in its own run instead.
 class Benchmark : public Strategy {
 public:
     // Constructor initializes the Strategy parent and buys the SPY shares with the same amount of capital
@@ -0,0 +1,176 @@
+#ifndef BACKTESTER_CHECKPOINT_HPP
+#define BACKTESTER_CHECKPOINT_HPP
+// Bloomberg includes
+#include "bloombergincludes.hpp"
+// STL includes
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <queue>
+#include <set>
+#include <type_traits>
+// Custom class includes
+#include "events.hpp"
+
+// Versioned binary snapshots of the engine state, used to resume a backtest mid-run or restart a live strategy after
+// a crash. A checkpoint file is a fixed header (magic, format version, body length) followed by the body, which each
+// component writes its own state into in a fixed order and reads back in the same order. The body always begins
+// with a summary (the fingerprint of the strategy which wrote it and its simulated time) which can be read on its
+// own. The whole file is written with a single write to a temporary file which is then renamed over the old one, so
+// a crash while checkpointing never leaves a half-written snapshot, and is restored with a single read.
+namespace checkpoint {
+    // Identifies checkpoint files, and the version of the body layout. Bump the version whenever the layout changes.
+    const char MAGIC[4] = {'B', 'T', 'C', 'K'};
+    const uint32_t VERSION = 7;
+
+    // Serializes values into an in-memory buffer which is written to disk at once
+    class Writer {
+    public:
+        // Plain numbers are copied in as raw bytes
+        template <class T>
+        void put(T value) {
+            static_assert(std::is_arithmetic<T>::value, "Only numbers can be written as raw bytes!");
+            buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+        // Arrays of plain numbers are copied in with a single append
+        template <class T>
+        void put_array(const std::vector<T>& values) {
+            static_assert(std::is_arithmetic<T>::value, "Only numbers can be written as raw bytes!");
+            put<uint64_t>(values.size());
+            buffer.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        }
+        void put(const std::string& value);
+        void put(const BloombergLP::blpapi::Datetime& value);
+
+        // Maps of names to numbers, such as holdings, positions, and the strategy context
+        template <class V>
+        void put(const std::unordered_map<std::string, V>& values) {
+            put<uint64_t>(values.size());
+            for (const auto& value : values) { put(value.first); put(value.second); }
+        }
+        // Histories of name to number maps by date, such as all_holdings, written column by column: first the
+        // dates, then for every name that appears anywhere, whether each date has it and its values
+        template <class V>
+        void put(const std::map<BloombergLP::blpapi::Datetime, std::unordered_map<std::string, V>>& history) {
+            std::set<std::string> names;
+            put<uint64_t>(history.size());
+            for (const auto& row : history) {
+                put(row.first);
+                for (const auto& value : row.second) { names.insert(value.first); }
+            }
+            put<uint64_t>(names.size());
+            for (const std::string& name : names) {
+                std::vector<uint8_t> present;
+                std::vector<V> column;
+                present.reserve(history.size());
+                column.reserve(history.size());
+                for (const auto& row : history) {
+                    auto found = row.second.find(name);
+                    present.push_back(found != row.second.end());
+                    column.push_back(found != row.second.end() ? found->second : V());
+                }
+                put(name);
+                put_array(present);
+                put_array(column);
+            }
+        }
+
+        // Writes the header and buffer to the file with a single write, replacing any previous checkpoint
+        void save(const std::string& filepath) const;
+
+    private:
+        std::string buffer;
+    };
+
+    // Deserializes values from a checkpoint file, which is read into memory in one go. Throws if the file is not a
+    // checkpoint, was written by a different version, or ends early.
+    class Reader {
+    public:
+        explicit Reader(const std::string& filepath);
+
+        template <class T>
+        T get() {
+            static_assert(std::is_arithmetic<T>::value, "Only numbers can be read as raw bytes!");
+            T value;
+            std::memcpy(&value, take(sizeof(T)), sizeof(T));
+            return value;
+        }
+        // Reads the number of items in a sequence whose items each take at least the given number of bytes,
+        // throwing if the rest of the body could not hold that many, so a corrupt count is never allocated for
+        uint64_t get_count(size_t bytes_each);
+        template <class T>
+        std::vector<T> get_array() {
+            static_assert(std::is_arithmetic<T>::value, "Only numbers can be read as raw bytes!");
+            std::vector<T> values(get_count(sizeof(T)));
+            if (!values.empty()) { std::memcpy(values.data(), take(values.size() * sizeof(T)), values.size() * sizeof(T)); }
+            return values;
+        }
+        std::string get_string();
+        BloombergLP::blpapi::Datetime get_datetime();
+
+        template <class V>
+        std::unordered_map<std::string, V> get_map() {
+            std::unordered_map<std::string, V> values;
+            auto size = get_count(sizeof(uint64_t) + sizeof(V));
+            values.reserve(size);
+            for (uint64_t i = 0; i < size; ++i) {
+                std::string name = get_string();
+                values[name] = get<V>();
+            }
+            return values;
+        }
+        template <class V>
+        std::map<BloombergLP::blpapi::Datetime, std::unordered_map<std::string, V>> get_history() {
+            // Read the date column, then scatter each name's column back into the rows
+            std::vector<std::unordered_map<std::string, V>*> rows(get_count(sizeof(uint8_t)));
+            std::map<BloombergLP::blpapi::Datetime, std::unordered_map<std::string, V>> history;
+            for (auto& row : rows) { row = &history[get_datetime()]; }
+            auto names = get<uint64_t>();
+            for (uint64_t i = 0; i < names; ++i) {
+                std::string name = get_string();
+                std::vector<uint8_t> present = get_array<uint8_t>();
+                std::vector<V> column = get_array<V>();
+                if (present.size() != rows.size() || column.size() != rows.size()) {
+                    throw std::runtime_error("Checkpoint history column " + name + " is the wrong length!");
+                }
+                for (size_t row = 0; row < rows.size(); ++row) {
+                    if (present[row]) { (*rows[row])[name] = column[row]; }
+                }
+            }
+            return history;
+        }
+
+    private:
+        // Returns a pointer to the next bytes of the body and moves past them
+        const char* take(size_t bytes);
+
+        std::vector<char> buffer;
+        size_t position = 0;
+    };
+
+    // The summary at the start of every checkpoint body
+    struct Summary {
+        std::string fingerprint;
+        BloombergLP::blpapi::Datetime time;
+    };
+    // Reads only the summary of a checkpoint, e.g. to find where the run it came from stopped
+    Summary read_summary(const std::string& filepath);
+
+    // Rebuilds a ScheduledEvent from the index of its function in the strategy's schedule and its time
+    typedef std::function<std::unique_ptr<events::Event>(uint32_t, const BloombergLP::blpapi::Datetime&)> ScheduleFactory;
+
+    // Writes any event, scheduled functions being written as their schedule index
+    void put_event(Writer& writer, const events::Event& event);
+    // Reads an event written by put_event, using the factory for scheduled functions
+    std::unique_ptr<events::Event> get_event(Reader& reader, const ScheduleFactory& schedule);
+
+    // Writes the STACK and the HEAP, leaving them as they were
+    void put_events(Writer& writer, std::queue<std::unique_ptr<events::Event>>& stack,
+                    const std::list<std::unique_ptr<events::Event>>& heap);
+    // Replaces the STACK and the HEAP with the ones in the checkpoint
+    void get_events(Reader& reader, std::queue<std::unique_ptr<events::Event>>& stack,
+                    std::list<std::unique_ptr<events::Event>>& heap, const ScheduleFactory& schedule);
+}
+
+#endif //BACKTESTER_CHECKPOINT_HPP
@@ -0,0 +1,62 @@
+#ifndef BACKTESTER_CLOCK_HPP
+#define BACKTESTER_CLOCK_HPP
+// Bloomberg includes
+#include "bloombergincludes.hpp"
+// STL includes
+#include <chrono>
+#include <ctime>
+#include <mutex>
+// Custom class includes
+#include "daterules.hpp"
+
+// Source of the current time for the live event loop. The LiveStrategy asks its clock what time it is to decide
+// which events are due, and for the wall-clock deadline to sleep until when waiting for the next event. Swapping
+// the clock lets the same event loop run in real time against Bloomberg or faster than real time against a replay.
+class Clock {
+public:
+    virtual ~Clock() = default;
+    // The current (possibly simulated) time
+    virtual BloombergLP::blpapi::Datetime now() = 0;
+    // The absolute wall-clock time at which this clock will have passed the given time, for timed waits
+    virtual timespec deadline(const BloombergLP::blpapi::Datetime& when) = 0;
+};
+
+// The real clock, which simply reads the local time of the machine (to the millisecond).
+class WallClock : public Clock {
+public:
+    BloombergLP::blpapi::Datetime now() override;
+    timespec deadline(const BloombergLP::blpapi::Datetime& when) override;
+};
+
+// A simulated clock for replaying recorded data. With a speed of 1 it runs at real time from the given start, with a
+// speed of N it runs N times faster, and with a speed of 0 it runs as fast as possible: rather than following the
+// wall clock, the time only moves when the replay advances it to the next tick.
+class ReplayClock : public Clock {
+public:
+    ReplayClock(const BloombergLP::blpapi::Datetime& start, double speed);
+
+    BloombergLP::blpapi::Datetime now() override;
+    timespec deadline(const BloombergLP::blpapi::Datetime& when) override;
+
+    // The point on the steady clock at which the simulated time will be reached (paced modes only)
+    std::chrono::steady_clock::time_point real_time(const BloombergLP::blpapi::Datetime& when) const;
+    // Moves the simulated time forwards to the given time (as fast as possible mode only)
+    void advance(const BloombergLP::blpapi::Datetime& when);
+    // Whether the clock follows the wall clock at some multiple, or jumps with the replay
+    bool paced() const { return speed > 0; }
+
+private:
+    // Milliseconds of simulated time between the start and the given time
+    double millis_since_start(const BloombergLP::blpapi::Datetime& when) const;
+
+    const BloombergLP::blpapi::Datetime start;
+    const double speed;
+    // Wall-clock anchors taken at construction, against which paced time is measured
+    const std::chrono::steady_clock::time_point steady_start;
+    const std::chrono::system_clock::time_point system_start;
+    // The current time when running as fast as possible, written by the replay thread
+    std::mutex mtx;
+    BloombergLP::blpapi::Datetime current;
+};
+
+#endif //BACKTESTER_CLOCK_HPP
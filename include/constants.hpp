@@ -41,6 +41,27 @@ namespace element_names {
     extern const char* SUBCATEGORY;
     extern const char* MESSAGE;
     extern const char* CODE;
+
+    extern const char* BAR_DATA;
+    extern const char* BAR_TICK_DATA;
+    extern const char* BAR_TIME;
+    extern const char* BAR_OPEN;
+    extern const char* BAR_HIGH;
+    extern const char* BAR_LOW;
+    extern const char* BAR_CLOSE;
+    extern const char* BAR_VOLUME;
+}
+
+// Field names for real time subscriptions and the elements they come back as
+namespace realtime_fields {
+    extern const char* LAST_PRICE;
+    extern const char* LAST_TRADE;
+    extern const char* BID;
+    extern const char* ASK;
+    extern const char* BID_SIZE;
+    extern const char* ASK_SIZE;
+    extern const char* VOLUME;
+    extern const char* TIME;
 }
 
 // Names for data in the portfolio
@@ -53,6 +74,14 @@ namespace portfolio_fields {
     extern const char* EQUITY_CURVE;
 }
 
+// Names of the standard result streams written by the result sink
+namespace result_streams {
+    extern const char* EQUITY;
+    extern const char* RETURNS;
+    extern const char* TRADES;
+    extern const char* POSITIONS;
+}
+
 
 // Enums for the date rules specifying types
 namespace date_time_enums {
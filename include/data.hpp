@@ -6,10 +6,14 @@
 #define BACKTESTER_DATA_HPP
 // Include the Bloomberg includes
 #include "bloombergincludes.hpp"
+// STL includes
+#include <future>
+#include <mutex>
 // Custom class includes
 #include "dataretriever.hpp"
 #include "events.hpp"
 #include "daterules.hpp"
+#include "panel.hpp"
 
 // Base class of DataManagers which simply defines the pure virtual function to pull historical data, which
 // will be used by all Data Managers in the future.
@@ -17,17 +21,62 @@ class DataManager {
 public:
     // Constructor initializes currentTime
     explicit DataManager(BloombergLP::blpapi::Datetime* p_currentTime) : currentTime(p_currentTime) {}
+    // Default destructor to allow for polymorphism
+    virtual ~DataManager() = default;
 
     // Pulls history for N time units back from the current date (given to the function) given the parameters.
-    // Simply passes a request to a HistoricalDataRetriever and takes the new data down from Bloomberg.
-    virtual std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> history(
+    // Results are memoized for the current time, so asking again for the same symbols, fields, lookback and
+    // frequency before the clock moves on returns the first result itself rather than fetching or copying it again.
+    // The result is shared and so read-only (read it with at() or find()). Safe to call from several threads at
+    // once, as the strategies sharing a StrategyHost's data manager do: fetches run outside the lock on the memo, and
+    // a request already being fetched by another thread is waited on rather than fetched again.
+    std::shared_ptr<const std::unordered_map<std::string, SymbolHistoricalData>> history(
             const std::vector<std::string>& symbols,
             const std::vector<std::string>& fields,
             unsigned int timeunitsback,
-            const std::string& frequency) = 0;
+            const std::string& frequency);
+
+    // Pulls the same history as a Panel instead: one dense [time x symbol] matrix per field on the dates of all the
+    // symbols, with the gaps forward filled or left as NaN. Built from history() unless the data manager holds its
+    // data in a form it can copy straight into the panel.
+    virtual Panel history_panel(const std::vector<std::string>& symbols,
+                                const std::vector<std::string>& fields,
+                                unsigned int timeunitsback,
+                                const std::string& frequency,
+                                Panel::Gaps gaps = Panel::FORWARD_FILL);
+
+    // Turns the memoization of history() on or off (on by default)
+    void memoize_history(bool enabled);
+
+    // The PX_LAST of the symbol at every bar from start to end, in time order and pulled in one go, for prices read
+    // alongside a run rather than traded, such as a strategy's benchmarks. Call before running.
+    virtual std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> price_series(
+            const std::string& symbol,
+            const BloombergLP::blpapi::Datetime& start,
+            const BloombergLP::blpapi::Datetime& end) = 0;
 protected:
+    // Fetches the history for history() when it has not been memoized. Simply passes a request to a
+    // HistoricalDataRetriever and takes the new data down from Bloomberg, or draws it from data already held.
+    virtual std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> fetch_history(
+            const std::vector<std::string>& symbols,
+            const std::vector<std::string>& fields,
+            unsigned int timeunitsback,
+            const std::string& frequency) = 0;
+    // Forgets the memoized history, for when the data behind it changes without the clock moving
+    void clear_history();
+
     // A reference to the 'current time' simulated by the backtester
     BloombergLP::blpapi::Datetime* currentTime{};
+
+private:
+    // Whether to memoize, the time the memoized results are for, and the results keyed by their request. Each
+    // result is a future, so that one still being fetched can be waited on.
+    bool memoizing = true;
+    BloombergLP::blpapi::Datetime memoized_time;
+    std::unordered_map<std::string, std::shared_future<
+            std::shared_ptr<const std::unordered_map<std::string, SymbolHistoricalData>>>> memoized;
+    // Guards the three members above, and is never held through a fetch
+    std::mutex history_mutex;
 };
 
 // Class for the Historical Data Manager which is the direct link between an algorithm and the Bloomberg API.
@@ -51,6 +100,12 @@ public:
             const BloombergLP::blpapi::Datetime& start,
             const BloombergLP::blpapi::Datetime& end,
             std::list<std::unique_ptr<events::Event>>* location);
+    // Builds fillHistory's MarketEvents from history already pulled: one event at each date any of the symbols has
+    // a PX_LAST, in one merge over the symbols' dates. Each symbol carries its last price forward through the dates
+    // it has none, and is left out of the events before its first price, e.g. while it has yet to list.
+    static void merge_market_events(const std::vector<std::string>& symbols,
+                                    const std::unordered_map<std::string, SymbolHistoricalData>& data,
+                                    std::list<std::unique_ptr<events::Event>>* location);
 
     // Preliminary data pull from Bloomberg API to limit repeated data calls.
     void preload(const std::vector<std::string> &symbols,
@@ -60,18 +115,170 @@ public:
              unsigned int maxlookback,
              const std::string& frequency="DAILY");
 
+    // Takes the daily closes from the preloaded data when it covers the whole range, and otherwise pulls them
+    std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> price_series(
+            const std::string& symbol,
+            const BloombergLP::blpapi::Datetime& start,
+            const BloombergLP::blpapi::Datetime& end) override;
+
+protected:
     // The inherited function override to pull history from Bloomberg API or the preloaded set.
-    std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> history(
+    std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> fetch_history(
             const std::vector<std::string>& symbols,
             const std::vector<std::string>& fields,
             unsigned int timeunitsback,
             const std::string& frequency) override;
 private:
-    // Specifies whether the data is pre-downloaded or not.
+    // Specifies whether the data is pre-downloaded or not, and the last date it was downloaded up to
     bool preloaded = false;
     std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> preloaded_data;
+    BloombergLP::blpapi::Datetime preloaded_end;
     // The Data Retriever module itself used by the history and buildHistory functions to query Bloomberg API
     HistoricalDataRetriever dr;
+    // The retriever's session takes one request at a time, so history fetched from several threads queues here
+    std::mutex dr_mutex;
+};
+
+// Class for the Intraday Data Manager, which backtests against intraday bars (one minute by default) rather than
+// daily closes. Bars are pulled through IntradayBarRequests one trading day at a time, just before the backtest
+// reaches that day, and turned into MarketEvents on the HEAP. Only the day being simulated is held in memory, so
+// a multi-year intraday backtest never materializes its full bar history.
+//
+// Daily history and preloading are inherited from the HistoricalDataManager, but "RECENT" history requests (which
+// the execution handler uses for pricing) are answered with the close of the latest finished bar of the day.
+//
+class IntradayDataManager : public HistoricalDataManager {
+public:
+    // Constructor to build the Intraday Data Manager with the bar length in minutes
+    explicit IntradayDataManager(BloombergLP::blpapi::Datetime* currentTime, unsigned int interval = 1);
+
+    // Sets the symbols and dates to stream bars for. Used instead of fillHistory for intraday backtests.
+    void beginStream(const std::vector<std::string>& symbols,
+                     const BloombergLP::blpapi::Datetime& start,
+                     const BloombergLP::blpapi::Datetime& end);
+
+    // Loads the bars of the following trading days onto the HEAP until its front event falls within a day which has
+    // been loaded, or there are no days left. Should be called whenever the STACK is empty, before taking off the HEAP.
+    void streamBars(std::list<std::unique_ptr<events::Event>>* location);
+
+    // Whether there are still days left to be streamed onto the HEAP
+    bool hasMoreBars() const;
+
+    // The start of the day whose bars were loaded last, if any, which is where a restored stream picks up from
+    bool hasLoadedDay() const { return day_loaded; }
+    const BloombergLP::blpapi::Datetime& loadedDay() const { return loaded_day; }
+    // Restarts a stream from a checkpoint. The HEAP already holds the loaded day's remaining bars, so that day is
+    // only pulled again for the RECENT bars, and streaming continues from the day after.
+    void resumeStream(const std::vector<std::string>& symbols,
+                      const BloombergLP::blpapi::Datetime& loaded_day,
+                      const BloombergLP::blpapi::Datetime& end);
+
+    // Pulls the intraday bars of the symbol, stamped with the time they close as the streamed bars are
+    std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> price_series(
+            const std::string& symbol,
+            const BloombergLP::blpapi::Datetime& start,
+            const BloombergLP::blpapi::Datetime& end) override;
+
+protected:
+    // Answers "RECENT" requests from the bars of the current day, and everything else through daily history.
+    std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> fetch_history(
+            const std::vector<std::string>& symbols,
+            const std::vector<std::string>& fields,
+            unsigned int timeunitsback,
+            const std::string& frequency) override;
+private:
+    // Pulls one day of bars for every symbol and merges them onto the HEAP as MarketEvents, or only keeps them for
+    // RECENT requests when the location is nullptr
+    void loadDay(std::list<std::unique_ptr<events::Event>>* location);
+
+    // The Data Retriever used to pull the bars
+    HistoricalDataRetriever intraday_dr;
+    // The bar length in minutes
+    const unsigned int interval;
+    // The symbols, the start of the next day to be loaded, and the end of the stream
+    std::vector<std::string> stream_symbols;
+    BloombergLP::blpapi::Datetime next_day, stream_end;
+    // The start of the day held in day_bars
+    bool day_loaded = false;
+    BloombergLP::blpapi::Datetime loaded_day;
+    // Bars of the most recently loaded day, keyed by the time each bar closes
+    std::unordered_map<std::string, SymbolHistoricalData> day_bars;
+};
+
+// Parameters of the synthetic market generated by the SyntheticDataManager. Prices follow a geometric Brownian motion
+// with the given annualized drift and volatility, starting near the start price.
+struct SyntheticMarket {
+    // The same seed always generates the same prices for the same symbols
+    uint64_t seed = 42;
+    double start_price = 100;
+    double drift = 0.05;
+    double volatility = 0.2;
+    // The bar length in minutes, or 0 for one bar per trading day at the close
+    unsigned int bar_minutes = 0;
+    // How many calendar days of bars to generate before the start, so history() has something to look back on
+    unsigned int warmup_days = 400;
+};
+
+// Class for the Synthetic Data Manager, which stands in for the Bloomberg-backed data managers with a generated market
+// so backtests can be run (and benchmarked) offline. Every symbol gets bars on the same timeline of trading days (or
+// minutes within them) built from the DateRules, with PX_OPEN, PX_HIGH, PX_LOW, PX_LAST and PX_VOLUME fields. The
+// bars are generated once, stored column by column, and only turned into SymbolHistoricalData for the window a
+// history() call asks for.
+class SyntheticDataManager : public DataManager {
+public:
+    explicit SyntheticDataManager(BloombergLP::blpapi::Datetime* currentTime,
+                                  const SyntheticMarket& market = SyntheticMarket());
+
+    // Generates the bars for the symbols from the warmup before the start up to the end, and puts a MarketEvent of
+    // the last prices onto the HEAP for every bar from the start onwards
+    void fillHistory(const std::vector<std::string>& symbols,
+                     const BloombergLP::blpapi::Datetime& start,
+                     const BloombergLP::blpapi::Datetime& end,
+                     std::list<std::unique_ptr<events::Event>>* location);
+
+    // Copies the window of bars straight from the generated columns into the panel. Every symbol has a bar at every
+    // time, so there are no gaps to fill, and a field which is not generated is NaN throughout.
+    Panel history_panel(const std::vector<std::string>& symbols,
+                        const std::vector<std::string>& fields,
+                        unsigned int timeunitsback,
+                        const std::string& frequency,
+                        Panel::Gaps gaps = Panel::FORWARD_FILL) override;
+
+    // Generates the symbol's closes along the timeline if it was not filled, so must be called after fillHistory
+    std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> price_series(
+            const std::string& symbol,
+            const BloombergLP::blpapi::Datetime& start,
+            const BloombergLP::blpapi::Datetime& end) override;
+
+    // The number of bars generated per symbol
+    size_t size() const { return times.size(); }
+
+protected:
+    // Returns the bars from timeunitsback days before the current time up to it, with only the requested fields
+    std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> fetch_history(
+            const std::vector<std::string>& symbols,
+            const std::vector<std::string>& fields,
+            unsigned int timeunitsback,
+            const std::string& frequency) override;
+
+private:
+    // The generated columns of a symbol, one entry per bar of the timeline
+    struct Columns {
+        std::vector<double> open, high, low, last, volume;
+    };
+    // Generates the columns of one symbol along the timeline
+    Columns generate(const std::string& symbol) const;
+    // The columns of the symbol, throwing if it has none
+    const Columns& columns_of(const std::string& symbol) const;
+    // The column of a field, or nullptr for a field that is not generated
+    static const std::vector<double>* column_of(const Columns& columns, const std::string& field);
+    // The range of bars from timeunitsback days before the current time up to it
+    std::pair<size_t, size_t> window(unsigned int timeunitsback) const;
+
+    const SyntheticMarket market;
+    // The close time of every bar, shared by all symbols
+    std::vector<BloombergLP::blpapi::Datetime> times;
+    std::unordered_map<std::string, Columns> columns;
 };
 
 #endif //BACKTESTER_DATA_HPP
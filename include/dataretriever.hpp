@@ -15,6 +15,7 @@
 #include "constants.hpp"
 #include "events.hpp"
 #include "daterules.hpp"
+#include "clock.hpp"
 
 // Inline function to parse the Bloomberg Historical Data formatted date from a normal Datetime.
 inline std::string get_date_formatted(const BloombergLP::blpapi::Datetime& date) {
@@ -74,6 +75,16 @@ public:
             const std::vector<std::string>& fields = {"PX_LAST"},
             const std::string& frequency = "DAILY");
 
+    // Pulls intraday bars of the given interval (in minutes) for a single security between two local times. The
+    // bars are keyed by their local start time and contain the PX_OPEN, PX_HIGH, PX_LOW, PX_LAST and VOLUME fields.
+    // Only for retrievers of type INTRADAY_DATA.
+    SymbolHistoricalData pullIntradayBars(
+            const std::string& security,
+            const BloombergLP::blpapi::Datetime& start_datetime,
+            const BloombergLP::blpapi::Datetime& end_datetime,
+            unsigned int interval = 1,
+            const std::string& event_type = "TRADE");
+
 private:
     // The correlation ID for requests
     const int correlation_id;
@@ -90,29 +101,103 @@ struct DataHandler {
     bool processExceptionsAndErrors(BloombergLP::blpapi::Message msg);
 };
 
+// Fixed-layout record of the latest real time quote for a symbol. Each record is aligned to a cache line, so
+// reading or updating one symbol's quote only ever touches a single line.
+struct alignas(64) Quote {
+    double last = 0, bid = 0, ask = 0;
+    double bid_size = 0, ask_size = 0, volume = 0;
+    BloombergLP::blpapi::Datetime time = BloombergLP::blpapi::Datetime(1970, 1, 1, 0, 0, 0);
+
+    // Bits naming which fields of an update were actually received, so missing fields keep their previous value
+    static constexpr unsigned LAST = 1u << 0, BID = 1u << 1, ASK = 1u << 2, BID_SIZE = 1u << 3,
+                              ASK_SIZE = 1u << 4, VOLUME = 1u << 5, TIME = 1u << 6;
+
+    // The price to value holdings at: the mid when both sides are quoted, otherwise the last trade
+    double mark() const { return (bid > 0 && ask > 0) ? (bid + ask) / 2 : last; }
+};
+
+// Contiguous array of the latest quotes of every subscribed symbol, indexed in subscription order. Written by the
+// real time data handler and read by the strategy and execution handler, all under the feed mutex.
+struct QuoteBook {
+    // Rebuilds the book for a new set of symbols with empty quotes
+    void reset(const std::vector<std::string>& symbols);
+    // Returns the index of the symbol in the book, or -1 if it is not subscribed
+    long index_of(const std::string& symbol) const;
+
+    std::vector<std::string> symbols;
+    std::vector<Quote> quotes;
+private:
+    std::unordered_map<std::string, size_t> indices;
+};
+
+// Dirty bitset over the quote book used when the live feed is conflating ticks. The quote book already holds only
+// the latest price for each symbol, so a trade just sets the symbol's bit, and a burst of updates between two drains
+// of the feed turns into a single MarketEvent covering every symbol that traded. Not thread safe on its own; the
+// real time data handler and the strategy both access it under the feed mutex.
+struct ConflationBuffer {
+    // Sizes the dirty bitset for the given number of symbols and clears any pending data
+    void reset(size_t num_symbols);
+    // Marks the symbol at the given index as having traded, counting the tick as conflated if the symbol's
+    // previous trade had not been flushed yet
+    void mark(size_t index);
+    // Whether any symbol has traded since the last flush
+    bool empty() const { return pending == 0; }
+    // Builds one MarketEvent from the last prices of all the dirty symbols, stamped with the latest of their
+    // times, and clears them
+    std::unique_ptr<events::MarketEvent> flush(const QuoteBook& book);
+
+    // Total number of ticks which were overwritten before they could be flushed
+    unsigned long conflated = 0;
+private:
+    std::vector<uint64_t> dirty;
+    size_t pending = 0;
+    // When the oldest pending trade was received, which the batched MarketEvent's latency is measured from
+    std::chrono::steady_clock::time_point first_received;
+};
+
 // Class which is linked to the real time data subscription and builds MarketEvents from the subscription data.
 // Needs to be an EventHandler so it can be linked to the session. It will place all the events into SymbolHistoricalData
-// form onto a queue. After each event is processed in the main event loop, the main thread runs a check to see if
-// the queue has any elements. If it does, it locks the mutex and empties the queue by inserting it into the HEAP.
-// The queue is then unlocked and events can continue to flow through.
+// form onto a queue. Whenever it places something onto the queue it signals the condition variable, which wakes the
+// main event loop if it is sleeping. The main thread then locks the mutex and empties the queue by inserting it into
+// the HEAP. The queue is then unlocked and events can continue to flow through.
 struct RealTimeDataHandler : public DataHandler, public BloombergLP::blpapi::EventHandler {
 public:
-    // Constructor receives a reference to the mutex and queue which it stores to enable placing onto queue
-    RealTimeDataHandler(std::queue<std::unique_ptr<events::Event>>* queue, pthread_mutex_t* mtx);
+    // Constructor receives a reference to the mutex, condition variable, and queue which it stores to enable
+    // placing onto queue and notifying the main thread. Every field received is decoded into the quote book, whose
+    // symbols are indexed by the subscription correlation IDs.
+    RealTimeDataHandler(std::queue<std::unique_ptr<events::Event>>* queue, pthread_mutex_t* mtx, pthread_cond_t* cond,
+                        QuoteBook* book);
 
     // The actual event handler method which receives the events. It uses the mutex so it does not edit the queue
     // when it is being read.
     bool processEvent(const BloombergLP::blpapi::Event &event, BloombergLP::blpapi::Session *session) override;
 
+    // Writes the fields of the update named by the Quote field bits into the symbol's quote, and queues a
+    // MarketEvent if it was a trade. Every source of ticks (the subscription or a recorded replay) goes through here.
+    void ingest(size_t index, const Quote& update, unsigned fields);
+    // Queues a StopEvent at the given time to end the event loop once the feed has no more data
+    void finish(const BloombergLP::blpapi::Datetime& when, const std::string& reason);
+
+    // When given a conflation buffer, trades only mark the symbol dirty rather than going onto the queue.
+    // Pass nullptr to go back to queueing every tick.
+    void setConflationBuffer(ConflationBuffer* buffer) { conflation = buffer; }
+
 private:
-    // The mutex and queue used for the realtime data retrieval
+    // The mutex, condition variable, and queue used for the realtime data retrieval
     std::queue<std::unique_ptr<events::Event>>* queue;
     pthread_mutex_t* mtx;
+    pthread_cond_t* cond;
+    // The latest quotes of the subscribed symbols, and the dirty bitset if conflating
+    QuoteBook* book;
+    ConflationBuffer* conflation = nullptr;
 };
 
+// Plays back a recorded tick file through the real time data handler, defined in replay.hpp
+class TickReplayer;
+
 // Class for subscription-based data retrieval from the Bloomberg API. When the event calculations are finished
-// and the stack is empty, the algorithm will unlock the event heap and wait for a new market event to be filled in
-// or for the realtime date counter to exceed the datetime of the next ScheduledEvent.
+// and the stack is empty, the algorithm will sleep on the condition variable until a new market event is filled in
+// or the realtime clock reaches the datetime of the next ScheduledEvent.
 class RealTimeDataRetriever {
 public:
     // Constructor initializes the session subscription to Bloomberg API through which data will be passed.
@@ -121,28 +206,54 @@ public:
     // use of a mutex which locks the HEAP in the main thread until the event is finished processing, at which
     // the HEAP in the main thread is unlocked and LOCKED in the session thread while the queue is copied over.
     // Once that is finished, the queue in the other thread is emptied and the HEAP is locked back in the main thread.
-    explicit RealTimeDataRetriever(pthread_mutex_t* p_mtx, int correlation_id = correlation_ids::LIVE_REQUEST_CID);
+    RealTimeDataRetriever(pthread_mutex_t* p_mtx, pthread_cond_t* p_cond,
+                          int correlation_id = correlation_ids::LIVE_REQUEST_CID);
 
     // On destruction, close the session and end the subscription before releasing the object
     ~RealTimeDataRetriever();
 
     // Runs the subscription for a vector of stocks, placing the tick level data into a queue which acts as a
     // buffer to store temporary tick data until the mutex is unlocked and this class is able to write again.
-    void runSubscription(const std::vector<std::string>& symbols);
+    // Every field subscribed to (e.g. BID, ASK, BID_SIZE, ASK_SIZE, VOLUME) is kept up to date in the quote book.
+    void runSubscription(const std::vector<std::string>& symbols,
+                         const std::vector<std::string>& fields = {realtime_fields::LAST_PRICE});
 
     // Stops all subscriptions
     void stopSubscriptions();
 
+    // Instead of subscribing, replays the ticks recorded in a CSV file through the same handler and queue, timed by
+    // the given replay clock. Only ticks for the given symbols are replayed. Once the file is exhausted a StopEvent
+    // is queued, ending the strategy's run. Returns the time of the first tick, or throws if there are none.
+    BloombergLP::blpapi::Datetime loadReplay(const std::vector<std::string>& symbols, const std::string& filepath);
+    void runReplay(ReplayClock* clock);
+
+    // Turns tick conflation on or off. When on, only the latest price per symbol is kept between drains of the
+    // buffer, so a burst of ticks results in one batched MarketEvent. Should be set before running the subscription.
+    void setConflation(bool conflate);
+    // Moves any conflated prices onto the buffer queue as a single MarketEvent. Must be called with the mutex locked.
+    void flushConflated();
+    // The number of ticks dropped by conflation so far
+    unsigned long conflatedTicks() const { return conflation_buffer.conflated; }
+    // The latest quote of every subscribed symbol. Must be read with the mutex locked.
+    const QuoteBook& quotes() const { return quote_book; }
+
     // A buffer queue which holds the market events received until the mutex is unlocked
     std::queue<std::unique_ptr<events::Event>> buffer_queue;
 private:
     // The correlation ID for requests
     const int correlation_id;
-    // The session through which the subscription will be run
+    // The quotes of the symbols subscribed to, whose indices are used as the correlation IDs of the subscriptions
+    QuoteBook quote_book;
+    // Dirty bitset used when conflating
+    bool conflate = false;
+    ConflationBuffer conflation_buffer;
+    // The session through which the subscription will be run, only started once a subscription is run
     std::unique_ptr<BloombergLP::blpapi::Session> session;
+    // The recorded ticks being replayed in place of the subscription
+    std::unique_ptr<TickReplayer> replayer;
     // The symbols subscribed to
     BloombergLP::blpapi::SubscriptionList subscriptions;
-    // The handler for all the data coming through the subscription, possesses the mutex
+    // The handler for all the data coming through the subscription, possesses the mutex and condition variable
     RealTimeDataHandler data_handler;
 };
 
@@ -161,4 +272,16 @@ struct HistoricalDataHandler : public DataHandler {
     std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> target;
 };
 
+// Handler for the responses to an IntradayBarRequest, which come back for a single security as an array of bars
+// rather than the securityData of a HistoricalDataRequest. Bar times are converted from GMT to local time.
+struct IntradayBarHandler : public DataHandler {
+    // Constructor sets the security the bars are for
+    explicit IntradayBarHandler(const std::string& security);
+    // Reads the bars out of each response message into the target. Returns false until the final RESPONSE arrives.
+    bool processResponseEvent(const BloombergLP::blpapi::Event &event);
+
+    // The object into which the bars are filled
+    SymbolHistoricalData target;
+};
+
 #endif //BACKTESTER_DATARETRIEVER_HPP
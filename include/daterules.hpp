@@ -82,8 +82,19 @@ namespace date_funcs {
     // Gets the current time
     BloombergLP::blpapi::Datetime get_now();
 
+    // Converts a local-time Datetime into an absolute timespec, which is what pthread_cond_timedwait expects
+    // as its deadline. Milliseconds are carried over into the nanoseconds field.
+    timespec to_timespec(const BloombergLP::blpapi::Datetime& date);
+    // The inverse of to_timespec, keeping millisecond precision
+    BloombergLP::blpapi::Datetime from_timespec(const timespec& time);
+
     // Compares two dates, returning true if the first is greater
     bool is_greater(const BloombergLP::blpapi::Datetime& first, const BloombergLP::blpapi::Datetime& second);
+
+    // Converts between GMT and the machine's local time. Intraday requests to Bloomberg are made and answered in
+    // GMT, whereas the rest of the backtester (schedules, daily bars) runs on local time.
+    BloombergLP::blpapi::Datetime utc_to_local(const BloombergLP::blpapi::Datetime& utc);
+    BloombergLP::blpapi::Datetime local_to_utc(const BloombergLP::blpapi::Datetime& local);
 }
 
 
@@ -7,6 +7,11 @@
 
 // Include bloomberg includes
 #include "bloombergincludes.hpp"
+// STL includes
+#include <chrono>
+#include <cstdint>
+#include <unordered_set>
+#include <utility>
 
 namespace events {
 
@@ -16,6 +21,8 @@ namespace events {
 //   - SignalEvent     : produced by the strategy and requests a fill for a security for a given percentage of holdings
 //   - OrderEvent      : produced by the execution handler after reformatting a signal event to quantity
 //   - FillEvent       : notifies the portfolio that an order has been filled, contains simulated commission & slippage
+//   - RebalanceEvent  : produced by the strategy and requests target percentages for several securities at once
+//   - FillsEvent      : produced by the execution handler for a rebalance, containing all of its fills
 
 // Parent Event class which contains members used by all Events
 //
@@ -45,17 +52,24 @@ protected:
 //
 // @member symbols          The symbols for which the market is providing a price update.
 // @member data             An unordered map of the new price updates wrt their symbols.
+// @member stale            The symbols whose price is carried forward from an earlier bar rather than fresh.
+// @member received         The steady clock time at which the update reached the process.
 //
 struct MarketEvent : public Event {
     const std::vector<std::string> symbols;
     const std::unordered_map<std::string, double> data;
+    const std::unordered_set<std::string> stale;
+    // When the data behind the event was received by this process, to measure the tick-to-processed latency
+    std::chrono::steady_clock::time_point received = std::chrono::steady_clock::now();
 
     // Print function
     void what() override;
+    // Whether the symbol's price is carried forward, e.g. after its last bar once it has delisted
+    bool is_stale(const std::string& symbol) const;
 
     // Constructor for the MarketEvent
     MarketEvent(const std::vector<std::string> &symbols, const std::unordered_map<std::string, double> &data,
-                const BloombergLP::blpapi::Datetime &when);
+                const BloombergLP::blpapi::Datetime &when, std::unordered_set<std::string> stale = {});
 };
 
 // SignalEvent which is produced when the algorithm requests an order. This acts as a middleman between the algorithm
@@ -117,6 +131,51 @@ struct FillEvent : public Event {
             const BloombergLP::blpapi::Datetime& when);
 };
 
+// RebalanceEvent which is produced when the algorithm requests target percentages for several securities at once.
+// The execution handler prices and revalues the portfolio once for the whole rebalance and sizes every order from
+// the same total holdings, rather than once per security as for a SignalEvent.
+//
+// @member targets            The target percentage of the holdings for each symbol, in the order they were requested
+//
+struct RebalanceEvent : public Event {
+    const std::vector<std::pair<std::string, double>> targets;
+
+    // Print function
+    void what() override;
+
+    // Constructor for the RebalanceEvent
+    RebalanceEvent(const std::vector<std::pair<std::string, double>> &targets,
+                   const BloombergLP::blpapi::Datetime& when);
+};
+
+// FillsEvent which carries every fill of a rebalance, so the portfolio applies them together and revalues once.
+//
+// @member fills              The fills in the order they were executed (sells before buys)
+//
+struct FillsEvent : public Event {
+    const std::vector<FillEvent> fills;
+
+    // Print function
+    void what() override;
+
+    // Constructor for the FillsEvent
+    FillsEvent(std::vector<FillEvent> fills, const BloombergLP::blpapi::Datetime& when);
+};
+
+// Parent of the strategy's ScheduledEvents (defined alongside the strategies) which does not depend on the strategy
+// type. Every function scheduled by a strategy is numbered in the order it was scheduled, so a pending scheduled
+// event can be written to a checkpoint as its number and rebuilt once the strategy has scheduled its functions again.
+//
+// @member schedule_id         The number of the scheduled function in the strategy's schedule
+//
+struct ScheduledEventBase : public Event {
+    const uint32_t schedule_id;
+
+protected:
+    ScheduledEventBase(uint32_t p_schedule_id, const BloombergLP::blpapi::Datetime& p_when) :
+            Event("SCHEDULED", p_when), schedule_id(p_schedule_id) {}
+};
+
 // StopEvent which terminates the execution loop safely. Put on the stack so it breaks the while loop that interprets
 // events, and allows the program to do any cleanup and post-run logging.
 //
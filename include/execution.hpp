@@ -29,14 +29,41 @@ public:
     void process_signal(const events::SignalEvent& event);
     // Takes in an Order Event and converts it into a FillEvent based on fill limits (may also split it into several orders)
     void process_order(const events::OrderEvent& event);
+    // Takes in a Rebalance Event and fills every symbol's order at once. The symbols are priced and the portfolio
+    // revalued a single time, every quantity is sized from the same total holdings, and the fills are emitted as
+    // one FillsEvent with the sells before the buys so that the cash they free pays for the buys.
+    void process_rebalance(const events::RebalanceEvent& event);
+
+    // Prices signals and orders from a live quote book rather than through history calls whenever the symbol has
+    // a quote no more than max_age seconds older than the signal or order (any age if 0). Orders are then booked at
+    // the mid, with the half spread out to the ask when buying or the bid when selling taken as slippage, so they
+    // cost what filling at the touch would. The mutex is the one the quote book is written under.
+    void use_quotes(const QuoteBook* quotes, pthread_mutex_t* mtx, unsigned int max_age = 60);
+    // Books the simulated slippage of every fill at its expected value rather than sampling it, so runs are
+    // repeatable, e.g. to compare against the vectorized engine
+    void use_expected_slippage(bool expected = true) { expected_slippage = expected; }
 
 private:
+    // Copies the latest quote of the symbol out of the quote book, returning false if there is none or it is
+    // stale as of the given time
+    bool get_quote(const std::string& symbol, Quote& quote, const BloombergLP::blpapi::Datetime& when);
+    // Builds the fill of an order at the price, across the spread of the quote instead if it is given and two-sided
+    events::FillEvent fill_order(const std::string& symbol, int quantity, double price, const Quote* quote,
+                                 const BloombergLP::blpapi::Datetime& when);
+
     // Pointers to the external event list stack and heap
     std::queue<std::unique_ptr<events::Event>>* stack_eventlist;
     std::list<std::unique_ptr<events::Event>>* heap_eventlist;
     // Other references needed for data retrieval and portfolio fitting
     std::shared_ptr<DataManager> data_manager;
     Portfolio* portfolio;
+    // The live quote book, if there is one, and the mutex guarding it
+    const QuoteBook* quotes = nullptr;
+    pthread_mutex_t* quotes_mtx = nullptr;
+    // The oldest a quote may be, in seconds, to price from
+    unsigned int max_quote_age = 0;
+    // Whether simulated slippage is its expected value instead of a sample
+    bool expected_slippage = false;
 };
 
 #endif //BACKTESTER_EXECUTION_HPP
@@ -0,0 +1,113 @@
+#ifndef BACKTESTER_INDICATORS_HPP
+#define BACKTESTER_INDICATORS_HPP
+// Bloomberg includes
+#include "bloombergincludes.hpp"
+// STL includes
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+// Custom class includes
+#include "events.hpp"
+#include "dataretriever.hpp"
+#include "checkpoint.hpp"
+
+// Rolling statistics over the last `window` values of a series. Each value updates every statistic in O(1): the
+// mean and variance with Welford's algorithm (adding the new value and removing the one leaving the window), the
+// regression line through running sums of the values and of the values weighted by their position, and the minimum
+// and maximum with monotonic queues. Removing values lets rounding error build up, so the sums are recomputed from
+// the window each time it wraps around, which is still O(1) per value amortized.
+//
+// Positions in the window count from 0 at the oldest value, so the regression line at position window - 1 is its
+// value at the latest one.
+class RollingIndicators {
+public:
+    // The EMA spans ema_span values, or the window if 0
+    explicit RollingIndicators(unsigned int window, unsigned int ema_span = 0);
+
+    // Adds the next value of the series
+    void update(double value);
+
+    // Whether the window has been filled, and how many values it holds
+    bool ready() const { return count == values.size(); }
+    size_t size() const { return count; }
+    size_t window() const { return values.size(); }
+    // The value the given number of updates ago, 0 being the latest
+    double back(size_t ago = 0) const;
+
+    // Mean, and the population variance and standard deviation of the window
+    double mean() const;
+    double variance() const;
+    double stddev() const;
+    // Ordinary least squares line through the window against position
+    double slope() const;
+    double intercept() const;
+    double fitted(double position) const;
+    // Bollinger bands at the given number of standard deviations from the mean
+    double upper_band(double deviations) const;
+    double lower_band(double deviations) const;
+    // Exponential moving average, over every value so far rather than just the window
+    double ema() const;
+    double min() const;
+    double max() const;
+    // Standard deviations of the latest value from the mean
+    double zscore() const;
+
+    // Write and read the window and the EMA into a checkpoint, rebuilding the rest from the window
+    void write_checkpoint(checkpoint::Writer& writer) const;
+    void read_checkpoint(checkpoint::Reader& reader);
+
+private:
+    // Recomputes the running sums exactly from the window
+    void refresh();
+
+    // The window as a ring, the next slot to write, and how many values it holds
+    std::vector<double> values;
+    size_t next = 0;
+    size_t count = 0;
+    // Number of values seen, numbering the entries of the min and max queues
+    unsigned long long sequence = 0;
+    // Running mean, sum of squared deviations, and sum of each value times its position
+    double average = 0, m2 = 0, weighted_sum = 0;
+    // Exponential moving average and its smoothing factor
+    const double alpha;
+    double smoothed = 0;
+    // Increasing and decreasing queues of the values which can still become the window's minimum or maximum
+    std::deque<std::pair<unsigned long long, double>> minima, maxima;
+};
+
+// A set of rolling indicators over the same window for each symbol, fed by the market events. Symbols are given
+// ids in the order of the list so that strategies can look them up without hashing the name every time.
+//
+// Each market event updates each symbol in it with its price, once: events no later than the last one taken in are
+// skipped, so the set can be seeded from history covering the events still to come. Prices the event marks stale are
+// skipped too, so a symbol's windows only ever hold bars of its own.
+class Indicators {
+public:
+    Indicators(const std::vector<std::string>& symbols, unsigned int window, unsigned int ema_span = 0);
+
+    // Takes the prices of the symbols in the market event
+    void update(const events::MarketEvent& event);
+    // Takes the field of each symbol's bars in order, e.g. to fill the windows before the first market event
+    void seed(const std::unordered_map<std::string, SymbolHistoricalData>& history, const std::string& field);
+
+    // The id of the symbol, which is its index in the list
+    size_t id(const std::string& symbol) const;
+    size_t size() const { return rolling.size(); }
+    // Indicators of a symbol by id or by name
+    const RollingIndicators& operator[](size_t symbol_id) const { return rolling[symbol_id]; }
+    const RollingIndicators& operator[](const std::string& symbol) const { return rolling[id(symbol)]; }
+
+    // Write and read every symbol's indicators into a checkpoint
+    void write_checkpoint(checkpoint::Writer& writer) const;
+    void read_checkpoint(checkpoint::Reader& reader);
+
+private:
+    std::unordered_map<std::string, size_t> ids;
+    std::vector<RollingIndicators> rolling;
+    // Time of the last values taken in
+    bool updated = false;
+    BloombergLP::blpapi::Datetime latest;
+};
+
+#endif //BACKTESTER_INDICATORS_HPP
@@ -0,0 +1,137 @@
+#ifndef BACKTESTER_INSTRUMENTATION_HPP
+#define BACKTESTER_INSTRUMENTATION_HPP
+
+// Instrumentation of the event loop's hot path: how many of each event type were processed and how long they took,
+// how deep the STACK and HEAP got, and the time spent in history() and in each scheduled function. Turned on by
+// building with BACKTESTER_INSTRUMENTATION defined (the BACKTESTER_INSTRUMENTATION CMake option). Otherwise every
+// macro below expands to nothing and none of it is compiled in.
+//
+// The timings are kept in log2 histograms of nanoseconds, so recording one is two clock reads, a count-leading-zeros
+// and a few increments, with no allocation. They are only to be recorded from the simulation thread.
+#ifdef BACKTESTER_INSTRUMENTATION
+
+// STL includes
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace instrumentation {
+    // What a probe is timing. Events of any other type go under OTHER.
+    enum Category : unsigned int {
+        MARKET = 0, SIGNAL, ORDER, FILL, REBALANCE, FILLS, SCHEDULED, STOP, OTHER, HISTORY, NUM_CATEGORIES
+    };
+
+    // Counts and a histogram of durations, where bucket i holds durations of [2^(i-1), 2^i) nanoseconds
+    struct Timings {
+        uint64_t count = 0;
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+        std::array<uint64_t, 64> buckets{};
+        // How many probes of this are running, so nested calls (an override calling its base) count only once
+        unsigned int active = 0;
+
+        void record(uint64_t ns) {
+            count++;
+            total_ns += ns;
+            if (ns > max_ns) { max_ns = ns; }
+            buckets[ns == 0 ? 0 : 64 - __builtin_clzll(ns)]++;
+        }
+        // Upper bound of the bucket holding the given fraction of the durations
+        uint64_t percentile(double fraction) const;
+    };
+
+    // Samples of a queue's length
+    struct Depth {
+        uint64_t samples = 0;
+        uint64_t total = 0;
+        uint64_t max = 0;
+
+        void record(uint64_t depth) {
+            samples++;
+            total += depth;
+            if (depth > max) { max = depth; }
+        }
+    };
+
+    // Everything recorded since the last reset
+    struct Registry {
+        std::array<Timings, NUM_CATEGORIES> categories;
+        // Per scheduled function, by its schedule id
+        std::vector<Timings> scheduled;
+        Depth stack, heap;
+    };
+    // The registry itself
+    Registry& registry();
+
+    // Timings for a scheduled function, growing the list as new ids appear
+    inline Timings& scheduled(uint32_t schedule_id) {
+        std::vector<Timings>& functions = registry().scheduled;
+        if (schedule_id >= functions.size()) { functions.resize(schedule_id + 1); }
+        return functions[schedule_id];
+    }
+
+    // Times its scope into the timings it was built with
+    class Probe {
+    public:
+        explicit Probe(Timings& p_timings) : timings(p_timings), start(std::chrono::steady_clock::now()) {
+            timings.active++;
+        }
+        ~Probe() {
+            if (--timings.active == 0) {
+                timings.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start).count()));
+            }
+        }
+        Probe(const Probe&) = delete;
+        Probe& operator=(const Probe&) = delete;
+    private:
+        Timings& timings;
+        const std::chrono::steady_clock::time_point start;
+    };
+
+    // The category of an event type string
+    Category category(const std::string& type);
+
+    // Prints a table of everything recorded
+    void report(std::ostream& out);
+    // Writes everything recorded as JSON, for comparing runs
+    void dump(const std::string& filepath);
+    // Clears everything recorded
+    void reset();
+}
+
+// Times the rest of the enclosing scope into a category, or into a scheduled function by its schedule id
+#define BT_PROBE(category) \
+    instrumentation::Probe bt_probe_##category(instrumentation::registry().categories[instrumentation::category])
+#define BT_PROBE_EVENT(type) \
+    instrumentation::Category bt_probe_category = instrumentation::category(type); \
+    instrumentation::Probe bt_probe_event(instrumentation::registry().categories[bt_probe_category])
+#define BT_PROBE_SCHEDULED(schedule_id) \
+    instrumentation::Probe bt_probe_scheduled(instrumentation::scheduled(schedule_id))
+// Samples the lengths of the STACK and HEAP
+#define BT_SAMPLE_QUEUES(stack_queue, heap_list) \
+    do { \
+        instrumentation::registry().stack.record((stack_queue).size()); \
+        instrumentation::registry().heap.record((heap_list).size()); \
+    } while (false)
+// Prints the report and, if the path is not empty, dumps it there
+#define BT_INSTRUMENTATION_REPORT(out, filepath) \
+    do { \
+        instrumentation::report(out); \
+        if (!std::string(filepath).empty()) { instrumentation::dump(filepath); } \
+    } while (false)
+
+#else
+
+#define BT_PROBE(category)
+#define BT_PROBE_EVENT(type)
+#define BT_PROBE_SCHEDULED(schedule_id)
+#define BT_SAMPLE_QUEUES(stack_queue, heap_list) do {} while (false)
+#define BT_INSTRUMENTATION_REPORT(out, filepath) do {} while (false)
+
+#endif
+
+#endif //BACKTESTER_INSTRUMENTATION_HPP
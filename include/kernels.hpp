@@ -0,0 +1,79 @@
+#ifndef BACKTESTER_KERNELS_HPP
+#define BACKTESTER_KERNELS_HPP
+// STL includes
+#include <cstddef>
+#include <vector>
+
+// Numerical kernels which work across a whole universe at once, on plain arrays of doubles holding one value per
+// symbol in a fixed symbol order (e.g. the strategy's symbol_list), rather than on maps keyed by symbol name.
+//
+// The loops over symbols are also written for AVX2, chosen at runtime when the processor has it so that one build
+// runs everywhere; otherwise the same loops run as plain scalar code. Both do the same arithmetic in the same order,
+// so they give the same results. The inputs must be finite: fill or drop missing prices before handing them in.
+namespace kernels {
+    // Instruction sets the kernels can run with
+    enum Isa {SCALAR, AVX2};
+
+    // The instruction set the kernels are running with, detected from the processor on first use
+    Isa isa();
+    // Runs the kernels with the given instruction set instead, if the processor has it, returning the one now used.
+    // For comparing the two in tests and benchmarks.
+    Isa use_isa(Isa requested);
+    // Name of the instruction set, for reports
+    const char* isa_name(Isa which);
+
+    // Rolling statistics over the last `window` rows of a [time x symbol] series, for every symbol at once. Each
+    // row is one value per symbol, and updates each symbol's running sum, sum of squares and sum of values times
+    // their position in the window in O(1), so a row costs O(symbols) however long the window.
+    //
+    // Each symbol's values are kept relative to its first value, so that the sums stay small and the variance does
+    // not lose its precision to the level of the prices; and the sums are recomputed exactly each time the window
+    // wraps around, so rounding error from removing values cannot build up.
+    class RollingPanel {
+    public:
+        RollingPanel(size_t symbols, size_t window);
+
+        // Adds the next row, holding one value per symbol
+        void update(const double* row);
+
+        // Whether the window has been filled, and how many rows it holds
+        bool ready() const { return count == window; }
+        size_t size() const { return count; }
+        size_t symbols() const { return width; }
+
+        // Each writes one value per symbol into out: the mean, the population variance, and the ordinary least
+        // squares slope and intercept against position in the window (0 at the oldest row)
+        void mean(double* out) const;
+        void variance(double* out) const;
+        void slope(double* out) const;
+        void intercept(double* out) const;
+
+    private:
+        // Recomputes the sums from the rows in the window
+        void refresh();
+
+        const size_t width, window;
+        // The rows of the window as a ring, relative to the shift, and the next row to write
+        std::vector<double> rows;
+        size_t next = 0;
+        size_t count = 0;
+        // Each symbol's first value, and its running sums
+        std::vector<double> shift, sum, sum_squares, weighted_sum;
+    };
+
+    // Cross-sectional transforms of one value per symbol. Each writes n values into out, which may be the input.
+    //
+    // Rank of each value scaled onto [0, 1], ties sharing the mean of their ranks
+    void rank(const double* in, double* out, size_t n);
+    // Standard deviations from the mean, or 0 when there is no spread
+    void zscore(const double* in, double* out, size_t n);
+    // Clamps the values to the given lower and upper quantiles of themselves, e.g. 0.01 and 0.99
+    void winsorize(const double* in, double* out, size_t n, double lower_quantile, double upper_quantile);
+    // Mean and population variance of the values
+    void moments(const double* in, size_t n, double& mean, double& variance);
+    // Sum of a[i] * b[i], e.g. the value of the positions a at the prices b, and the sum of their absolute values
+    double dot(const double* a, const double* b, size_t n);
+    double gross(const double* a, const double* b, size_t n);
+}
+
+#endif //BACKTESTER_KERNELS_HPP
@@ -0,0 +1,62 @@
+#ifndef BACKTESTER_LOGGER_HPP
+#define BACKTESTER_LOGGER_HPP
+// Bloomberg includes
+#include "bloombergincludes.hpp"
+// STL includes
+#include <atomic>
+#include <ostream>
+#include <thread>
+
+// Compile-time log level: statements below this level are compiled out entirely. Defaults to keeping everything, so
+// tracing can be left in the code and switched on at run time; build with e.g. -DBACKTESTER_LOG_LEVEL=2 to strip
+// TRACE and DEBUG statements out of a release build.
+#ifndef BACKTESTER_LOG_LEVEL
+#define BACKTESTER_LOG_LEVEL 0
+#endif
+
+// Logs a message at the given simulated time. The message expression is only evaluated when the level is enabled,
+// both at compile time and at run time, so a disabled statement costs at most one relaxed atomic load and no
+// string building.
+#define BT_LOG(level, time, message) \
+    do { \
+        if (static_cast<int>(level) >= BACKTESTER_LOG_LEVEL && logging::enabled(level)) { \
+            logging::write(level, time, message); \
+        } \
+    } while (false)
+#define BT_TRACE(time, message) BT_LOG(logging::LEVEL_TRACE, time, message)
+#define BT_DEBUG(time, message) BT_LOG(logging::LEVEL_DEBUG, time, message)
+#define BT_INFO(time, message) BT_LOG(logging::LEVEL_INFO, time, message)
+#define BT_WARN(time, message) BT_LOG(logging::LEVEL_WARN, time, message)
+#define BT_ERROR(time, message) BT_LOG(logging::LEVEL_ERROR, time, message)
+
+// Asynchronous logger shared by every strategy. Log statements copy their message into a fixed-size record on a
+// lock-free ring buffer; a background thread drains the ring, formats each record as "[time] LEVEL message" and
+// writes them out in batches, flushing only once the ring is empty and then sleeping until the next record. If the
+// ring ever fills up, writers wait for the background thread to make room rather than dropping messages.
+namespace logging {
+    // Severity of a log record
+    // (prefixed, since Windows headers define ERROR and some builds define DEBUG as macros)
+    enum Level : int {
+        LEVEL_TRACE = 0, LEVEL_DEBUG = 1, LEVEL_INFO = 2, LEVEL_WARN = 3, LEVEL_ERROR = 4, LEVEL_OFF = 5
+    };
+
+    // The run-time level, below which records are skipped. INFO by default.
+    extern std::atomic<int> runtime_level;
+
+    // Whether records of the level are currently written. OFF only switches logging off, so is never written.
+    inline bool enabled(Level level) {
+        return level < LEVEL_OFF && level >= runtime_level.load(std::memory_order_relaxed);
+    }
+    // Changes the run-time level
+    void set_level(Level level);
+    // Sends the log output to the stream instead of std::cout. The stream must outlive the logger.
+    void set_output(std::ostream* output);
+
+    // Queues a record onto the ring, unless the level is not one records are written at. Messages longer than a
+    // record holds are truncated, ending in "[...]" to show it.
+    void write(Level level, const BloombergLP::blpapi::Datetime& time, const std::string& message);
+    // Blocks until every record written so far has been output, e.g. before printing directly to the console
+    void flush();
+}
+
+#endif //BACKTESTER_LOGGER_HPP
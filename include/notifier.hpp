@@ -0,0 +1,81 @@
+#ifndef BACKTESTER_NOTIFIER_HPP
+#define BACKTESTER_NOTIFIER_HPP
+// STL includes
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Where notifications end up. A sink is only ever called from the notifier's dispatcher thread, with every message
+// gathered since its last call, so it is free to be slow.
+class NotificationSink {
+public:
+    virtual ~NotificationSink() = default;
+    // Delivers a batch of messages, oldest first
+    virtual void send(const std::vector<std::string>& messages) = 0;
+};
+
+// Posts to Slack by running the slackmanagement.py script, once per batch with the messages on separate lines of
+// its standard input
+class SlackSink : public NotificationSink {
+public:
+    explicit SlackSink(const std::string& python = R"(C:\python27\python.exe)",
+                       const std::string& script = R"(C:\Users\bloomberg\CLionProjects\bloomberg_backtester\src\python\slackmanagement.py)");
+    void send(const std::vector<std::string>& messages) override;
+private:
+    const std::string python;
+    const std::string script;
+};
+
+// Appends every message as a line to a file, or a named pipe, for testing or for local monitoring
+class FileSink : public NotificationSink {
+public:
+    explicit FileSink(const std::string& filepath);
+    void send(const std::vector<std::string>& messages) override;
+private:
+    std::ofstream file;
+};
+
+// Queues notifications and hands them to the sink on a background thread, so sending one never waits on the sink.
+// A burst of notifications is gathered for a short window and delivered as one batch, with repeats of the same
+// message coalesced into one line with a count. The queue is bounded: if the sink falls so far behind that it fills
+// up, the oldest messages are dropped and the next batch says how many were lost.
+class Notifier {
+public:
+    explicit Notifier(std::unique_ptr<NotificationSink> sink, size_t capacity = 256,
+                      std::chrono::milliseconds window = std::chrono::milliseconds(500));
+    // Delivers anything still queued and stops the dispatcher
+    ~Notifier();
+
+    // Queues a message without waiting
+    void notify(const std::string& message);
+    // Blocks until every message queued so far has been handed to the sink
+    void flush();
+
+private:
+    // The body of the dispatcher thread
+    void dispatch_loop();
+    // Collapses repeated messages into one line each, keeping the order they first appeared in
+    static std::vector<std::string> coalesce(const std::vector<std::string>& messages);
+
+    const std::unique_ptr<NotificationSink> sink;
+    const size_t capacity;
+    const std::chrono::milliseconds window;
+
+    // The queue, guarded by the mutex, which is only held to add to or take from it
+    std::mutex mtx;
+    std::condition_variable wake, delivered;
+    std::deque<std::string> queue;
+    // Counts of messages queued and handed to the sink, which flush waits to become equal
+    unsigned long long queued = 0, sent = 0;
+    unsigned long dropped = 0;
+    bool flush_requested = false, stopping = false;
+    std::thread dispatcher;
+};
+
+#endif //BACKTESTER_NOTIFIER_HPP
@@ -0,0 +1,54 @@
+#ifndef BACKTESTER_PANEL_HPP
+#define BACKTESTER_PANEL_HPP
+// Bloomberg includes
+#include "bloombergincludes.hpp"
+// STL includes
+#include <string>
+#include <unordered_map>
+#include <vector>
+// Custom class includes
+#include "dataretriever.hpp"
+
+// History of several symbols and fields on one shared calendar, held as a single dense array of doubles rather than
+// as a map of maps per symbol. Each field is a [time x symbol] matrix stored row by row, in the order of the fields,
+// so a row holds one value per symbol in the order of the symbols, ready for the cross-sectional kernels. Times at
+// which a symbol has no value for a field are NaN, or carry its last value forward when filled.
+struct Panel {
+    // How to treat the times at which a symbol has no value
+    enum Gaps {FORWARD_FILL, LEAVE_NAN};
+
+    std::vector<std::string> symbols;
+    std::vector<std::string> fields;
+    std::vector<BloombergLP::blpapi::Datetime> times;
+    std::vector<double> values;
+
+    Panel() = default;
+    // Builds a panel of NaNs for the symbols and fields at the times
+    Panel(std::vector<std::string> symbols, std::vector<std::string> fields,
+          std::vector<BloombergLP::blpapi::Datetime> times);
+
+    // Position of the field or symbol in the panel, throwing if it is not in it
+    size_t field_index(const std::string& field) const;
+    size_t symbol_index(const std::string& symbol) const;
+
+    // The [time x symbol] matrix of a field
+    double* field(size_t field) { return values.data() + field * times.size() * symbols.size(); }
+    const double* field(size_t field) const { return values.data() + field * times.size() * symbols.size(); }
+    // The values of every symbol for a field at a time
+    double* row(size_t field, size_t time) { return this->field(field) + time * symbols.size(); }
+    const double* row(size_t field, size_t time) const { return this->field(field) + time * symbols.size(); }
+    // A single value
+    double at(size_t field, size_t time, size_t symbol) const { return row(field, time)[symbol]; }
+
+    // Replaces every NaN with the last value before it of the same symbol and field, leaving the NaNs before a
+    // symbol's first value
+    void forward_fill();
+
+    // Lays out the maps returned by DataManager::history on the union of their dates. Symbols missing from the
+    // history are left all NaN.
+    static Panel from_history(const std::vector<std::string>& symbols, const std::vector<std::string>& fields,
+                              const std::unordered_map<std::string, SymbolHistoricalData>& history,
+                              Gaps gaps = FORWARD_FILL);
+};
+
+#endif //BACKTESTER_PANEL_HPP
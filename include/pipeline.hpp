@@ -0,0 +1,132 @@
+#ifndef BACKTESTER_PIPELINE_HPP
+#define BACKTESTER_PIPELINE_HPP
+// Bloomberg includes
+#include "bloombergincludes.hpp"
+// STL includes
+#include <string>
+#include <unordered_map>
+#include <vector>
+// Custom class includes
+#include "panel.hpp"
+#include "data.hpp"
+
+// A handle on one term of a pipeline, as returned by the Pipeline's builder functions
+struct Term {
+    size_t id;
+};
+
+// The table a pipeline hands the strategy: one row for each symbol which passed the screen, in the order of the
+// universe, holding one value for each of the pipeline's columns
+struct PipelineOutput {
+    // Time of the last bar the pipeline was computed from
+    BloombergLP::blpapi::Datetime datetime;
+    std::vector<std::string> symbols;
+    std::vector<std::string> columns;
+    std::vector<double> values;
+
+    // Number of symbols which passed the screen
+    size_t size() const { return symbols.size(); }
+    bool empty() const { return symbols.empty(); }
+    // The values of the columns for the symbol at the given row
+    const double* row(size_t symbol) const { return values.data() + symbol * columns.size(); }
+    // A single value, throwing if the symbol did not pass the screen or the column is not in the table
+    double get(const std::string& symbol, const std::string& column) const;
+};
+
+// Cross-sectional screens over a universe, declared once as a graph of terms and computed once per day. Each term
+// is a factor (a number per symbol), a filter (1 for the symbols it passes and 0 otherwise) or a classifier (a group
+// number per symbol), built on the fields of a Panel or on other terms. A term is computed for every symbol at once,
+// the windowed factors with the rolling kernels down the panel's rows and the cross-sectional ones with the kernels
+// over the last row, so a term costs O(symbols) per bar of its window however many symbols are in the universe.
+//
+// Terms are deduplicated as they are declared: asking for the same term on the same inputs twice returns the same
+// handle, so a shared subexpression (say the 20 day returns under both a rank and a filter) is computed only once.
+// Terms which no column or screen depends on are never computed.
+//
+// Symbols without enough history for a term, or whose value is NaN, are NaN in every factor built on it and fail
+// every filter built on it. The cross-sectional factors are taken over the symbols with values only.
+class Pipeline {
+public:
+    // Factors on a field of the panel. Returns are over the given number of bars, and volatility is the standard
+    // deviation of the one bar returns over the window (not annualized).
+    Term latest(const std::string& field = "PX_LAST");
+    Term returns(unsigned int window, const std::string& field = "PX_LAST");
+    Term moving_average(unsigned int window, const std::string& field = "PX_LAST");
+    Term volatility(unsigned int window, const std::string& field = "PX_LAST");
+
+    // Factors on other factors: arithmetic between two of them, and the rank (scaled onto [0, 1]) and z-score of
+    // each symbol's value across the universe
+    Term add(Term first, Term second);
+    Term subtract(Term first, Term second);
+    Term divide(Term numerator, Term denominator);
+    Term rank(Term factor);
+    Term zscore(Term factor);
+
+    // Filters passing the n symbols with the highest or lowest values (fewer if fewer have values, with ties going
+    // to the symbol first in the universe), the symbols above or below a value, and the symbols both or either
+    // filter passes
+    Term top(Term factor, unsigned int n);
+    Term bottom(Term factor, unsigned int n);
+    Term greater_than(Term factor, double value);
+    Term less_than(Term factor, double value);
+    Term all_of(Term first, Term second);
+    Term any_of(Term first, Term second);
+
+    // Classifier numbering the quantile of each symbol's value from 0 (the lowest) to bins - 1
+    Term quantiles(Term factor, unsigned int bins);
+
+    // Adds a column to the output, holding the values of the term
+    void column(const std::string& name, Term term);
+    // Only output the symbols the filter passes, rather than every symbol
+    void screen(Term filter);
+
+    // Number of distinct terms declared, after deduplication
+    size_t size() const { return nodes.size(); }
+    // The fields of the panel the pipeline reads
+    const std::vector<std::string>& fields() const { return panel_fields; }
+    // Number of bars before the last one the pipeline reads
+    unsigned int lookback() const;
+
+    // Computes the output as of the last row of the panel, which must hold the pipeline's fields. Throws if no
+    // column has been added.
+    PipelineOutput run(const Panel& panel) const;
+    // Computes the output as of the data manager's current time, drawing a forward filled panel long enough for
+    // the lookback out of its history
+    PipelineOutput run(DataManager& data, const std::vector<std::string>& symbols) const;
+
+private:
+    // The kinds of terms
+    enum Op {LATEST, RETURNS, MOVING_AVERAGE, VOLATILITY, ADD, SUBTRACT, DIVIDE, RANK, ZSCORE, TOP, BOTTOM,
+             GREATER_THAN, LESS_THAN, ALL_OF, ANY_OF, QUANTILES};
+    // A term of the graph. Its inputs are terms declared before it, so the terms are in an order they can be
+    // computed in.
+    struct Node {
+        Op op;
+        std::vector<size_t> inputs;
+        // The position of the field among the pipeline's fields, for the terms on the panel
+        size_t field = 0;
+        unsigned int window = 0;
+        double parameter = 0;
+    };
+
+    // Adds the node, or returns the one already declared with the same kind, inputs and parameters
+    Term declare(const Node& node);
+    // Declares a term on a field of the panel
+    Term on_field(Op op, const std::string& field, unsigned int window);
+    // Checks that the term was declared by this pipeline
+    size_t check(Term term) const;
+    // Computes one node over the panel into out, given the values of the nodes before it
+    void compute(const Node& node, const Panel& panel, const std::vector<size_t>& field_indices,
+                 const std::vector<std::vector<double>>& computed, std::vector<double>& out) const;
+
+    std::vector<Node> nodes;
+    // The key of each node, for deduplication
+    std::unordered_map<std::string, size_t> keys;
+    std::vector<std::string> panel_fields;
+    // The names and terms of the columns, and the screen (if any)
+    std::vector<std::pair<std::string, size_t>> columns;
+    bool screened = false;
+    size_t screen_term = 0;
+};
+
+#endif //BACKTESTER_PIPELINE_HPP
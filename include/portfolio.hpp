@@ -9,6 +9,7 @@
 // Custom class includes
 #include "events.hpp"
 #include "constants.hpp"
+#include "checkpoint.hpp"
 
 // Class for the Portfolio object which keeps track of holdings and positions for the strategy. This will
 // receive market events and fill events passed in to it by the Strategy event loop, which will be used to recalculate
@@ -30,6 +31,13 @@ public:
     // Takes a fill event and uses it to update the positions and holdings for a specific stock. The fill event comes
     // from the execution handler and contains a buy or sell quantity that has already been calculated and optimized.
     void update_fill(const events::FillEvent& event);
+    // Takes every fill of a rebalance at once, updating the positions and holdings for each of them and then
+    // recalculating the returns a single time.
+    void update_fills(const events::FillsEvent& event);
+
+    // Writes the holdings and positions, both current and historical, into a checkpoint and reads them back
+    void write_checkpoint(checkpoint::Writer& writer) const;
+    void read_checkpoint(checkpoint::Reader& reader);
 
     // The maps of the positions at their respective Bloomberg datetimes (quantities of each stock)
     std::map<BloombergLP::blpapi::Datetime, std::unordered_map<std::string, int>> all_positions;
@@ -40,6 +48,8 @@ public:
 
 private:
 
+    // Moves the filled quantity and its costs into the positions and holdings, without recalculating the returns
+    void apply_fill(const events::FillEvent& event);
     // Writes the current holdings and current positions into their respective all_holdings maps
     void push_holdings_and_positions(const BloombergLP::blpapi::Datetime& date);
     // Calculates total holdings, returns, and equity curve
@@ -0,0 +1,49 @@
+#ifndef BACKTESTER_REPLAY_HPP
+#define BACKTESTER_REPLAY_HPP
+// STL includes
+#include <atomic>
+#include <thread>
+// Project includes
+#include "dataretriever.hpp"
+#include "clock.hpp"
+
+// Plays a recorded tick file back through a RealTimeDataHandler, exactly as if the ticks were arriving on a live
+// subscription, so a LiveStrategy can be run and profiled off-hours. The file is a CSV with one tick per line:
+//
+//      datetime,symbol,last,bid,ask,bid_size,ask_size,volume
+//      2019-01-31 09:30:00.125,IBM US EQUITY,134.2,134.19,134.21,300,500,12000
+//
+// Empty fields are treated as not received, so a quote update can leave the last price blank and only trades (rows
+// with a last price) produce MarketEvents. A header line is skipped, as are symbols which are not in the quote book.
+class TickReplayer {
+public:
+    // Reads the whole file into memory up front, so the replay thread does no parsing while it is timed
+    TickReplayer(const std::string& filepath, const QuoteBook& book);
+    // Stops the replay thread if it is still running
+    ~TickReplayer();
+
+    // Starts the replay thread, which paces the ticks by the clock and queues a StopEvent after the last one
+    void start(RealTimeDataHandler* handler, ReplayClock* clock);
+
+    // Whether the file held any ticks for the subscribed symbols
+    bool empty() const { return ticks.empty(); }
+    // The time of the first tick, which is where the replay clock should start
+    const BloombergLP::blpapi::Datetime& first_time() const { return ticks.front().update.time; }
+
+private:
+    // One recorded update, already resolved to the symbol's index in the quote book
+    struct Tick {
+        size_t index;
+        Quote update;
+        unsigned fields;
+    };
+
+    // The body of the replay thread
+    void play(RealTimeDataHandler* handler, ReplayClock* clock);
+
+    std::vector<Tick> ticks;
+    std::thread worker;
+    std::atomic<bool> stopping{false};
+};
+
+#endif //BACKTESTER_REPLAY_HPP
@@ -0,0 +1,94 @@
+#ifndef BACKTESTER_RESULTSINK_HPP
+#define BACKTESTER_RESULTSINK_HPP
+// Bloomberg includes
+#include "bloombergincludes.hpp"
+// STL includes
+#include <condition_variable>
+#include <fstream>
+#include <initializer_list>
+#include <mutex>
+#include <thread>
+
+// Collects the results of a run (equity, returns, trades, positions, ...) into named streams of typed rows and writes
+// them out on a background thread. Each stream has a fixed set of numeric columns and optionally a text label (such
+// as the symbol of a trade). Pushing a row only appends it to an in-memory buffer, so the simulation thread never
+// waits on a file; the writer thread swaps the buffer out whenever enough rows have built up (or a second has passed)
+// and writes each stream's rows with one large write per file. Every stream is written to <directory>/<name>.csv
+// and/or to <directory>/<name>.bin, a compact binary form with the layout:
+//
+//      header:     "BTRS", uint32 version, uint32 number of columns, then each column name as uint32 length + chars
+//      each row:   int64 milliseconds since epoch, uint32 label length + chars, then one double per column
+//
+class ResultSink {
+public:
+    // Output formats, which can be combined
+    static const unsigned int CSV = 1;
+    static const unsigned int BINARY = 2;
+
+    // Builds the sink writing into the given directory. When appending, the rows are added onto the end of any files
+    // already there (e.g. when extending a previous run) rather than replacing them. The writer thread wakes to write
+    // whenever flush_rows rows are waiting.
+    explicit ResultSink(const std::string& directory, unsigned int formats = CSV | BINARY, bool append = false,
+                        size_t flush_rows = 4096);
+    // Writes out every row still waiting and stops the writer thread
+    ~ResultSink();
+
+    // Declares a stream and its columns. Streams should be added before the run starts.
+    void add_stream(const std::string& name, const std::vector<std::string>& columns, bool labelled = false);
+    // Whether a stream of the given name has been added
+    bool has_stream(const std::string& name) const;
+
+    // Queues a row onto a stream, with one value per column of the stream. Throws if the stream does not exist or
+    // the number of values is wrong.
+    void push(const std::string& stream, const BloombergLP::blpapi::Datetime& time,
+              std::initializer_list<double> values, const std::string& label = "");
+
+    // Blocks until every row pushed so far has been written. Only for the end of a run; the simulation should
+    // otherwise leave the writing to the background thread.
+    void flush();
+
+private:
+    // A declared stream and its open files
+    struct Stream {
+        std::string name;
+        std::vector<std::string> columns;
+        bool labelled;
+        std::ofstream csv, binary;
+    };
+    // A queued row. Its values live in the shared values buffer, starting at the offset.
+    struct Row {
+        size_t stream;
+        BloombergLP::blpapi::Datetime time;
+        std::string label;
+        size_t offset;
+    };
+
+    // The body of the writer thread
+    void write_loop();
+    // Formats and writes out a batch of rows, opening the files of any stream being written for the first time
+    void write_rows(const std::vector<Row>& rows, const std::vector<double>& values);
+    // Opens the files of a stream, writing their headers if they are new
+    void open_files(Stream& stream);
+
+    const std::string directory;
+    const unsigned int formats;
+    const bool append;
+    const size_t flush_rows;
+
+    // The streams, which are only added to before the run, and their lookup by name
+    std::vector<std::unique_ptr<Stream>> streams;
+    std::unordered_map<std::string, size_t> stream_indices;
+
+    // Rows waiting to be written, guarded by the mutex. The lock is only ever held to add to or swap out these
+    // buffers, never while writing.
+    std::mutex mtx;
+    std::condition_variable wake, written;
+    std::vector<Row> pending_rows;
+    std::vector<double> pending_values;
+    // Counts of rows pushed and written, which flush waits to become equal
+    unsigned long long pushed = 0, flushed = 0;
+    bool flush_requested = false, stopping = false;
+    std::thread writer;
+};
+
+#endif //BACKTESTER_RESULTSINK_HPP
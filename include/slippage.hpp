@@ -9,6 +9,7 @@
 // STL includes
 #include <random>
 #include <chrono>
+#include <cmath>
 // Custom class includes
 #include "constants.hpp"
 
@@ -17,6 +18,8 @@
 struct Slippage {
     // Returns a cost of slippage based on the size of an order
     static double get_slippage(double order_cost);
+    // Returns the mean of the slippage get_slippage samples for the order, for runs which must be repeatable
+    static double get_expected_slippage(double order_cost);
 };
 
 #endif //BACKTESTER_SLIPPAGE_HPP
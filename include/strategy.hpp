@@ -9,6 +9,7 @@
 // STL includes
 #include <chrono>
 #include <ctime>
+#include <typeinfo>
 // IO includes
 #include <iostream>
 #include <fstream>
@@ -20,6 +21,15 @@
 #include "data.hpp"
 #include "portfolio.hpp"
 #include "execution.hpp"
+#include "clock.hpp"
+#include "checkpoint.hpp"
+#include "resultsink.hpp"
+#include "logger.hpp"
+#include "notifier.hpp"
+#include "instrumentation.hpp"
+#include "analytics.hpp"
+#include "indicators.hpp"
+#include "pipeline.hpp"
 
 // Base Strategy class to be inherited by all strategies.
 //
@@ -45,25 +55,102 @@ public:
 
     // Function to order a target percentage of stocks
     void order_target_percent(const std::string& symbol, double percent);
+    // Function to order target percentages of several stocks together as one rebalance, which prices and revalues
+    // the portfolio once rather than once per stock. Throws if a symbol is not one of the strategy's symbols.
+    void order_target_percents(const std::unordered_map<std::string, double>& percents);
 
     // Public portfolio so it can be accessed by graphing components
     Portfolio portfolio;
+    // Performance statistics, updated on every market event and fill so they can be read at any time while running
+    Analytics analytics;
 
     // Runs the strategy itself, should be called on a new thread
     virtual void run()=0;
 
-    // Sends a message to Slack
+    // Sends a message to Slack, or to whatever sink notify_to set. The message is only queued onto the notifier,
+    // so it can be called from inside the event loop without holding it up.
     void message(const std::string& message);
+    // Sends the strategy's messages to the sink instead of Slack
+    void notify_to(std::unique_ptr<NotificationSink> sink);
+    // Where to dump the instrumentation as JSON at the end of a run, alongside the report printed to the console.
+    // Only has an effect when built with BACKTESTER_INSTRUMENTATION.
+    void instrument_to(const std::string& filepath);
+    // Measures beta, alpha, correlation, tracking error and information ratio against the price of the symbol, in
+    // the same run rather than by running a benchmark strategy alongside. Can be called once for each of several
+    // benchmarks, before running. A symbol the strategy trades is priced by the market events; any other has its
+    // prices pulled once, up front, where the strategy's data allows (see benchmark_series). The first benchmark is
+    // the one the strategy's own analytics compare against.
+    void compare_to(const std::string& symbol);
+    // The statistics against one of the benchmarks, throwing if the strategy is not compared against it
+    PerformanceStats benchmark_stats(const std::string& symbol) const;
+    // Starts recording results into the directory on a background thread, with the standard equity, returns,
+    // trades and positions streams (see result_streams). Fills are recorded into the trades stream automatically.
+    // When appending, the rows go onto the end of the files from a previous run.
+    void record_results(const std::string& directory, bool append = false);
     // Saves and loads the current context, symbolspecifics, and portfolio data
     void save_state(const std::string& filepath);
     void load_state(const std::string& filepath);
 
+    // Writes a binary checkpoint of the complete engine state: the portfolio with its history, the context and
+    // symbolspecifics, the simulated time, and every pending event on the STACK and HEAP.
+    void save_checkpoint(const std::string& filepath);
+    // Restores the engine state from a checkpoint, so the run picks up where the checkpoint was taken. The strategy
+    // must be constructed the same way as the one which wrote it, so that its scheduled functions line up with the
+    // ones in the checkpoint. Call before run.
+    void load_checkpoint(const std::string& filepath);
+    // While running, writes a checkpoint to the file whenever the given number of events have been processed
+    // since the last one and the STACK is empty.
+    void checkpoint_every(const std::string& filepath, unsigned long events);
+    // Extends a finished run to this strategy's (later) end date: restores the state from the previous run's final
+    // checkpoint and keeps only the events after the time it stopped, so only the new bars are simulated. The
+    // strategy should be constructed to start at the checkpoint's time (see checkpoint::read_summary), so that only
+    // the new data is pulled. Throws if the strategy or its parameters have changed. Call before run.
+    void extend_checkpoint(const std::string& filepath);
+
+    // Hash identifying the strategy and its parameters: its type, symbols, capital, the number of scheduled
+    // functions, its version, and its context and symbolspecifics as they were before running. Checkpoints are only
+    // restored into a strategy with the same fingerprint.
+    const std::string& fingerprint();
+
     // Instances of the daterules for scheduling functions
     const DateRules date_rules;
     const TimeRules time_rules;
 protected:
-    // Functions for logging and messaging (one goes to console, other goes to Slack)
+    // Functions for logging and messaging (one goes to console, other goes to Slack). Logging goes through the
+    // asynchronous logger at the current simulated time, at INFO unless another level is given; use the BT_ macros
+    // in logger.hpp instead where building the message is itself costly.
     void log(const std::string& message);
+    void log(logging::Level level, const std::string& message);
+    // Records a fill into the trades stream, if recording results
+    void record_fill(const events::FillEvent& fill);
+    // Takes the portfolio as of the market event into the analytics, and into those against each benchmark
+    void update_analytics(const events::MarketEvent& event);
+    // Prints the analytics, followed by the comparison against every benchmark after the first
+    void report(std::ostream& out) const;
+    // The prices of a symbol the strategy does not trade, from before the start to the end, for comparing against.
+    // Throws by default, for strategies with no prices beyond their market events.
+    virtual std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> benchmark_series(const std::string& symbol);
+    // Keeps rolling indicators over the window for every symbol, updated by the run loops on each market event. The
+    // set lives as long as the strategy and is checkpointed with it, so call this in the constructor.
+    Indicators& track_indicators(unsigned int window, unsigned int ema_span = 0);
+
+    // Write and read the state held by the strategy into a checkpoint. Derived strategies with more state to keep
+    // extend these, calling the base versions first.
+    virtual void write_checkpoint(checkpoint::Writer& writer);
+    virtual void read_checkpoint(checkpoint::Reader& reader);
+    // Rebuilds the ScheduledEvent of the scheduled function with the given number at the given time
+    virtual std::unique_ptr<events::Event> scheduled_event(uint32_t schedule_id,
+                                                          const BloombergLP::blpapi::Datetime& when) = 0;
+    // Called by the run loops after every event, writing the periodic checkpoint when it is due
+    void count_checkpoint();
+    // Called just before a periodic checkpoint is written, for strategies holding state which another thread adds to
+    virtual void before_checkpoint() {}
+    // The number of functions the strategy has scheduled, part of the fingerprint
+    virtual size_t schedule_size() const = 0;
+
+    // Version of the strategy's logic, part of the fingerprint. Change it when changing the trading logic so that
+    // checkpoints of the old logic are not extended with the new one.
+    std::string strategy_version;
 
     const unsigned int initial_capital;
     BloombergLP::blpapi::Datetime start_date, end_date, current_time;
@@ -77,13 +164,31 @@ protected:
     bool running = false;
     // Tells whether to message status at end of run
     bool sendStatusMessage = false;
+    // Delivers messages on a background thread, started with a Slack sink on the first message if not set
+    std::unique_ptr<Notifier> notifier;
+    // Where the instrumentation is dumped, if anywhere
+    std::string instrumentationFileLocation;
+    // The benchmarks compared against, in the order they were added
+    std::vector<BenchmarkOverlay> benchmarks;
+    // Every set of indicators being tracked
+    std::vector<std::unique_ptr<Indicators>> indicator_sets;
+    // Where the results of the run are pushed to be written, if recording them
+    std::unique_ptr<ResultSink> results;
     // Should it use the save? If yes, this string is the file path. If no, this string is empty
     std::string saveFileLocation;
+    // Whether the state came from a checkpoint, in which case the run continues it rather than starting afresh
+    bool restored = false;
+    // Where and how often to write checkpoints while running (never if the interval is 0)
+    std::string checkpointFileLocation;
+    unsigned long checkpoint_interval = 0, events_since_checkpoint = 0;
 
     // STACK event queue, who must be empty for the HEAP event list to continue to run
     std::queue<std::unique_ptr<events::Event>> stack_eventqueue;
     // HEAP event list, to be run in order and simulate a moving calendar
     std::list<std::unique_ptr<events::Event>> heap_eventlist;
+private:
+    // The fingerprint, computed the first time it is needed (at the latest when the run starts)
+    std::string strategy_fingerprint;
 };
 
 
@@ -97,11 +202,28 @@ public:
             const BloombergLP::blpapi::Datetime& end_date,
              const std::string& p_saveFileLocation = "",
              const std::string& backtest_type = "HISTORICAL");
+    // Builds a Strategy which runs against a generated market (see SyntheticDataManager) instead of Bloomberg data,
+    // so it can be run without a terminal, e.g. by the benchmarks
+    Strategy(const std::vector<std::string>& symbol_list,
+             unsigned int initial_capital,
+             const BloombergLP::blpapi::Datetime& start_date,
+             const BloombergLP::blpapi::Datetime& end_date,
+             const SyntheticMarket& market);
+    // Builds a Strategy on a data manager shared with other strategies, as handed out by StrategyHost::data, to be
+    // run by the host. Only the functions it schedules go on its HEAP: the host feeds it the market events.
+    Strategy(const std::vector<std::string>& symbol_list,
+             unsigned int initial_capital,
+             const BloombergLP::blpapi::Datetime& start_date,
+             const BloombergLP::blpapi::Datetime& end_date,
+             std::shared_ptr<DataManager> shared_data);
 
+    // Runs the strategy on its own. Throws for strategies on a shared data manager, which their host runs.
     void run() override;
 
     // Turns on performance reporting
     void turnOnSlackPerformanceReporting();
+    // Books the slippage of every fill at its expected value instead of sampling it, so the run is repeatable
+    void use_expected_slippage() { execution_handler.use_expected_slippage(); }
 
     // Functions to schedule
     void check();
@@ -110,18 +232,63 @@ public:
     // to this strategy class on the HEAP event list. Then, the function is called at a specific simulated date.
     void schedule_function(std::function<void(Strategy*)> func, const DateRules& dateRules, const TimeRules& timeRules);
 
+    // Runs the pipeline over the strategy's symbols every trading day at the open, so its output is ready for the
+    // functions scheduled then. Functions scheduled for the same time run in the order they were scheduled, so attach
+    // the pipeline before scheduling them.
+    void attach_pipeline(Pipeline pipeline);
+    // The output of the attached pipeline for the current day, computed now if it has not been yet (as when the run
+    // was restored from a checkpoint during the day). Throws if no pipeline is attached.
+    const PipelineOutput& pipeline_output();
+
     // GTest friend class
     friend class StrategyFixture_schedule_functions_Test;
     friend class StrategyFixture_run_Test;
+    // The host drives the run one time at a time
+    friend class StrategyHost;
 
 protected:
     // The Data Manager
     std::shared_ptr<DataManager> data;
+
+    // Checkpoints also hold the position of the intraday bar stream
+    void write_checkpoint(checkpoint::Writer& writer) override;
+    void read_checkpoint(checkpoint::Reader& reader) override;
+    // Pulls the benchmark's prices through the data manager
+    std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> benchmark_series(const std::string& symbol) override;
+    std::unique_ptr<events::Event> scheduled_event(uint32_t schedule_id,
+                                                  const BloombergLP::blpapi::Datetime& when) override;
+    size_t schedule_size() const override { return scheduled_functions.size(); }
 private:
-    // Type of the strategy ("HISTORICAL" only one supported currently)
+    // The parts of run(): getting ready to run, processing one event, and reporting on the run at the end
+    void start_run();
+    void process(events::Event& event);
+    void finish_run();
+    // Processes the market event (if any) and then the events on the HEAP up to the time, each followed by whatever
+    // it puts on the STACK, for a host moving every strategy through the time together
+    void step(events::MarketEvent* market, const BloombergLP::blpapi::Datetime& time);
+    // Processes the STACK until it is empty
+    void drain_stack();
+
+    // Every function scheduled, numbered in the order they were scheduled
+    std::vector<std::function<void(Strategy*)>> scheduled_functions;
+    // Type of the strategy ("HISTORICAL" for daily bars, "INTRADAY" for minute bars, "SYNTHETIC" for generated bars,
+    // "SHARED" for a strategy run by a StrategyHost)
     const std::string backtest_type;
+    // The data manager when running an intraday backtest, which streams bars onto the HEAP as the run progresses
+    IntradayDataManager* intraday_data = nullptr;
     // Execution Handler to manage signal and order events
     ExecutionHandler execution_handler;
+    // The attached pipeline, its latest output, and the day it was computed on as YYYYMMDD (0 before it has run)
+    std::unique_ptr<Pipeline> pipeline;
+    PipelineOutput pipeline_results;
+    int pipeline_day = 0;
+};
+
+// Strict weak ordering on Datetimes for ordered containers, consistent with date_funcs::is_greater
+struct date_less {
+    inline bool operator()(const BloombergLP::blpapi::Datetime& first, const BloombergLP::blpapi::Datetime& second) const {
+        return date_funcs::is_greater(second, first);
+    }
 };
 
 // The class for the live-updating strategy backtest. Its constructor will be the exact same as the strategy one, so
@@ -136,25 +303,77 @@ public:
 
     // This function runs on a separate thread from the data receiver, allowing the user to use subscription
     // data from Bloomberg with a mutex to append to the heap from one thread and read from it (and pop front)
-    // from the other. Has a specially built live data manager, retriever, and handler.
+    // from the other. Has a specially built live data manager, retriever, and handler. When there is nothing
+    // to process, the thread sleeps until new data arrives or the next event on the HEAP is due.
     void run() override;
+    // Ends the run from another thread. The event loop is woken so it finishes straight away, after the event it
+    // is processing (if any), rather than when the next event comes in.
+    void stop();
 
     // Functions to schedule
     void check();
 
+    // Turns on conflation of the live feed, so that when the event loop falls behind only the latest price per
+    // symbol is kept and a burst of ticks is processed as one MarketEvent. Call before run.
+    void conflate_ticks(bool conflate = true);
+
+    // Sets the real time fields subscribed to for every symbol (LAST_PRICE by default). Subscribing to BID and ASK
+    // lets the execution handler fill orders across the live spread. Call before run.
+    void subscribe_fields(const std::vector<std::string>& fields);
+
+    // Runs the strategy against ticks recorded in a CSV file (see TickReplayer) instead of the live subscription,
+    // timed by a simulated clock starting at the first tick. A speed of 1 replays in real time, N replays N times
+    // faster, and 0 replays as fast as the event loop can take the ticks. The run ends after the last tick, and
+    // reports the sustained ticks per second and the latency from each tick's arrival to its processing. Call
+    // before run.
+    void replay(const std::string& filepath, double speed = 0);
+
     // Schedules member functions in a similar way to Strategy. The only difference is that the market events added
     // may be inserted before and after this scheduled function, rather than simply the scheduled function
     // being built after all market events.
     void schedule_function(std::function<void(LiveStrategy*)> func, const DateRules& dateRules, const TimeRules& timeRules);
 
 protected:
+    // Returns a copy of the latest live quote for the symbol (all zeroes if it has none yet)
+    Quote quote(const std::string& symbol);
+
     // The data manager which grabs intraday (minute-level) data up to 140 days into the past
     std::shared_ptr<DataManager> data;
+
+    // Adds the live ticks still queued to the base state, so none are lost across a restart
+    void write_checkpoint(checkpoint::Writer& writer) override;
+    void read_checkpoint(checkpoint::Reader& reader) override;
+    // Drains the ticks the feed has received into the tick list, so the checkpoint holds them too
+    void before_checkpoint() override;
+    std::unique_ptr<events::Event> scheduled_event(uint32_t schedule_id,
+                                                  const BloombergLP::blpapi::Datetime& when) override;
+    size_t schedule_size() const override { return scheduled_functions.size(); }
 private:
+    // Moves the ticks waiting in the feed's conflation buffer and buffer queue into the tick list. Needs the mutex.
+    void drain_feed();
+
+    // Every function scheduled, numbered in the order they were scheduled
+    std::vector<std::function<void(LiveStrategy*)>> scheduled_functions;
     // The mutex which blocks different threads to keep live data feed containers thread safe
     pthread_mutex_t mtx;
+    // Condition variable signalled by the live data feed so the event loop can sleep while there is nothing to do
+    pthread_cond_t cond;
+    // Set by stop, under the mutex
+    bool stop_requested = false;
+    // The source of the current time, the wall clock unless replaying. Declared before the live data so any
+    // replay thread using it has stopped before it is destroyed.
+    std::unique_ptr<Clock> clock;
+    // The recorded tick file to replay and the replay speed, if replaying
+    std::string replay_file;
+    double replay_speed = 0;
     // A live data handler which writes to the event heap
     std::unique_ptr<RealTimeDataRetriever> live_data;
+    // Live MarketEvents drained from the data feed, ordered by datetime. These are kept apart from the HEAP event
+    // list (which holds the scheduled functions) so inserting a tick is logarithmic rather than a scan over every
+    // pending scheduled event, and is constant time when ticks arrive in order. The run loop merges the two.
+    std::multimap<BloombergLP::blpapi::Datetime, std::unique_ptr<events::Event>, date_less> tick_eventlist;
+    // The fields subscribed to on the live feed
+    std::vector<std::string> subscription_fields = {realtime_fields::LAST_PRICE};
     // Execution Handler to manage signal and order events
     ExecutionHandler execution_handler;
 };
@@ -178,9 +397,10 @@ namespace events {
 //
 // @member function        A reference to the strategy's function which is to be called upon event consumption
 // @member instance        A reference to the strategy itself so its member function can be called
+// @member schedule_id     (inherited) The number of the function in the strategy's schedule, for checkpoints
 //
     template <class T>
-    struct ScheduledEvent : public Event {
+    struct ScheduledEvent : public ScheduledEventBase {
         std::function<void(T*)> function;
         T* instance;
 
@@ -190,8 +410,9 @@ namespace events {
         }
 
         // Constructor for the ScheduledEvent
-        ScheduledEvent(std::function<void(T*)> p_func, T* p_strat, const BloombergLP::blpapi::Datetime &p_when) :
-            Event("SCHEDULED", p_when),
+        ScheduledEvent(std::function<void(T*)> p_func, T* p_strat, const BloombergLP::blpapi::Datetime &p_when,
+                       uint32_t p_schedule_id = 0) :
+            ScheduledEventBase(p_schedule_id, p_when),
             function(std::move(p_func)),
             instance(p_strat) {}
 
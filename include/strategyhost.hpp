@@ -0,0 +1,79 @@
+#ifndef BACKTESTER_STRATEGYHOST_HPP
+#define BACKTESTER_STRATEGYHOST_HPP
+// Bloomberg includes
+#include "bloombergincludes.hpp"
+// STL includes
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+// Custom class includes
+#include "events.hpp"
+#include "data.hpp"
+#include "strategy.hpp"
+
+// Runs many strategies over one stream of market data. The host pulls (or generates) the data for its symbols and
+// builds the MarketEvents once, and the strategies are built on its data manager, so they share the history behind
+// it and what it has memoized, rather than each pulling the same data and building the same events for itself.
+//
+// The host moves every strategy through time together: at each time at which there is a market event or anything
+// on a strategy's HEAP, it hands the market event to every strategy and then lets each process its own events at
+// that time, in the order a strategy run on its own would process them. Strategies only share the data manager and
+// the market events, which they only read, so the strategies at a time can be processed on several threads at once.
+//
+// Hosted strategies cannot be checkpointed, as their HEAPs do not hold the market events, so adding one which is set
+// to checkpoint throws, and a hosted strategy never writes the checkpoints it is asked for.
+class StrategyHost {
+public:
+    // Generates the market for the symbols once, as SyntheticDataManager::fillHistory does for a Strategy
+    StrategyHost(std::vector<std::string> symbols,
+                 const BloombergLP::blpapi::Datetime& start,
+                 const BloombergLP::blpapi::Datetime& end,
+                 const SyntheticMarket& market);
+    // Pulls the daily closes of the symbols from Bloomberg once, as HistoricalDataManager::fillHistory does for a
+    // Strategy
+    StrategyHost(std::vector<std::string> symbols,
+                 const BloombergLP::blpapi::Datetime& start,
+                 const BloombergLP::blpapi::Datetime& end);
+
+    // The data manager to build the strategies on, with Strategy's shared data constructor
+    const std::shared_ptr<DataManager>& data() const { return shared_data; }
+    // The symbols the market events hold prices for
+    const std::vector<std::string>& symbols() const { return symbol_list; }
+
+    // Takes on the strategy, which must be built on the host's data manager and trade only the host's symbols, and
+    // returns it so its results can be read after the run. Add every strategy before running.
+    template <class T>
+    T& add(std::unique_ptr<T> strategy) {
+        T& added = *strategy;
+        adopt(std::move(strategy));
+        return added;
+    }
+    size_t size() const { return strategies.size(); }
+    Strategy& operator[](size_t i) { return *strategies[i]; }
+
+    // Runs every strategy to the end of the market events and of their own schedules, processing the strategies at
+    // each time on the given number of threads. Runs on one thread when built with BACKTESTER_INSTRUMENTATION, which
+    // can only record from one.
+    void run(unsigned int threads = 1);
+
+private:
+    // Checks the strategy is built on the host and takes it on
+    void adopt(std::unique_ptr<Strategy> strategy);
+    // The earliest time of the next market event and of every strategy's HEAP, returning false if there is none
+    bool next_time(std::list<std::unique_ptr<events::Event>>::iterator market,
+                   BloombergLP::blpapi::Datetime& time) const;
+
+    const std::vector<std::string> symbol_list;
+    // The time the strategies have reached, which the shared data manager reads. Declared before the data manager,
+    // which holds a pointer to it.
+    BloombergLP::blpapi::Datetime current_time;
+    std::shared_ptr<DataManager> shared_data;
+    // The market events of every symbol, in order
+    std::list<std::unique_ptr<events::Event>> market_events;
+    // Bars per year, for the strategies' analytics
+    double periods = 252;
+    std::vector<std::unique_ptr<Strategy>> strategies;
+};
+
+#endif //BACKTESTER_STRATEGYHOST_HPP
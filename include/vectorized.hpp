@@ -0,0 +1,83 @@
+#ifndef BACKTESTER_VECTORIZED_HPP
+#define BACKTESTER_VECTORIZED_HPP
+// Bloomberg includes
+#include "bloombergincludes.hpp"
+// STL includes
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+// Custom class includes
+#include "events.hpp"
+#include "analytics.hpp"
+#include "panel.hpp"
+
+// Prices of a universe on one calendar, as a dense [time x symbol] matrix stored row by row. A symbol without a
+// price at a time carries its last price forward, and is 0 until its first price.
+struct PriceMatrix {
+    std::vector<std::string> symbols;
+    std::vector<BloombergLP::blpapi::Datetime> times;
+    std::vector<double> prices;
+
+    // The prices of every symbol at the row's time, in the order of the symbols
+    const double* row(size_t time) const { return prices.data() + time * symbols.size(); }
+
+    // Builds the matrix from the market events in a HEAP, such as one filled by a data manager's fillHistory. Other
+    // events are skipped.
+    static PriceMatrix from_events(const std::vector<std::string>& symbols,
+                                   const std::list<std::unique_ptr<events::Event>>& events);
+    // Takes one field of a panel, such as one from DataManager::history_panel, as the prices
+    static PriceMatrix from_panel(const Panel& panel, const std::string& field = "PX_LAST");
+};
+
+// The outcome of a vectorized run
+struct VectorizedResult {
+    // Total holdings and return over the row before it at each row of the prices
+    std::vector<double> equity;
+    std::vector<double> returns;
+    // Positions held at the end, in the order of the symbols
+    std::vector<int> positions;
+    // Totals over the run
+    double commission = 0;
+    double slippage = 0;
+    double traded = 0;
+    unsigned long fills = 0;
+    // The statistics of the run, as the event engine's Analytics would have computed them
+    PerformanceStats stats;
+};
+
+// A second engine for strategies which only set target weights at rebalances. Rather than passing each target
+// through signal, order and fill events, it works through the price matrix row by row: at each rebalance it turns
+// every symbol's target weight into an order against the total holdings as of that row, costs it with the same
+// Slippage and TransactionCosts models as the execution handler, and the equity at every row is the cash plus the
+// positions valued at the row's prices. That makes it orders of magnitude faster for research sweeps.
+//
+// Orders are sized the same way ExecutionHandler::process_rebalance sizes them, from the holdings before any order
+// of the rebalance is filled, which is what the event engine does when a strategy orders with order_target_percents
+// (ordering one symbol at a time, each order sees the commission and slippage of those before it). Slippage is its
+// expected value unless random slippage is asked for, so that runs are repeatable.
+class VectorizedBacktest {
+public:
+    // Gets the weights for the row into weights, which holds the last targets set, returning whether to rebalance
+    typedef std::function<bool(size_t row, const PriceMatrix& prices, double* weights)> WeightFunction;
+
+    VectorizedBacktest(PriceMatrix prices, unsigned int initial_capital, bool random_slippage = false);
+
+    // Runs with the weights the function asks for at each row. Running does not change the backtest, so several
+    // runs can share one, e.g. from different threads.
+    VectorizedResult run(const WeightFunction& weights, double periods_per_year = 252) const;
+    // Runs with a matrix of weights, one row of weights per symbol for each of the rows given to rebalance at, in
+    // increasing order
+    VectorizedResult run(const std::vector<size_t>& rows, const std::vector<double>& weights,
+                         double periods_per_year = 252) const;
+
+    const PriceMatrix& prices() const { return matrix; }
+
+private:
+    const PriceMatrix matrix;
+    const unsigned int initial_capital;
+    const bool random_slippage;
+};
+
+#endif //BACKTESTER_VECTORIZED_HPP
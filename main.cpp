@@ -2,19 +2,34 @@
 // Created by Evan Kirkiles on 9/25/2018.
 //
 
+#include <fstream>
 #include <iostream>
 
 #include "strategy/custom/src/momentum1.hpp"
 #include "strategy/custom/src/basic_algo.hpp"
 
-// Main function
+// Main function. Pass --extend to continue the previous run from its final checkpoint, simulating only the days
+// since it finished, rather than replaying the whole backtest.
 int main(int argc, char* argv[]) {
 
+    // Checkpoint written at the end of every run
+    const std::string checkpointFile = R"(C:\Users\bloomberg\CLionProjects\bloomberg_backtester\saves\checkpoint.bin)";
+    bool extend = argc > 1 && std::string(argv[1]) == "--extend";
+    if (extend && !std::ifstream(checkpointFile).good()) {
+        std::cerr << "No checkpoint to extend at " << checkpointFile << "!" << std::endl;
+        return 1;
+    }
+    // When extending, the backtest only needs to start from where the last one stopped
+    BloombergLP::blpapi::Datetime start = extend ? checkpoint::read_summary(checkpointFile).time :
+            BloombergLP::blpapi::Datetime(2018, 1, 31, 0, 0, 0);
+
     // Run a Basic Algo
-    ALGO_Momentum1 alg(BloombergLP::blpapi::Datetime(2018, 1, 31, 0, 0, 0), date_funcs::get_now(), 1000000);
+    ALGO_Momentum1 alg(start, date_funcs::get_now(), 1000000, extend);
+    if (extend) { alg.extend_checkpoint(checkpointFile); }
 //    alg.message("Beginning live paper trading of momentum algorithm...");
     // Run the algorithm
     alg.run();
+    alg.save_checkpoint(checkpointFile);
 
     return 0;
-}
\ No newline at end of file
+}
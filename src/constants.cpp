@@ -38,6 +38,27 @@ namespace element_names {
     const char* SUBCATEGORY("subcategory");
     const char* MESSAGE("message");
     const char* CODE("code");
+
+    const char* BAR_DATA("barData");
+    const char* BAR_TICK_DATA("barTickData");
+    const char* BAR_TIME("time");
+    const char* BAR_OPEN("open");
+    const char* BAR_HIGH("high");
+    const char* BAR_LOW("low");
+    const char* BAR_CLOSE("close");
+    const char* BAR_VOLUME("volume");
+}
+
+// Field names for real time subscriptions
+namespace realtime_fields {
+    const char* LAST_PRICE("LAST_PRICE");
+    const char* LAST_TRADE("LAST_TRADE");
+    const char* BID("BID");
+    const char* ASK("ASK");
+    const char* BID_SIZE("BID_SIZE");
+    const char* ASK_SIZE("ASK_SIZE");
+    const char* VOLUME("VOLUME");
+    const char* TIME("TIME");
 }
 
 // Names for data in the portfolio
@@ -50,6 +71,14 @@ namespace portfolio_fields {
     const char* EQUITY_CURVE("equity_curve");
 }
 
+// Names of the standard result streams
+namespace result_streams {
+    const char* EQUITY("equity");
+    const char* RETURNS("returns");
+    const char* TRADES("trades");
+    const char* POSITIONS("positions");
+}
+
 // Enums for the date rules specifying types
 namespace date_time_enums {
     const unsigned int EVERY_DAY = 0;
@@ -6,15 +6,84 @@
 #include <include/data.hpp>
 
 #include "data.hpp"
+#include "instrumentation.hpp"
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// Memoized results are only good for the time they were fetched at, so they are all dropped once the clock moves.
+// The request is keyed by its parameters joined with separators that cannot appear in a symbol or field. A miss
+// leaves a future in the memo before fetching without the lock, so other threads neither wait on the fetch for a
+// different request nor fetch the same one twice.
+std::shared_ptr<const std::unordered_map<std::string, SymbolHistoricalData>> DataManager::history(
+        const std::vector<std::string> &symbols, const std::vector<std::string> &fields, unsigned int timeunitsback,
+        const std::string &frequency) {
+    BT_PROBE(HISTORY);
+    std::unique_lock<std::mutex> lock(history_mutex);
+    if (!memoizing) {
+        lock.unlock();
+        return fetch_history(symbols, fields, timeunitsback, frequency);
+    }
+
+    if (!(memoized_time == *currentTime)) {
+        memoized.clear();
+        memoized_time = *currentTime;
+    }
+    std::string key = frequency + '\x1e' + std::to_string(timeunitsback) + '\x1e';
+    for (const std::string& symbol : symbols) { key += symbol + '\x1f'; }
+    key += '\x1e';
+    for (const std::string& field : fields) { key += field + '\x1f'; }
+
+    auto found = memoized.find(key);
+    if (found != memoized.end()) {
+        const auto result = found->second;
+        lock.unlock();
+        return result.get();
+    }
+    std::promise<std::shared_ptr<const std::unordered_map<std::string, SymbolHistoricalData>>> fetched;
+    memoized.emplace(key, fetched.get_future().share());
+    lock.unlock();
+    try {
+        std::shared_ptr<const std::unordered_map<std::string, SymbolHistoricalData>> result =
+                fetch_history(symbols, fields, timeunitsback, frequency);
+        fetched.set_value(result);
+        return result;
+    } catch (...) {
+        // Anyone waiting gets the error too, and the request is forgotten so the next call tries it again
+        fetched.set_exception(std::current_exception());
+        lock.lock();
+        memoized.erase(key);
+        throw;
+    }
+}
+
+// Lays out the (memoized) history as a panel
+Panel DataManager::history_panel(const std::vector<std::string> &symbols, const std::vector<std::string> &fields,
+                                 unsigned int timeunitsback, const std::string &frequency, Panel::Gaps gaps) {
+    return Panel::from_history(symbols, fields, *history(symbols, fields, timeunitsback, frequency), gaps);
+}
+
+// Forgets anything memoized when turned off, so it is not returned once turned back on
+void DataManager::memoize_history(bool enabled) {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    memoizing = enabled;
+    if (!enabled) { memoized.clear(); }
+}
+
+// Empties the memo. Fetches still running finish for whoever is waiting on them, but are not kept.
+void DataManager::clear_history() {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    memoized.clear();
+}
 
 // Constructor that sets up the connection to the Bloomberg Data API so data can be pulled.
 HistoricalDataManager::HistoricalDataManager(BloombergLP::blpapi::Datetime* p_currentTime, int p_correlation_id) :
         DataManager(p_currentTime), dr("HISTORICAL_DATA", p_correlation_id) {}
 
 // Function that builds the Market Events and puts them onto the HEAP event list in chronological order. Does so
-// by first pulling the EOD last price data for the securities to be traded by the algorithm and then generating Market
-// Events for each date. Goes through each symbol's data one entry at a time at the same time, comparing in case of
-// dates not lining up and then catching up the iterators.
+// by first pulling the EOD last price data for the securities to be traded by the algorithm and then merging the
+// dates of every symbol into one calendar of Market Events.
 void HistoricalDataManager::fillHistory(const std::vector<std::string> &symbols,
                                         const BloombergLP::blpapi::Datetime& start,
                                         const BloombergLP::blpapi::Datetime& end,
@@ -23,30 +92,81 @@ void HistoricalDataManager::fillHistory(const std::vector<std::string> &symbols,
     // First retrieve the array of daily end of date prices
     std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> data =
             dr.pullHistoricalData(symbols, start, end);
+    merge_market_events(symbols, *data, location);
+}
+
+// Each symbol's dates are already sorted, so a heap of the symbols ordered by their next date walks the union of the
+// dates in order, taking each symbol's bars once: O(bars log symbols) in all, without looking up any date in another
+// symbol's map. The symbols with a price so far are kept as a list of their own, rebuilt only when one lists. Symbols
+// are left out of the events until their first price, and marked stale at the dates they have no price of their own.
+void HistoricalDataManager::merge_market_events(const std::vector<std::string> &symbols,
+                                                const std::unordered_map<std::string, SymbolHistoricalData> &data,
+                                                std::list<std::unique_ptr<events::Event>>* location) {
+    typedef std::map<BloombergLP::blpapi::Datetime, std::unordered_map<std::string, double>>::const_iterator Cursor;
+    std::vector<Cursor> next(symbols.size()), last(symbols.size());
+    std::vector<size_t> pending;
+    for (size_t j = 0; j < symbols.size(); ++j) {
+        auto found = data.find(symbols[j]);
+        if (found == data.end() || found->second.data.empty()) { continue; }
+        next[j] = found->second.data.begin();
+        last[j] = found->second.data.end();
+        pending.push_back(j);
+    }
+    // Orders the heap so the symbol with the earliest next date is at its front
+    auto later = [&next](size_t first, size_t second) {
+        return date_funcs::is_greater(next[first]->first, next[second]->first);
+    };
+    std::make_heap(pending.begin(), pending.end(), later);
 
-    // Build an iterator off of the first stock's data to get all dates. Then, we can use the dates to build
-    // packaged MarketEvents of multiple symbol data.
-    // Potential data issues: what happens when a stock started trading after start date? Ends before end date?
-    // Also, I don't know how Bloomberg handles missing values, which will be a weird occurrence when it shows up.
-    for (auto i = data->operator[](symbols[0]).data.begin(); i != data->operator[](symbols[0]).data.end(); ++i) {
-        // Placeholder data unordered map which will contain the update information
-        std::unordered_map<std::string, double> temp = {{symbols[0], i->second["PX_LAST"]}};
-        for (int j = 1; j < symbols.size(); ++j) {
-            temp[symbols[j]] = data->operator[](symbols[j]).data[i->first]["PX_LAST"];
+    // The last price of each symbol, whether it has one yet, and the number of the date it was last priced at
+    std::vector<double> prices(symbols.size(), 0.0);
+    std::vector<bool> valid(symbols.size(), false);
+    std::vector<size_t> priced(symbols.size(), 0);
+    std::vector<std::string> listed;
+    size_t listed_count = 0, dates = 0;
+    while (!pending.empty()) {
+        const BloombergLP::blpapi::Datetime date = next[pending.front()]->first;
+        const size_t current = ++dates;
+        bool listing = false;
+        // Take the bar of every symbol at this date, putting each symbol back by its following date
+        while (!pending.empty() && !date_funcs::is_greater(next[pending.front()]->first, date)) {
+            std::pop_heap(pending.begin(), pending.end(), later);
+            const size_t j = pending.back();
+            auto price = next[j]->second.find("PX_LAST");
+            if (price != next[j]->second.end() && !std::isnan(price->second)) {
+                prices[j] = price->second;
+                priced[j] = current;
+                if (!valid[j]) { valid[j] = listing = true; listed_count++; }
+            }
+            if (++next[j] == last[j]) { pending.pop_back(); }
+            else { std::push_heap(pending.begin(), pending.end(), later); }
+        }
+        if (listed_count == 0) { continue; }
+        if (listing) {
+            listed.clear();
+            for (size_t j = 0; j < symbols.size(); ++j) { if (valid[j]) { listed.push_back(symbols[j]); } }
         }
 
+        // Symbols without a price at this date, e.g. after their last bar, carry their last one forward as stale
+        std::unordered_map<std::string, double> temp;
+        std::unordered_set<std::string> stale;
+        temp.reserve(listed_count);
+        for (size_t j = 0; j < symbols.size(); ++j) {
+            if (!valid[j]) { continue; }
+            temp.emplace(symbols[j], prices[j]);
+            if (priced[j] != current) { stale.insert(symbols[j]); }
+        }
         // Now build the Market Event and place it onto the HEAP as a unique ptr
-        location->emplace_back(std::make_unique<events::MarketEvent>(symbols, temp, i->first));
+        location->emplace_back(std::make_unique<events::MarketEvent>(listed, temp, date, std::move(stale)));
     }
 }
 
 // Pulls history data from Bloomberg for a specified number of days before the current date, at a given frequency for
 // set securities and fields. Cannot simply use the data downloaded to build the MarketEvents because that data only
 // contains the last price (PX_LAST) when the algorithm may require other types.
-std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> HistoricalDataManager::history(
+std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> HistoricalDataManager::fetch_history(
             const std::vector<std::string> &symbols, const std::vector<std::string> &fields, unsigned int timeunitsback,
             const std::string &frequency) {
-
     // Find the date N days back from the current dates
     BloombergLP::blpapi::Datetime beginDate = date_funcs::add_seconds(*currentTime, 24 * 60 * 60 * timeunitsback * -1);
 
@@ -55,6 +175,7 @@ std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> Historica
         std::string freq = (frequency == "RECENT") ? "DAILY" : frequency;
         // Simply tunnels the request through to the HistoricalDataRetriever, filling in the end date as the current date of
         // the local pointer to the simulated current date.
+        std::lock_guard<std::mutex> lock(dr_mutex);
         return std::move(dr.pullHistoricalData(symbols, beginDate, *currentTime, fields, freq));
     } else {
         // Temporary object to return
@@ -78,5 +199,317 @@ void HistoricalDataManager::preload(const std::vector<std::string> &symbols, con
     BloombergLP::blpapi::Datetime beginDate = date_funcs::add_seconds(start, 24 * 60 * 60 * maxlookback * -1);
     // Beginning at the found date, pull the historical data into the container
     preloaded_data = std::move(dr.pullHistoricalData(symbols, beginDate, end, fields, frequency));
+    preloaded_end = end;
     preloaded = true;
+    clear_history();
+}
+
+// Preloaded data only covers the symbols and dates it was preloaded for, so anything else is pulled, in one request
+std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> HistoricalDataManager::price_series(
+        const std::string &symbol, const BloombergLP::blpapi::Datetime &start,
+        const BloombergLP::blpapi::Datetime &end) {
+    std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> series;
+    auto take = [&](const SymbolHistoricalData& history) {
+        for (const auto& bar : history.data) {
+            if (date_funcs::is_greater(start, bar.first) || date_funcs::is_greater(bar.first, end)) { continue; }
+            const auto last = bar.second.find("PX_LAST");
+            if (last != bar.second.end()) { series.emplace_back(bar.first, last->second); }
+        }
+    };
+    if (preloaded && !date_funcs::is_greater(end, preloaded_end)) {
+        const auto history = preloaded_data->find(symbol);
+        if (history != preloaded_data->end() && !history->second.data.empty() &&
+            !date_funcs::is_greater(history->second.data.begin()->first, start)) { take(history->second); }
+        if (!series.empty()) { return series; }
+    }
+    const auto pulled = dr.pullHistoricalData({symbol}, start, end);
+    const auto history = pulled->find(symbol);
+    if (history != pulled->end()) { take(history->second); }
+    return series;
+}
+
+// Constructor builds the daily Historical Data Manager as well as a retriever for the intraday bars
+IntradayDataManager::IntradayDataManager(BloombergLP::blpapi::Datetime* p_currentTime, unsigned int p_interval) :
+        HistoricalDataManager(p_currentTime, correlation_ids::INTRADAY_REQUEST_CID),
+        intraday_dr("INTRADAY_DATA", correlation_ids::INTRADAY_REQUEST_CID),
+        interval(p_interval) {}
+
+// Stores the symbols and dates and rewinds the stream to the start day at midnight
+void IntradayDataManager::beginStream(const std::vector<std::string> &symbols,
+                                      const BloombergLP::blpapi::Datetime &start,
+                                      const BloombergLP::blpapi::Datetime &end) {
+    stream_symbols = symbols;
+    next_day = BloombergLP::blpapi::Datetime(start.year(), start.month(), start.day(), 0, 0, 0);
+    stream_end = end;
+    day_bars.clear();
+    day_loaded = false;
+}
+
+// Reloads the bars of the checkpointed day without putting them on the HEAP again
+void IntradayDataManager::resumeStream(const std::vector<std::string> &symbols,
+                                       const BloombergLP::blpapi::Datetime &p_loaded_day,
+                                       const BloombergLP::blpapi::Datetime &end) {
+    beginStream(symbols, p_loaded_day, end);
+    if (hasMoreBars()) { loadDay(nullptr); }
+}
+
+// Days are loaded lazily: only once the event at the front of the HEAP is at or past the first unloaded day
+void IntradayDataManager::streamBars(std::list<std::unique_ptr<events::Event>> *location) {
+    while (hasMoreBars() && (location->empty() || !date_funcs::is_greater(next_day, location->front()->datetime))) {
+        loadDay(location);
+    }
+}
+
+// There are bars left while the next day starts before the end of the stream
+bool IntradayDataManager::hasMoreBars() const {
+    return !stream_symbols.empty() && date_funcs::is_greater(stream_end, next_day);
+}
+
+// Pulls the bars of every symbol for the next day, replacing the previous day's bars, and builds a MarketEvent for
+// each bar close. Bars are stamped with the time they close rather than open, so no bar is seen before it is
+// complete. The HEAP is sorted, so the day's events are merged in with a single walk from its front.
+void IntradayDataManager::loadDay(std::list<std::unique_ptr<events::Event>> *location) {
+    BloombergLP::blpapi::Datetime day_end = date_funcs::add_seconds(next_day, 24 * 60 * 60);
+    if (date_funcs::is_greater(day_end, stream_end)) { day_end = stream_end; }
+
+    // Pull the day's bars and re-key them by close time, while also gathering the closes of every symbol at each time
+    day_bars.clear();
+    clear_history();
+    day_loaded = true;
+    loaded_day = next_day;
+    std::map<BloombergLP::blpapi::Datetime, std::unordered_map<std::string, double>> closes;
+    for (const std::string& symbol : stream_symbols) {
+        SymbolHistoricalData bars = intraday_dr.pullIntradayBars(symbol, next_day, day_end, interval);
+        SymbolHistoricalData& keyed = day_bars[symbol];
+        keyed.symbol = symbol;
+        for (auto& bar : bars.data) {
+            BloombergLP::blpapi::Datetime close_time = date_funcs::add_seconds(bar.first, 60 * interval);
+            closes[close_time][symbol] = bar.second["PX_LAST"];
+            keyed.data[close_time] = std::move(bar.second);
+        }
+    }
+
+    // Merge the day's MarketEvents onto the HEAP, after any events at the same time as each bar
+    if (location) {
+        auto position = location->begin();
+        for (auto& bar : closes) {
+            while (position != location->end() && !date_funcs::is_greater((*position)->datetime, bar.first)) { ++position; }
+            std::vector<std::string> symbols;
+            symbols.reserve(bar.second.size());
+            for (const auto& close : bar.second) { symbols.emplace_back(close.first); }
+            location->insert(position, std::make_unique<events::MarketEvent>(symbols, bar.second, bar.first));
+        }
+    }
+
+    // Move on to the next weekday
+    next_day = date_funcs::add_seconds(next_day, 24 * 60 * 60, true);
+}
+
+// The bars are pulled in one request over the whole range, and re-keyed by close time as loadDay does
+std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> IntradayDataManager::price_series(
+        const std::string &symbol, const BloombergLP::blpapi::Datetime &start,
+        const BloombergLP::blpapi::Datetime &end) {
+    std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> series;
+    SymbolHistoricalData bars = intraday_dr.pullIntradayBars(symbol, start, end, interval);
+    series.reserve(bars.data.size());
+    for (const auto& bar : bars.data) {
+        const auto last = bar.second.find("PX_LAST");
+        if (last == bar.second.end()) { continue; }
+        series.emplace_back(date_funcs::add_seconds(bar.first, 60 * interval), last->second);
+    }
+    return series;
+}
+
+// Returns the latest finished bar of the current day for RECENT requests when every symbol has one, otherwise
+// falls back to daily history
+std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> IntradayDataManager::fetch_history(
+        const std::vector<std::string> &symbols, const std::vector<std::string> &fields, unsigned int timeunitsback,
+        const std::string &frequency) {
+    if (frequency == "RECENT") {
+        std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> toReturn =
+                std::make_unique<std::unordered_map<std::string, SymbolHistoricalData>>();
+        for (const std::string& symb : symbols) {
+            auto bars = day_bars.find(symb);
+            if (bars == day_bars.end()) { break; }
+            // The first bar closing after the current time, so the one before it is the latest finished bar
+            auto after = bars->second.data.upper_bound(*currentTime);
+            if (after == bars->second.data.begin()) { break; }
+            --after;
+            SymbolHistoricalData& latest = (*toReturn)[symb];
+            latest.symbol = symb;
+            latest.data.insert(*after);
+        }
+        if (toReturn->size() == symbols.size()) { return toReturn; }
+    }
+    return HistoricalDataManager::fetch_history(symbols, fields, timeunitsback, frequency);
+}
+
+// Builds the Synthetic Data Manager, which generates nothing until it is filled
+SyntheticDataManager::SyntheticDataManager(BloombergLP::blpapi::Datetime* p_currentTime,
+                                           const SyntheticMarket& p_market) :
+        DataManager(p_currentTime), market(p_market) {}
+
+// Builds the timeline of bar times from the trading calendar, generates every symbol's bars along it, and then puts
+// one MarketEvent per bar time from the start onwards onto the HEAP
+void SyntheticDataManager::fillHistory(const std::vector<std::string> &symbols,
+                                       const BloombergLP::blpapi::Datetime &start,
+                                       const BloombergLP::blpapi::Datetime &end,
+                                       std::list<std::unique_ptr<events::Event>>* location) {
+    BT_PROBE(HISTORY);
+
+    // Holidays can shift a day's bars onto the next trading day, so sort the times and drop any repeats
+    const DateRules calendar(date_funcs::add_seconds(start, -24 * 60 * 60 * static_cast<int>(market.warmup_days)), end);
+    times = calendar.every_day().get_date_times(
+            market.bar_minutes ? TimeRules::every_minute(market.bar_minutes - 1) : TimeRules::market_close());
+    std::sort(times.begin(), times.end(), [](const BloombergLP::blpapi::Datetime& first,
+                                             const BloombergLP::blpapi::Datetime& second) {
+        return date_funcs::is_greater(second, first); });
+    times.erase(std::unique(times.begin(), times.end(), [](const BloombergLP::blpapi::Datetime& first,
+                                                          const BloombergLP::blpapi::Datetime& second) {
+        return !date_funcs::is_greater(first, second) && !date_funcs::is_greater(second, first); }), times.end());
+
+    columns.clear();
+    clear_history();
+    columns.reserve(symbols.size());
+    for (const std::string& symbol : symbols) { columns[symbol] = generate(symbol); }
+
+    // Only the bars at or after the start become MarketEvents
+    std::vector<const Columns*> symbol_columns;
+    symbol_columns.reserve(symbols.size());
+    for (const std::string& symbol : symbols) { symbol_columns.push_back(&columns[symbol]); }
+    for (size_t i = 0; i < times.size(); ++i) {
+        if (date_funcs::is_greater(start, times[i])) { continue; }
+        std::unordered_map<std::string, double> prices;
+        prices.reserve(symbols.size());
+        for (size_t j = 0; j < symbols.size(); ++j) { prices[symbols[j]] = symbol_columns[j]->last[i]; }
+        location->emplace_back(std::make_unique<events::MarketEvent>(symbols, prices, times[i]));
+    }
+}
+
+// Copies out the requested fields of each symbol within the window. Any frequency is answered with the bars as they
+// were generated.
+std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> SyntheticDataManager::fetch_history(
+        const std::vector<std::string> &symbols, const std::vector<std::string> &fields, unsigned int timeunitsback,
+        const std::string& /*frequency*/) {
+    const std::pair<size_t, size_t> bars = window(timeunitsback);
+
+    std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> toReturn =
+            std::make_unique<std::unordered_map<std::string, SymbolHistoricalData>>();
+    for (const std::string& symb : symbols) {
+        const Columns& found = columns_of(symb);
+        SymbolHistoricalData& target = (*toReturn)[symb];
+        target.symbol = symb;
+        for (size_t i = bars.first; i < bars.second; ++i) {
+            std::unordered_map<std::string, double>& bar = target.data[times[i]];
+            for (const std::string& field : fields) {
+                const std::vector<double>* column = column_of(found, field);
+                if (column) { bar[field] = (*column)[i]; }
+            }
+        }
+    }
+    return toReturn;
+}
+
+// Each symbol's column of a field is contiguous, so it is copied down one column of the panel. As in fetch_history,
+// any frequency gets the generated bars. Every symbol has a bar at every time, and a field which is not generated has
+// no value at any of them to carry forward, so both ways of treating gaps give the same panel (with such a field
+// left NaN, as Panel::from_history leaves it).
+Panel SyntheticDataManager::history_panel(const std::vector<std::string> &symbols,
+                                          const std::vector<std::string> &fields, unsigned int timeunitsback,
+                                          const std::string& /*frequency*/, Panel::Gaps /*gaps*/) {
+    BT_PROBE(HISTORY);
+    const std::pair<size_t, size_t> bars = window(timeunitsback);
+
+    Panel panel(symbols, fields, std::vector<BloombergLP::blpapi::Datetime>(times.begin() + bars.first,
+                                                                           times.begin() + bars.second));
+    const size_t width = symbols.size();
+    for (size_t i = 0; i < width; ++i) {
+        const Columns& found = columns_of(symbols[i]);
+        for (size_t f = 0; f < fields.size(); ++f) {
+            const std::vector<double>* column = column_of(found, fields[f]);
+            if (!column) { continue; }
+            double* out = panel.field(f) + i;
+            for (size_t bar = bars.first; bar < bars.second; ++bar, out += width) { *out = (*column)[bar]; }
+        }
+    }
+    return panel;
+}
+
+// Looks the symbol up among the generated columns
+const SyntheticDataManager::Columns& SyntheticDataManager::columns_of(const std::string &symbol) const {
+    auto found = columns.find(symbol);
+    if (found == columns.end()) { throw std::runtime_error("No synthetic data for " + symbol + "!"); }
+    return found->second;
+}
+
+// Matches the field names Bloomberg uses
+const std::vector<double>* SyntheticDataManager::column_of(const Columns &columns, const std::string &field) {
+    if (field == "PX_LAST") { return &columns.last; }
+    if (field == "PX_OPEN") { return &columns.open; }
+    if (field == "PX_HIGH") { return &columns.high; }
+    if (field == "PX_LOW") { return &columns.low; }
+    if (field == "PX_VOLUME") { return &columns.volume; }
+    return nullptr;
+}
+
+// Finds the window of bar times by binary search
+std::pair<size_t, size_t> SyntheticDataManager::window(unsigned int timeunitsback) const {
+    const BloombergLP::blpapi::Datetime beginDate =
+            date_funcs::add_seconds(*currentTime, 24 * 60 * 60 * static_cast<int>(timeunitsback) * -1);
+    auto later = [](const BloombergLP::blpapi::Datetime& first, const BloombergLP::blpapi::Datetime& second) {
+        return date_funcs::is_greater(second, first); };
+    return {std::lower_bound(times.begin(), times.end(), beginDate, later) - times.begin(),
+            std::upper_bound(times.begin(), times.end(), *currentTime, later) - times.begin()};
+}
+
+// A symbol which was filled already has its closes generated, and any other is generated the same way, so it is
+// priced as it would have been had it been traded
+std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> SyntheticDataManager::price_series(
+        const std::string &symbol, const BloombergLP::blpapi::Datetime &start,
+        const BloombergLP::blpapi::Datetime &end) {
+    const auto filled = columns.find(symbol);
+    Columns generated;
+    if (filled == columns.end()) { generated = generate(symbol); }
+    const std::vector<double>& last = filled == columns.end() ? generated.last : filled->second.last;
+
+    std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> series;
+    for (size_t i = 0; i < times.size(); ++i) {
+        if (date_funcs::is_greater(start, times[i]) || date_funcs::is_greater(times[i], end)) { continue; }
+        series.emplace_back(times[i], last[i]);
+    }
+    return series;
+}
+
+// Walks a geometric Brownian motion along the timeline. The random numbers come from a 64-bit Mersenne Twister seeded
+// from the market seed and a hash of the symbol, turned into normals with Box-Muller rather than through
+// std::normal_distribution so the prices are the same whatever the standard library.
+SyntheticDataManager::Columns SyntheticDataManager::generate(const std::string &symbol) const {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : symbol) { hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL; }
+    std::mt19937_64 random(market.seed ^ hash);
+    auto uniform = [&random]() { return ((random() >> 11) + 0.5) * (1.0 / 9007199254740992.0); };
+    auto normal = [&uniform]() {
+        const double radius = std::sqrt(-2 * std::log(uniform()));
+        return radius * std::cos(2 * 3.14159265358979323846 * uniform());
+    };
+
+    // The fraction of a year each bar covers, taking a year as 252 days of 390 trading minutes
+    const double dt = market.bar_minutes ? market.bar_minutes / (252.0 * 390.0) : 1 / 252.0;
+    const double step_drift = (market.drift - market.volatility * market.volatility / 2) * dt;
+    const double step_volatility = market.volatility * std::sqrt(dt);
+
+    Columns generated;
+    for (std::vector<double>* column : {&generated.open, &generated.high, &generated.low, &generated.last,
+                                        &generated.volume}) { column->resize(times.size()); }
+    double price = market.start_price * std::exp(0.5 * normal());
+    for (size_t i = 0; i < times.size(); ++i) {
+        const double open = price;
+        price *= std::exp(step_drift + step_volatility * normal());
+        generated.open[i] = open;
+        generated.last[i] = price;
+        generated.high[i] = std::max(open, price) * (1 + std::abs(normal()) * step_volatility / 2);
+        generated.low[i] = std::min(open, price) * (1 - std::abs(normal()) * step_volatility / 2);
+        generated.volume[i] = std::floor(1e6 * dt * 252 * std::exp(0.5 * normal()));
+    }
+    return generated;
 }
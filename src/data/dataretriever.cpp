@@ -5,6 +5,7 @@
 // Include header
 #include <mutex>
 #include "dataretriever.hpp"
+#include "replay.hpp"
 
 // Constructor to build an instance of the HistoricalDataRetriever for the given type of data.
 //
@@ -75,34 +76,82 @@ HistoricalDataRetriever::pullHistoricalData(const std::vector<std::string> &secu
     return std::move(handler.target);
 }
 
+// Generates an IntradayBarRequest for one security. Bloomberg takes and returns the bar times in GMT, so the local
+// start and end are converted before the request and the handler converts the bars back.
+//
+// @param security         The security to request bars for, ex. "IBM US EQUITY"
+// @param start_datetime   The local time from which to begin pulling bars.
+// @param end_datetime     The local upper limit on pulled bars.
+// @param interval         The length of each bar in minutes
+// @param event_type       The type of tick the bars are built from, ex. "TRADE", "BID", "ASK"
+//
+SymbolHistoricalData HistoricalDataRetriever::pullIntradayBars(const std::string &security,
+                                                               const BloombergLP::blpapi::Datetime &start_datetime,
+                                                               const BloombergLP::blpapi::Datetime &end_datetime,
+                                                               unsigned int interval,
+                                                               const std::string &event_type) {
+
+    // Ensure that this instance of HistoricalDataRetriever is able to take intraday data
+    if (type != "INTRADAY_DATA") { throw std::runtime_error("Not intraday data retriever!"); }
+
+    // Intraday bars also come through the Reference Data service
+    session->openService(bloomberg_services::REFDATA);
+    BloombergLP::blpapi::Service refDataService = session->getService(bloomberg_services::REFDATA);
+    BloombergLP::blpapi::Request request = refDataService.createRequest("IntradayBarRequest");
+    request.set("security", security.c_str());
+    request.set("eventType", event_type.c_str());
+    request.set("interval", static_cast<int>(interval));
+    request.set("startDateTime", date_funcs::local_to_utc(start_datetime));
+    request.set("endDateTime", date_funcs::local_to_utc(end_datetime));
+
+    // Send the request and handle the responses in the same way as historical data
+    BloombergLP::blpapi::EventQueue queue;
+    session->sendRequest(request, BloombergLP::blpapi::CorrelationId(correlation_id), &queue);
+    IntradayBarHandler handler(security);
+    bool responseFinished = false;
+    while(!responseFinished) {
+        BloombergLP::blpapi::Event event;
+        if (queue.tryNextEvent(&event) == 0) { responseFinished = handler.processResponseEvent(event); }
+    }
+    return std::move(handler.target);
+}
+
 // Builds the Real Time data retriever for sessions and subscriptions of data. This constructor initializes
 // members and builds the session which will be run when runSubscription is called.
-RealTimeDataRetriever::RealTimeDataRetriever(pthread_mutex_t* p_mtx, int p_correlation_id) :
+RealTimeDataRetriever::RealTimeDataRetriever(pthread_mutex_t* p_mtx, pthread_cond_t* p_cond, int p_correlation_id) :
         correlation_id(p_correlation_id),
-        data_handler(&buffer_queue, p_mtx) {
+        data_handler(&buffer_queue, p_mtx, p_cond, &quote_book) {}
 
-    // First initialize the session options with global session run settings.
+// Destructor which stops any replay and closes the connection to the Bloomberg API if one was opened.
+RealTimeDataRetriever::~RealTimeDataRetriever() {
+    replayer.reset();
+    if (session) { stopSubscriptions(); session->stop(); }
+}
+
+// Begins the subscription for a vector of symbols, getting the requested fields for each one. Trades are built
+// into MarketEvents which are put onto the buffer queue, and every field is written into the quote book. Once the
+// mutex unlocks, the queue is filled into the heap and then emptied.
+void RealTimeDataRetriever::runSubscription(const std::vector<std::string>& symbols,
+                                            const std::vector<std::string>& fields) {
+    // Connect to Bloomberg only now, so a replay never needs a session
     BloombergLP::blpapi::SessionOptions session_options;
     session_options.setServerHost(bloomberg_session::HOST);
     session_options.setServerPort(bloomberg_session::PORT);
-    // Also initialize the Session connection to Bloomberg Communications
     session = std::make_unique<BloombergLP::blpapi::Session>(session_options, &data_handler);
-    // Open up the session in preparation for data requests
     if (!session->start()) {
         throw std::runtime_error("Failed to start session! Aborting.");
     };
-}
 
-// Destructor which closes the connection to the Bloomberg API.
-RealTimeDataRetriever::~RealTimeDataRetriever() { stopSubscriptions(); session->stop(); }
-
-// Begins the subscription for a vector of symbols, getting the PX_LAST data for each one and building it
-// into a MarketEvent which is put onto the buffer queue. Once the mutex unlocks, the queue is filled
-// into the heap event list and then emptied.
-void RealTimeDataRetriever::runSubscription(const std::vector<std::string>& symbols) {
+    // Build the quote book so the handler can look symbols up by the correlation ID index
+    quote_book.reset(symbols);
+    conflation_buffer.reset(symbols.size());
+    // Join the fields into the comma separated list the subscription expects
+    std::string field_list;
+    for (const std::string& field : fields) { field_list += (field_list.empty() ? "" : ",") + field; }
     // Add all the tickers to the subscription
-    for (const auto& i : symbols) {
-        subscriptions.add(i.c_str(), "LAST_PRICE", "", BloombergLP::blpapi::CorrelationId((char*)i.c_str()));
+    for (size_t i = 0; i < quote_book.symbols.size(); ++i) {
+        subscriptions.add(quote_book.symbols[i].c_str(), field_list.c_str(), "",
+                BloombergLP::blpapi::CorrelationId(static_cast<long long>(i)));
     }
     // Run the subscription
     session->openService(bloomberg_services::MKTDATA);
@@ -111,12 +160,101 @@ void RealTimeDataRetriever::runSubscription(const std::vector<std::string>& symb
 
 // Stops all subscriptions
 void RealTimeDataRetriever::stopSubscriptions() {
-    session->unsubscribe(subscriptions);
+    if (session) { session->unsubscribe(subscriptions); }
+}
+
+// Reads the recorded ticks and builds the quote book for the replayed symbols
+BloombergLP::blpapi::Datetime RealTimeDataRetriever::loadReplay(const std::vector<std::string>& symbols,
+                                                                const std::string& filepath) {
+    quote_book.reset(symbols);
+    conflation_buffer.reset(symbols.size());
+    replayer = std::make_unique<TickReplayer>(filepath, quote_book);
+    if (replayer->empty()) { throw std::runtime_error("No ticks to replay in " + filepath + "!"); }
+    return replayer->first_time();
+}
+
+// Starts feeding the loaded ticks through the handler on the replay thread
+void RealTimeDataRetriever::runReplay(ReplayClock* clock) {
+    if (!replayer) { throw std::runtime_error("Replay must be loaded before it is run!"); }
+    replayer->start(&data_handler, clock);
+}
+
+// Points the handler at the conflation slots, or back at the queue
+void RealTimeDataRetriever::setConflation(bool p_conflate) {
+    conflate = p_conflate;
+    data_handler.setConflationBuffer(conflate ? &conflation_buffer : nullptr);
+}
+
+// Batches all the conflated prices into a single MarketEvent on the buffer queue
+void RealTimeDataRetriever::flushConflated() {
+    if (conflation_buffer.empty()) { return; }
+    buffer_queue.emplace(conflation_buffer.flush(quote_book));
+}
+
+// Builds the empty quotes and the symbol lookup for the subscription
+void QuoteBook::reset(const std::vector<std::string>& p_symbols) {
+    symbols = p_symbols;
+    quotes.assign(symbols.size(), Quote());
+    indices.clear();
+    for (size_t i = 0; i < symbols.size(); ++i) { indices[symbols[i]] = i; }
+}
+
+// Looks up the index of a symbol in the book
+long QuoteBook::index_of(const std::string& symbol) const {
+    auto found = indices.find(symbol);
+    return found == indices.end() ? -1 : static_cast<long>(found->second);
+}
+
+// Sizes the dirty bitset for the subscription
+void ConflationBuffer::reset(size_t num_symbols) {
+    dirty.assign((num_symbols + 63) / 64, 0);
+    pending = 0;
+}
+
+// Marks the symbol dirty, or counts a conflated tick if it already was
+void ConflationBuffer::mark(size_t index) {
+    uint64_t bit = uint64_t(1) << (index % 64);
+    if (dirty[index / 64] & bit) {
+        conflated++;
+    } else {
+        if (pending == 0) { first_received = std::chrono::steady_clock::now(); }
+        dirty[index / 64] |= bit;
+        pending++;
+    }
+}
+
+// Walks the set bits of the dirty bitset to build the batched MarketEvent
+std::unique_ptr<events::MarketEvent> ConflationBuffer::flush(const QuoteBook& book) {
+    std::vector<std::string> changed;
+    std::unordered_map<std::string, double> data;
+    changed.reserve(pending);
+    data.reserve(pending);
+    BloombergLP::blpapi::Datetime latest = BloombergLP::blpapi::Datetime(1970, 1, 1, 0, 0, 0);
+    for (size_t word = 0; word < dirty.size(); ++word) {
+        uint64_t bits = dirty[word];
+        while (bits) {
+            // Index of the lowest set bit, then clear it
+            size_t bit = 0;
+            while (!(bits & (uint64_t(1) << bit))) { bit++; }
+            bits &= bits - 1;
+            const size_t index = word * 64 + bit;
+            const Quote& quote = book.quotes[index];
+            changed.emplace_back(book.symbols[index]);
+            data[book.symbols[index]] = quote.last;
+            if (date_funcs::is_greater(quote.time, latest)) { latest = quote.time; }
+        }
+        dirty[word] = 0;
+    }
+    pending = 0;
+    auto event = std::make_unique<events::MarketEvent>(changed, data, latest);
+    event->received = first_received;
+    return event;
 }
 
 // Constructor for the EventHandler for realtime data
-RealTimeDataHandler::RealTimeDataHandler(std::queue<std::unique_ptr<events::Event>> *p_queue, pthread_mutex_t* p_mtx) :
-        queue(p_queue), mtx(p_mtx) {}
+RealTimeDataHandler::RealTimeDataHandler(std::queue<std::unique_ptr<events::Event>> *p_queue, pthread_mutex_t* p_mtx,
+                                         pthread_cond_t* p_cond, QuoteBook* p_book) :
+        queue(p_queue), mtx(p_mtx), cond(p_cond), book(p_book) {}
 
 // Process the events received through the subscription into the queue, only when the mutex is unlocked. Otherwise,
 // the events remain in the session until the EventHandler is able to be unlocked and retrieve them.
@@ -130,23 +268,32 @@ bool RealTimeDataHandler::processEvent(const BloombergLP::blpapi::Event &event,
         while (msgIter.next()) {
             // Get one message and store it in message
             BloombergLP::blpapi::Message msg = msgIter.message();
-            // Get the symbol
-            std::string ticker = (char*)msg.correlationId().asPointer();
-            // If the elements are present, then get the last price and write it to the queue
-            if (msg.hasElement("LAST_TRADE", true)) {
-
-                // Block until the mutex is unlocked so the queue is editable by this.
-                // The mutex is automatically unlocked once this unique lock is destroyed (at end of emplace).
-                pthread_mutex_lock(mtx);
-
-                // Build the MarketEvent to place onto the queue
-                queue->emplace(std::unique_ptr<events::MarketEvent>(new events::MarketEvent({ticker},
-                                {{ticker, msg.getElementAsFloat64("LAST_TRADE")}},
-                                msg.getElementAsDatetime("TIME"))));
-
-                // Unblock the threads
-                pthread_mutex_unlock(mtx);
-            }
+            // Get the symbol from the index stored in the correlation ID, skipping any message whose ID is not the
+            // index of one of the subscribed symbols
+            const long long id = msg.correlationId().asInteger();
+            if (id < 0 || static_cast<unsigned long long>(id) >= book->symbols.size()) { continue; }
+            auto index = static_cast<size_t>(id);
+
+            // Decode every field present into a local copy of the quote, noting which ones were received
+            Quote update;
+            unsigned fields = 0;
+            if (msg.hasElement(realtime_fields::LAST_TRADE, true)) {
+                update.last = msg.getElementAsFloat64(realtime_fields::LAST_TRADE); fields |= Quote::LAST; }
+            if (msg.hasElement(realtime_fields::BID, true)) {
+                update.bid = msg.getElementAsFloat64(realtime_fields::BID); fields |= Quote::BID; }
+            if (msg.hasElement(realtime_fields::ASK, true)) {
+                update.ask = msg.getElementAsFloat64(realtime_fields::ASK); fields |= Quote::ASK; }
+            if (msg.hasElement(realtime_fields::BID_SIZE, true)) {
+                update.bid_size = msg.getElementAsFloat64(realtime_fields::BID_SIZE); fields |= Quote::BID_SIZE; }
+            if (msg.hasElement(realtime_fields::ASK_SIZE, true)) {
+                update.ask_size = msg.getElementAsFloat64(realtime_fields::ASK_SIZE); fields |= Quote::ASK_SIZE; }
+            if (msg.hasElement(realtime_fields::VOLUME, true)) {
+                update.volume = msg.getElementAsFloat64(realtime_fields::VOLUME); fields |= Quote::VOLUME; }
+            if (msg.hasElement(realtime_fields::TIME, true)) {
+                update.time = msg.getElementAsDatetime(realtime_fields::TIME); fields |= Quote::TIME; }
+
+            // Pass it on to the quote book and queue
+            ingest(index, update, fields);
         }
     }
 
@@ -154,6 +301,50 @@ bool RealTimeDataHandler::processEvent(const BloombergLP::blpapi::Event &event,
     return true;
 }
 
+// Applies one decoded update under the mutex, so the lock is held only for the copy into the quote book
+void RealTimeDataHandler::ingest(size_t index, const Quote &update, unsigned fields) {
+    // Updates without any data (e.g. only a time) are ignored
+    if (!(fields & ~Quote::TIME)) { return; }
+
+    // Block until the mutex is unlocked so the quote book and queue are editable by this.
+    pthread_mutex_lock(mtx);
+
+    // Write the fields which were present into the symbol's quote record
+    Quote& quote = book->quotes[index];
+    if (fields & Quote::LAST) { quote.last = update.last; }
+    if (fields & Quote::BID) { quote.bid = update.bid; }
+    if (fields & Quote::ASK) { quote.ask = update.ask; }
+    if (fields & Quote::BID_SIZE) { quote.bid_size = update.bid_size; }
+    if (fields & Quote::ASK_SIZE) { quote.ask_size = update.ask_size; }
+    if (fields & Quote::VOLUME) { quote.volume = update.volume; }
+    if (fields & Quote::TIME) { quote.time = update.time; }
+
+    // Trades also update the portfolio, so either mark the symbol dirty for conflation or build the
+    // MarketEvent to place onto the queue
+    if (fields & Quote::LAST) {
+        if (conflation) {
+            conflation->mark(index);
+        } else {
+            const std::string& ticker = book->symbols[index];
+            queue->emplace(std::make_unique<events::MarketEvent>(std::vector<std::string>{ticker},
+                           std::unordered_map<std::string, double>{{ticker, quote.last}}, quote.time));
+        }
+        // Wake the strategy thread if it is sleeping
+        pthread_cond_signal(cond);
+    }
+
+    // Unblock the threads
+    pthread_mutex_unlock(mtx);
+}
+
+// Queues the StopEvent behind any remaining ticks and wakes the strategy thread
+void RealTimeDataHandler::finish(const BloombergLP::blpapi::Datetime &when, const std::string &reason) {
+    pthread_mutex_lock(mtx);
+    queue->emplace(std::make_unique<events::StopEvent>(reason, when));
+    pthread_cond_signal(cond);
+    pthread_mutex_unlock(mtx);
+}
+
 // Initializes the unique ptr to the unordered map to be returned
 HistoricalDataHandler::HistoricalDataHandler() :
     target(std::make_unique<std::unordered_map<std::string, SymbolHistoricalData>>()) {}
@@ -223,6 +414,45 @@ bool HistoricalDataHandler::processResponseEvent(const BloombergLP::blpapi::Even
     return event.eventType() == BloombergLP::blpapi::Event::RESPONSE;
 }
 
+// Sets up the empty bar data for the security
+IntradayBarHandler::IntradayBarHandler(const std::string &security) { target.symbol = security; }
+
+// Reads the bar ticks of each response message into the target SymbolHistoricalData
+bool IntradayBarHandler::processResponseEvent(const BloombergLP::blpapi::Event &event) {
+
+    // Make sure the message is either a partial response or a full response
+    if ((event.eventType() != BloombergLP::blpapi::Event::PARTIAL_RESPONSE) &&
+        (event.eventType() != BloombergLP::blpapi::Event::RESPONSE)) { return false; }
+
+    // Iterates through the messages returned by the event
+    BloombergLP::blpapi::MessageIterator msgIter(event);
+    while (msgIter.next()) {
+        BloombergLP::blpapi::Message msg = msgIter.message();
+
+        // Intraday responses have no securityData, so only a response error needs to be checked for
+        if (!msg.hasElement(element_names::BAR_DATA)) {
+            processExceptionsAndErrors(msg);
+            continue;
+        }
+
+        // Put each bar into the target at its local start time
+        BloombergLP::blpapi::Element bars = msg.getElement(element_names::BAR_DATA).getElement(element_names::BAR_TICK_DATA);
+        for (size_t i = 0; i < bars.numValues(); ++i) {
+            BloombergLP::blpapi::Element bar = bars.getValueAsElement(i);
+            std::unordered_map<std::string, double>& fields =
+                    target.data[date_funcs::utc_to_local(bar.getElementAsDatetime(element_names::BAR_TIME))];
+            fields["PX_OPEN"] = bar.getElementAsFloat64(element_names::BAR_OPEN);
+            fields["PX_HIGH"] = bar.getElementAsFloat64(element_names::BAR_HIGH);
+            fields["PX_LOW"] = bar.getElementAsFloat64(element_names::BAR_LOW);
+            fields["PX_LAST"] = bar.getElementAsFloat64(element_names::BAR_CLOSE);
+            fields["VOLUME"] = static_cast<double>(bar.getElementAsInt64(element_names::BAR_VOLUME));
+        }
+    }
+
+    // The RESPONSE event is the last one
+    return event.eventType() == BloombergLP::blpapi::Event::RESPONSE;
+}
+
 // Handles any exceptions in the message received from Bloomberg.
 bool DataHandler::processExceptionsAndErrors(BloombergLP::blpapi::Message msg) {
     // If there is no security data, return a call to processErrors
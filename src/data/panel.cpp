@@ -0,0 +1,74 @@
+// Include corresponding header
+#include "panel.hpp"
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+
+// Allocates every field at once
+Panel::Panel(std::vector<std::string> p_symbols, std::vector<std::string> p_fields,
+             std::vector<BloombergLP::blpapi::Datetime> p_times) :
+        symbols(std::move(p_symbols)),
+        fields(std::move(p_fields)),
+        times(std::move(p_times)),
+        values(symbols.size() * fields.size() * times.size(), std::numeric_limits<double>::quiet_NaN()) {}
+
+// Panels have few fields, so a linear search is enough
+size_t Panel::field_index(const std::string &field) const {
+    auto found = std::find(fields.begin(), fields.end(), field);
+    if (found == fields.end()) { throw std::runtime_error("Field " + field + " is not in the panel!"); }
+    return static_cast<size_t>(found - fields.begin());
+}
+
+// Linear as well, so look symbols up once rather than for every value
+size_t Panel::symbol_index(const std::string &symbol) const {
+    auto found = std::find(symbols.begin(), symbols.end(), symbol);
+    if (found == symbols.end()) { throw std::runtime_error("Symbol " + symbol + " is not in the panel!"); }
+    return static_cast<size_t>(found - symbols.begin());
+}
+
+// Walks down the rows, so each pass reads and writes the matrix in the order it is stored
+void Panel::forward_fill() {
+    const size_t width = symbols.size();
+    for (size_t f = 0; f < fields.size(); ++f) {
+        for (size_t time = 1; time < times.size(); ++time) {
+            const double* previous = row(f, time - 1);
+            double* current = row(f, time);
+            for (size_t i = 0; i < width; ++i) { if (std::isnan(current[i])) { current[i] = previous[i]; } }
+        }
+    }
+}
+
+// The calendar is gathered in an ordered map first, which both sorts the dates and numbers them
+Panel Panel::from_history(const std::vector<std::string> &symbols, const std::vector<std::string> &fields,
+                          const std::unordered_map<std::string, SymbolHistoricalData> &history, Gaps gaps) {
+    std::map<BloombergLP::blpapi::Datetime, size_t> calendar;
+    for (const std::string& symbol : symbols) {
+        auto found = history.find(symbol);
+        if (found == history.end()) { continue; }
+        for (const auto& bar : found->second.data) { calendar.emplace(bar.first, 0); }
+    }
+    std::vector<BloombergLP::blpapi::Datetime> times;
+    times.reserve(calendar.size());
+    for (auto& date : calendar) {
+        date.second = times.size();
+        times.push_back(date.first);
+    }
+
+    Panel panel(symbols, fields, std::move(times));
+    const size_t width = symbols.size();
+    for (size_t i = 0; i < width; ++i) {
+        auto found = history.find(symbols[i]);
+        if (found == history.end()) { continue; }
+        for (const auto& bar : found->second.data) {
+            const size_t time = calendar.at(bar.first);
+            for (size_t f = 0; f < fields.size(); ++f) {
+                auto value = bar.second.find(fields[f]);
+                if (value != bar.second.end()) { panel.row(f, time)[i] = value->second; }
+            }
+        }
+    }
+    if (gaps == FORWARD_FILL) { panel.forward_fill(); }
+    return panel;
+}
@@ -0,0 +1,92 @@
+// Include corresponding header
+#include "replay.hpp"
+// STL includes
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+// Parses the file line by line into ticks ordered by time. Recorded files are normally in order already, but a
+// stable sort makes out of order rows harmless while keeping the order of rows with the same time.
+TickReplayer::TickReplayer(const std::string &filepath, const QuoteBook &book) {
+    std::ifstream file(filepath);
+    if (!file.is_open()) { throw std::runtime_error("Could not open tick file " + filepath + "!"); }
+
+    std::string line;
+    unsigned long line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (line.empty() || line.compare(0, 8, "datetime") == 0) { continue; }
+        if (line.back() == '\r') { line.pop_back(); }
+
+        // Split the row into its columns
+        std::vector<std::string> columns;
+        std::stringstream row(line);
+        std::string column;
+        while (std::getline(row, column, ',')) { columns.push_back(column); }
+        if (columns.size() < 3) {
+            throw std::runtime_error("Malformed tick on line " + std::to_string(line_number) + " of " + filepath + "!");
+        }
+
+        // Skip symbols which are not being replayed
+        long index = book.index_of(columns[1]);
+        if (index < 0) { continue; }
+
+        // Read the time, with optional milliseconds, then every price and size column that is filled in
+        Tick tick{static_cast<size_t>(index), Quote(), Quote::TIME};
+        unsigned year = 0, month = 0, day = 0, hours = 0, minutes = 0, seconds = 0, millis = 0;
+        if (sscanf(columns[0].c_str(), "%u-%u-%u%*c%u:%u:%u.%u", &year, &month, &day, &hours, &minutes, &seconds,
+                   &millis) < 6) {
+            throw std::runtime_error("Malformed tick time on line " + std::to_string(line_number) + " of " + filepath + "!");
+        }
+        tick.update.time = BloombergLP::blpapi::Datetime(year, month, day, hours, minutes, seconds, millis);
+        double* values[] = {&tick.update.last, &tick.update.bid, &tick.update.ask, &tick.update.bid_size,
+                            &tick.update.ask_size, &tick.update.volume};
+        const unsigned bits[] = {Quote::LAST, Quote::BID, Quote::ASK, Quote::BID_SIZE, Quote::ASK_SIZE, Quote::VOLUME};
+        for (size_t i = 0; i < 6 && i + 2 < columns.size(); ++i) {
+            if (columns[i + 2].empty()) { continue; }
+            *values[i] = std::stod(columns[i + 2]);
+            tick.fields |= bits[i];
+        }
+        ticks.push_back(tick);
+    }
+
+    std::stable_sort(ticks.begin(), ticks.end(), [](const Tick& first, const Tick& second) {
+        return date_funcs::is_greater(second.update.time, first.update.time);
+    });
+}
+
+// Signals the replay thread to stop and waits for it
+TickReplayer::~TickReplayer() {
+    stopping = true;
+    if (worker.joinable()) { worker.join(); }
+}
+
+// Launches the replay on its own thread, as the Bloomberg session would deliver a subscription
+void TickReplayer::start(RealTimeDataHandler *handler, ReplayClock *clock) {
+    worker = std::thread(&TickReplayer::play, this, handler, clock);
+}
+
+// Feeds every tick into the handler. In the paced modes each tick is held back until the clock reaches its time,
+// as it would arrive live. When running as fast as possible the ticks are fed back to back and the clock is moved
+// up to each tick's time before it is fed, so the earlier ticks become due as the later ones arrive.
+void TickReplayer::play(RealTimeDataHandler *handler, ReplayClock *clock) {
+    for (const Tick& tick : ticks) {
+        if (stopping) { return; }
+        if (clock->paced()) {
+            std::this_thread::sleep_until(clock->real_time(tick.update.time));
+        } else {
+            clock->advance(tick.update.time);
+        }
+        handler->ingest(tick.index, tick.update, tick.fields);
+    }
+
+    // Stop the strategy once it has worked through the last tick. A paced clock gets past the last tick by itself,
+    // the fast clock has to be moved a second past it.
+    const BloombergLP::blpapi::Datetime& last = ticks.back().update.time;
+    if (!clock->paced()) {
+        timespec after = date_funcs::to_timespec(last);
+        after.tv_sec += 1;
+        clock->advance(date_funcs::from_timespec(after));
+    }
+    handler->finish(last, "Replay finished.");
+}
@@ -0,0 +1,311 @@
+// Include corresponding header
+#include "analytics.hpp"
+// STL includes
+#include <algorithm>
+#include <iomanip>
+// Custom class includes
+#include "daterules.hpp"
+
+// Builds the analytics with nothing recorded
+Analytics::Analytics(double p_periods_per_year, unsigned int p_period_seconds, unsigned int p_rolling_window,
+                     double p_risk_free_rate) :
+        periods_per_year(p_periods_per_year),
+        period_seconds(p_period_seconds),
+        rolling_window(std::max(2u, p_rolling_window)),
+        risk_free_rate(p_risk_free_rate) {
+    window.reserve(rolling_window);
+}
+
+// Only changes the counting, so must be called before anything is recorded
+void Analytics::set_periods(double p_periods_per_year, unsigned int p_period_seconds) {
+    periods_per_year = p_periods_per_year;
+    period_seconds = p_period_seconds;
+}
+
+// The first update opens the first period. Every later one closes the current period, unless periods have a length
+// and it has not yet passed, in which case the update only moves the period's closing values.
+void Analytics::update(const BloombergLP::blpapi::Datetime &time, double equity, double gross_exposure,
+                       double benchmark) {
+    const long long now = period_seconds ? static_cast<long long>(date_funcs::to_timespec(time).tv_sec) : 0;
+    close_equity = equity;
+    gross = gross_exposure;
+    if (!std::isnan(benchmark)) { close_benchmark = benchmark; }
+    if (!started) {
+        started = true;
+        period_start = now;
+        open_equity = start_equity = peak = equity;
+        open_benchmark = close_benchmark;
+        return;
+    }
+    if (period_seconds && now - period_start < period_seconds) { return; }
+
+    // Benchmark returns only count once there have been two levels to take them between
+    const double benchmark_return = (open_benchmark > 0 && close_benchmark > 0) ?
+            close_benchmark / open_benchmark - 1 : std::numeric_limits<double>::quiet_NaN();
+    add_period(open_equity > 0 ? close_equity / open_equity - 1 : 0, benchmark_return);
+    open_equity = close_equity;
+    open_benchmark = close_benchmark;
+    period_start = now;
+}
+
+// Updates every running estimator with one more return
+void Analytics::add_period(double portfolio_return, double benchmark_return) {
+    periods++;
+    const double delta = portfolio_return - mean;
+    mean += delta / periods;
+    m2 += delta * (portfolio_return - mean);
+    const double below = std::min(portfolio_return - risk_free_rate / periods_per_year, 0.0);
+    downside += below * below;
+
+    // Replace the oldest return in the window once it is full
+    if (window.size() < rolling_window) {
+        window.push_back(portfolio_return);
+    } else {
+        window_sum -= window[window_next];
+        window_sum_squares -= window[window_next] * window[window_next];
+        window[window_next] = portfolio_return;
+        window_next = (window_next + 1) % rolling_window;
+    }
+    window_sum += portfolio_return;
+    window_sum_squares += portfolio_return * portfolio_return;
+
+    // Drawdown from the highest equity so far
+    peak = std::max(peak, close_equity);
+    const double drawdown = peak > 0 ? 1 - close_equity / peak : 0;
+    max_drawdown = std::max(max_drawdown, drawdown);
+    drawdown_periods = drawdown > 0 ? drawdown_periods + 1 : 0;
+    max_drawdown_periods = std::max(max_drawdown_periods, drawdown_periods);
+
+    equity_sum += close_equity;
+    exposure_sum += close_equity > 0 ? gross / close_equity : 0;
+
+    if (std::isnan(benchmark_return)) { return; }
+    benchmark_periods++;
+    const double benchmark_delta = benchmark_return - benchmark_mean;
+    const double portfolio_delta = portfolio_return - portfolio_mean;
+    benchmark_mean += benchmark_delta / benchmark_periods;
+    portfolio_mean += portfolio_delta / benchmark_periods;
+    benchmark_m2 += benchmark_delta * (benchmark_return - benchmark_mean);
+    portfolio_m2 += portfolio_delta * (portfolio_return - portfolio_mean);
+    comoment += portfolio_delta * (benchmark_return - benchmark_mean);
+    const double active = portfolio_return - benchmark_return;
+    const double active_delta = active - active_mean;
+    active_mean += active_delta / benchmark_periods;
+    active_m2 += active_delta * (active - active_mean);
+}
+
+// Keeps each symbol's position at its average cost. A fill against the position closes a trade, which wins if it
+// was closed at a better price than the position was opened at.
+void Analytics::update_fill(const events::FillEvent &fill) {
+    if (fill.quantity == 0) { return; }
+    traded += std::abs(fill.cost);
+    const double price = fill.cost / fill.quantity;
+    std::pair<int, double>& position = positions[fill.symbol];
+    int& quantity = position.first;
+    double& average = position.second;
+
+    if (quantity != 0 && (quantity > 0) != (fill.quantity > 0)) {
+        const int closed = std::min(std::abs(quantity), std::abs(fill.quantity));
+        const double profit = closed * (price - average) * (quantity > 0 ? 1 : -1);
+        trades++;
+        if (profit > 0) { winning_trades++; }
+        // Going through zero opens a new position at the fill price
+        const bool flipped = std::abs(fill.quantity) > std::abs(quantity);
+        quantity += fill.quantity;
+        if (quantity == 0) { average = 0; } else if (flipped) { average = price; }
+    } else {
+        average = (average * quantity + price * fill.quantity) / (quantity + fill.quantity);
+        quantity += fill.quantity;
+    }
+}
+
+// Turns the running moments into annualized statistics
+PerformanceStats Analytics::stats() const {
+    PerformanceStats result;
+    result.periods = periods;
+    result.trades = trades;
+    result.hit_rate = trades ? static_cast<double>(winning_trades) / trades : 0;
+    result.current_exposure = close_equity > 0 ? gross / close_equity : 0;
+    result.current_drawdown = peak > 0 ? std::max(0.0, 1 - close_equity / peak) : 0;
+    result.max_drawdown = max_drawdown;
+    result.max_drawdown_periods = max_drawdown_periods;
+    result.total_return = start_equity > 0 ? close_equity / start_equity - 1 : 0;
+    if (periods == 0) { return result; }
+
+    const double annualizer = std::sqrt(periods_per_year);
+    const double excess = mean - risk_free_rate / periods_per_year;
+    result.annualized_return = std::pow(1 + result.total_return, periods_per_year / periods) - 1;
+    result.exposure = exposure_sum / periods;
+    result.turnover = equity_sum > 0 ? traded / (equity_sum / periods) * periods_per_year / periods : 0;
+    if (periods > 1) {
+        const double deviation = std::sqrt(m2 / (periods - 1));
+        result.volatility = deviation * annualizer;
+        result.sharpe = deviation > 0 ? excess / deviation * annualizer : 0;
+    }
+    const double downside_deviation = std::sqrt(downside / periods);
+    result.sortino = downside_deviation > 0 ? excess / downside_deviation * annualizer : 0;
+
+    const auto window_size = static_cast<double>(window.size());
+    if (window.size() > 1) {
+        const double variance = (window_sum_squares - window_sum * window_sum / window_size) / (window_size - 1);
+        result.rolling_volatility = std::sqrt(std::max(0.0, variance)) * annualizer;
+    }
+
+    if (benchmark_periods > 1) {
+        result.has_benchmark = true;
+        result.beta = benchmark_m2 > 0 ? comoment / benchmark_m2 : 0;
+        result.alpha = (portfolio_mean - result.beta * benchmark_mean) * periods_per_year;
+        result.correlation = (benchmark_m2 > 0 && portfolio_m2 > 0) ? comoment / std::sqrt(benchmark_m2 * portfolio_m2) : 0;
+        result.tracking_error = std::sqrt(active_m2 / (benchmark_periods - 1)) * annualizer;
+        result.information_ratio = result.tracking_error > 0 ? active_mean * periods_per_year / result.tracking_error : 0;
+    }
+    return result;
+}
+
+// Prints one statistic per line
+void Analytics::report(std::ostream &out) const {
+    const PerformanceStats result = stats();
+    const std::ios_base::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2)
+        << "Total return:        " << result.total_return * 100 << "%\n"
+        << "Annualized return:   " << result.annualized_return * 100 << "%\n"
+        << "Volatility:          " << result.volatility * 100 << "% (rolling " << result.rolling_volatility * 100 << "%)\n"
+        << "Sharpe / Sortino:    " << result.sharpe << " / " << result.sortino << "\n"
+        << "Max drawdown:        " << result.max_drawdown * 100 << "% over " << result.max_drawdown_periods << " periods\n"
+        << "Turnover:            " << result.turnover << "x per year\n"
+        << "Exposure:            " << result.exposure * 100 << "% (now " << result.current_exposure * 100 << "%)\n"
+        << "Hit rate:            " << result.hit_rate * 100 << "% of " << result.trades << " trades\n";
+    if (result.has_benchmark) {
+        out << "Beta / alpha:        " << result.beta << " / " << result.alpha * 100 << "%\n"
+            << "Correlation:         " << result.correlation << "\n"
+            << "Tracking error / IR: " << result.tracking_error * 100 << "% / " << result.information_ratio << "\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+// Every running value, in declaration order
+void Analytics::write_checkpoint(checkpoint::Writer &writer) const {
+    writer.put(periods_per_year);
+    writer.put(period_seconds);
+    writer.put<uint8_t>(started);
+    writer.put(period_start);
+    for (double value : {open_equity, close_equity, start_equity, open_benchmark, close_benchmark, gross}) {
+        writer.put(value);
+    }
+    writer.put(periods);
+    for (double value : {mean, m2, downside}) { writer.put(value); }
+    writer.put(benchmark_periods);
+    for (double value : {benchmark_mean, benchmark_m2, comoment, portfolio_mean, portfolio_m2, active_mean, active_m2,
+                         peak, max_drawdown}) {
+        writer.put(value);
+    }
+    writer.put(drawdown_periods);
+    writer.put(max_drawdown_periods);
+    writer.put_array(window);
+    writer.put<uint64_t>(window_next);
+    for (double value : {window_sum, window_sum_squares, exposure_sum, equity_sum, traded}) { writer.put(value); }
+    std::unordered_map<std::string, int> quantities;
+    std::unordered_map<std::string, double> costs;
+    for (const auto& position : positions) {
+        quantities[position.first] = position.second.first;
+        costs[position.first] = position.second.second;
+    }
+    writer.put(quantities);
+    writer.put(costs);
+    writer.put(trades);
+    writer.put(winning_trades);
+}
+
+// Reads back in the order written
+void Analytics::read_checkpoint(checkpoint::Reader &reader) {
+    periods_per_year = reader.get<double>();
+    period_seconds = reader.get<unsigned int>();
+    started = reader.get<uint8_t>() != 0;
+    period_start = reader.get<long long>();
+    for (double* value : {&open_equity, &close_equity, &start_equity, &open_benchmark, &close_benchmark, &gross}) {
+        *value = reader.get<double>();
+    }
+    periods = reader.get<unsigned long>();
+    for (double* value : {&mean, &m2, &downside}) { *value = reader.get<double>(); }
+    benchmark_periods = reader.get<unsigned long>();
+    for (double* value : {&benchmark_mean, &benchmark_m2, &comoment, &portfolio_mean, &portfolio_m2, &active_mean,
+                          &active_m2, &peak, &max_drawdown}) {
+        *value = reader.get<double>();
+    }
+    drawdown_periods = reader.get<unsigned long>();
+    max_drawdown_periods = reader.get<unsigned long>();
+    window = reader.get_array<double>();
+    window_next = reader.get<uint64_t>();
+    if (window.size() > rolling_window || (window_next >= rolling_window && !window.empty())) {
+        throw std::runtime_error("Checkpoint rolling window does not match the analytics!");
+    }
+    for (double* value : {&window_sum, &window_sum_squares, &exposure_sum, &equity_sum, &traded}) {
+        *value = reader.get<double>();
+    }
+    const auto quantities = reader.get_map<int>();
+    const auto costs = reader.get_map<double>();
+    positions.clear();
+    for (const auto& quantity : quantities) { positions[quantity.first] = {quantity.second, costs.at(quantity.first)}; }
+    trades = reader.get<unsigned long>();
+    winning_trades = reader.get<unsigned long>();
+}
+
+// Takes its levels from the market events
+BenchmarkOverlay::BenchmarkOverlay(std::string p_symbol) :
+        benchmark_symbol(std::move(p_symbol)),
+        from_events(true) {}
+
+// Holds onto the series to walk through
+BenchmarkOverlay::BenchmarkOverlay(std::string p_symbol,
+                                   std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> p_series) :
+        benchmark_symbol(std::move(p_symbol)),
+        from_events(false),
+        series(std::move(p_series)) {}
+
+// Events come in time order, so the cursor only ever moves forward. A missing or NaN price keeps the latest level.
+double BenchmarkOverlay::level(const events::MarketEvent &event) {
+    if (from_events) {
+        const auto price = event.data.find(benchmark_symbol);
+        if (price != event.data.end() && !std::isnan(price->second)) { latest = price->second; }
+        return latest;
+    }
+    while (next < series.size() && !date_funcs::is_greater(series[next].first, event.datetime)) {
+        if (!std::isnan(series[next].second)) { latest = series[next].second; }
+        next++;
+    }
+    return latest;
+}
+
+// The copy is taken before the strategy's analytics take the event, so both have seen the same updates
+void BenchmarkOverlay::update(const events::MarketEvent &event, double equity, double gross_exposure,
+                              const Analytics &strategy) {
+    if (!analytics) { analytics = std::make_unique<Analytics>(strategy); }
+    analytics->update(event.datetime, equity, gross_exposure, level(event));
+}
+
+// Nothing has been measured before the first update
+PerformanceStats BenchmarkOverlay::stats() const { return analytics ? analytics->stats() : PerformanceStats(); }
+
+// The symbol goes first so a checkpoint is never restored against a different benchmark
+void BenchmarkOverlay::write_checkpoint(checkpoint::Writer &writer) const {
+    writer.put(benchmark_symbol);
+    writer.put(latest);
+    writer.put<uint8_t>(analytics != nullptr);
+    if (analytics) { analytics->write_checkpoint(writer); }
+}
+
+// The cursor goes back to the start of the series, and catches up to the first event after the restore
+void BenchmarkOverlay::read_checkpoint(checkpoint::Reader &reader, const Analytics &strategy) {
+    if (reader.get_string() != benchmark_symbol) {
+        throw std::runtime_error("Checkpoint was written against different benchmarks!");
+    }
+    latest = reader.get<double>();
+    next = 0;
+    analytics.reset();
+    if (reader.get<uint8_t>() != 0) {
+        analytics = std::make_unique<Analytics>(strategy);
+        analytics->read_checkpoint(reader);
+    }
+}
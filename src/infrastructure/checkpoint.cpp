@@ -0,0 +1,235 @@
+// Include corresponding header
+#include "checkpoint.hpp"
+// STL includes
+#include <cstdio>
+#include <fstream>
+
+namespace checkpoint {
+
+// Strings are written as their length followed by their characters
+void Writer::put(const std::string &value) {
+    put<uint64_t>(value.size());
+    buffer.append(value);
+}
+
+// Datetimes are written with the parts which are set, so date-only Datetimes come back date-only
+void Writer::put(const BloombergLP::blpapi::Datetime &value) {
+    uint8_t parts = 0;
+    if (value.hasParts(BLPAPI_DATETIME_DATE_PART)) { parts |= 1; }
+    if (value.hasParts(BLPAPI_DATETIME_TIME_PART)) { parts |= 2; }
+    if (value.hasParts(BLPAPI_DATETIME_MILLISECONDS_PART)) { parts |= 4; }
+    put(parts);
+    if (parts & 1) { put<uint16_t>(value.year()); put<uint8_t>(value.month()); put<uint8_t>(value.day()); }
+    if (parts & 2) { put<uint8_t>(value.hours()); put<uint8_t>(value.minutes()); put<uint8_t>(value.seconds()); }
+    if (parts & 4) { put<uint16_t>(value.milliseconds()); }
+}
+
+// Builds the file in a temporary next to the target and moves it into place once it is complete
+void Writer::save(const std::string &filepath) const {
+    std::string header(MAGIC, sizeof(MAGIC));
+    header.append(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+    uint64_t length = buffer.size();
+    header.append(reinterpret_cast<const char*>(&length), sizeof(length));
+
+    const std::string temporary = filepath + ".tmp";
+    std::ofstream file(temporary, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    if (!file.is_open()) { throw std::runtime_error("Could not open checkpoint file " + temporary + "!"); }
+    file.write((header + buffer).data(), header.size() + buffer.size());
+    file.close();
+    if (!file) { throw std::runtime_error("Failed to write checkpoint file " + temporary + "!"); }
+
+    // Windows will not rename over an existing file, so fall back to removing the old checkpoint first
+    if (std::rename(temporary.c_str(), filepath.c_str()) != 0) {
+        std::remove(filepath.c_str());
+        if (std::rename(temporary.c_str(), filepath.c_str()) != 0) {
+            throw std::runtime_error("Failed to replace checkpoint file " + filepath + "!");
+        }
+    }
+}
+
+// Reads the whole file and checks the header before any of the body is used
+Reader::Reader(const std::string &filepath) {
+    std::ifstream file(filepath, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+    if (!file.is_open()) { throw std::runtime_error("Could not open checkpoint file " + filepath + "!"); }
+    buffer.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(buffer.data(), buffer.size());
+
+    if (buffer.size() < sizeof(MAGIC) || std::memcmp(buffer.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error(filepath + " is not a checkpoint file!");
+    }
+    position = sizeof(MAGIC);
+    auto version = get<uint32_t>();
+    if (version != VERSION) {
+        throw std::runtime_error("Checkpoint " + filepath + " is version " + std::to_string(version) +
+                                 ", expected version " + std::to_string(VERSION) + "!");
+    }
+    auto length = get<uint64_t>();
+    if (length != buffer.size() - position) { throw std::runtime_error("Checkpoint " + filepath + " has the wrong length!"); }
+}
+
+// Bounds checked access into the body
+const char* Reader::take(size_t bytes) {
+    if (bytes > buffer.size() - position) { throw std::runtime_error("Checkpoint ended unexpectedly!"); }
+    const char* toReturn = buffer.data() + position;
+    position += bytes;
+    return toReturn;
+}
+
+// Reads a length prefixed string
+std::string Reader::get_string() {
+    auto length = get<uint64_t>();
+    return std::string(take(length), length);
+}
+
+// Checked before anything is sized from the count
+uint64_t Reader::get_count(size_t bytes_each) {
+    auto count = get<uint64_t>();
+    if (bytes_each > 0 && count > (buffer.size() - position) / bytes_each) {
+        throw std::runtime_error("Checkpoint ended unexpectedly!");
+    }
+    return count;
+}
+
+// Rebuilds a Datetime with only the parts that were written
+BloombergLP::blpapi::Datetime Reader::get_datetime() {
+    auto parts = get<uint8_t>();
+    BloombergLP::blpapi::Datetime toReturn;
+    if (parts & 1) {
+        auto year = get<uint16_t>();
+        auto month = get<uint8_t>();
+        toReturn.setDate(year, month, get<uint8_t>());
+    }
+    if (parts & 2) {
+        auto hours = get<uint8_t>();
+        auto minutes = get<uint8_t>();
+        toReturn.setTime(hours, minutes, get<uint8_t>());
+    }
+    if (parts & 4) { toReturn.setMilliseconds(get<uint16_t>()); }
+    return toReturn;
+}
+
+// The summary is the first thing in the body
+Summary read_summary(const std::string &filepath) {
+    Reader reader(filepath);
+    Summary toReturn;
+    toReturn.fingerprint = reader.get_string();
+    toReturn.time = reader.get_datetime();
+    return toReturn;
+}
+
+// Writes the event's type followed by its members
+void put_event(Writer &writer, const events::Event &event) {
+    writer.put(event.type);
+    writer.put(event.datetime);
+    if (event.type == "MARKET") {
+        auto& market = dynamic_cast<const events::MarketEvent&>(event);
+        writer.put<uint64_t>(market.symbols.size());
+        for (const std::string& symbol : market.symbols) { writer.put(symbol); }
+        writer.put(market.data);
+        writer.put<uint64_t>(market.stale.size());
+        for (const std::string& symbol : market.stale) { writer.put(symbol); }
+    } else if (event.type == "SIGNAL") {
+        auto& signal = dynamic_cast<const events::SignalEvent&>(event);
+        writer.put(signal.symbol);
+        writer.put(signal.percentage);
+    } else if (event.type == "ORDER") {
+        auto& order = dynamic_cast<const events::OrderEvent&>(event);
+        writer.put(order.symbol);
+        writer.put(order.quantity);
+    } else if (event.type == "FILL") {
+        auto& fill = dynamic_cast<const events::FillEvent&>(event);
+        writer.put(fill.symbol);
+        writer.put(fill.quantity);
+        writer.put(fill.cost);
+        writer.put(fill.slippage);
+        writer.put(fill.commission);
+    } else if (event.type == "REBALANCE") {
+        auto& rebalance = dynamic_cast<const events::RebalanceEvent&>(event);
+        writer.put<uint64_t>(rebalance.targets.size());
+        for (const auto& target : rebalance.targets) {
+            writer.put(target.first);
+            writer.put(target.second);
+        }
+    } else if (event.type == "FILLS") {
+        auto& fills = dynamic_cast<const events::FillsEvent&>(event);
+        writer.put<uint64_t>(fills.fills.size());
+        for (const events::FillEvent& fill : fills.fills) { put_event(writer, fill); }
+    } else if (event.type == "SCHEDULED") {
+        writer.put(dynamic_cast<const events::ScheduledEventBase&>(event).schedule_id);
+    } else if (event.type == "STOP") {
+        writer.put(dynamic_cast<const events::StopEvent&>(event).reason);
+    } else {
+        throw std::runtime_error("Cannot checkpoint events of type " + event.type + "!");
+    }
+}
+
+// Reads the type and then builds the matching event
+std::unique_ptr<events::Event> get_event(Reader &reader, const ScheduleFactory &schedule) {
+    const std::string type = reader.get_string();
+    const BloombergLP::blpapi::Datetime when = reader.get_datetime();
+    if (type == "MARKET") {
+        std::vector<std::string> symbols(reader.get_count(sizeof(uint64_t)));
+        for (std::string& symbol : symbols) { symbol = reader.get_string(); }
+        std::unordered_map<std::string, double> data = reader.get_map<double>();
+        std::unordered_set<std::string> stale;
+        for (uint64_t i = reader.get_count(sizeof(uint64_t)); i > 0; --i) { stale.insert(reader.get_string()); }
+        return std::make_unique<events::MarketEvent>(symbols, data, when, std::move(stale));
+    } else if (type == "SIGNAL") {
+        std::string symbol = reader.get_string();
+        return std::make_unique<events::SignalEvent>(symbol, reader.get<double>(), when);
+    } else if (type == "ORDER") {
+        std::string symbol = reader.get_string();
+        return std::make_unique<events::OrderEvent>(symbol, reader.get<int>(), when);
+    } else if (type == "FILL") {
+        std::string symbol = reader.get_string();
+        auto quantity = reader.get<int>();
+        auto cost = reader.get<double>();
+        auto slippage = reader.get<double>();
+        return std::make_unique<events::FillEvent>(symbol, quantity, cost, slippage, reader.get<double>(), when);
+    } else if (type == "REBALANCE") {
+        std::vector<std::pair<std::string, double>> targets(reader.get_count(sizeof(uint64_t) + sizeof(double)));
+        for (auto& target : targets) {
+            target.first = reader.get_string();
+            target.second = reader.get<double>();
+        }
+        return std::make_unique<events::RebalanceEvent>(targets, when);
+    } else if (type == "FILLS") {
+        std::vector<events::FillEvent> fills;
+        for (auto count = reader.get<uint64_t>(); count > 0; --count) {
+            fills.push_back(dynamic_cast<events::FillEvent&>(*get_event(reader, schedule)));
+        }
+        return std::make_unique<events::FillsEvent>(std::move(fills), when);
+    } else if (type == "SCHEDULED") {
+        return schedule(reader.get<uint32_t>(), when);
+    } else if (type == "STOP") {
+        return std::make_unique<events::StopEvent>(reader.get_string(), when);
+    }
+    throw std::runtime_error("Unknown event type " + type + " in checkpoint!");
+}
+
+// The STACK can only be walked by popping, so each event is pushed back on after it is written
+void put_events(Writer &writer, std::queue<std::unique_ptr<events::Event>> &stack,
+                const std::list<std::unique_ptr<events::Event>> &heap) {
+    writer.put<uint64_t>(stack.size());
+    for (size_t i = stack.size(); i > 0; --i) {
+        put_event(writer, *stack.front());
+        stack.push(std::move(stack.front()));
+        stack.pop();
+    }
+    writer.put<uint64_t>(heap.size());
+    for (const auto& event : heap) { put_event(writer, *event); }
+}
+
+// Clears both containers and fills them in their saved order
+void get_events(Reader &reader, std::queue<std::unique_ptr<events::Event>> &stack,
+                std::list<std::unique_ptr<events::Event>> &heap, const ScheduleFactory &schedule) {
+    stack = std::queue<std::unique_ptr<events::Event>>();
+    heap.clear();
+    auto stack_size = reader.get<uint64_t>();
+    for (uint64_t i = 0; i < stack_size; ++i) { stack.push(get_event(reader, schedule)); }
+    auto heap_size = reader.get<uint64_t>();
+    for (uint64_t i = 0; i < heap_size; ++i) { heap.push_back(get_event(reader, schedule)); }
+}
+
+}
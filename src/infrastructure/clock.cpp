@@ -0,0 +1,78 @@
+// Include corresponding header
+#include "clock.hpp"
+
+// Reads the system clock to the millisecond, so an event is run within a millisecond of coming due rather than
+// up to a second later
+BloombergLP::blpapi::Datetime WallClock::now() {
+    auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    timespec time{};
+    time.tv_sec = static_cast<time_t>(since_epoch / 1000000000LL);
+    time.tv_nsec = static_cast<long>(since_epoch % 1000000000LL);
+    return date_funcs::from_timespec(time);
+}
+
+// Events are only run once the clock is strictly past their datetime, and this clock has millisecond resolution,
+// so the deadline is one millisecond after the target.
+timespec WallClock::deadline(const BloombergLP::blpapi::Datetime &when) {
+    timespec toReturn = date_funcs::to_timespec(when);
+    toReturn.tv_nsec += 1000000L;
+    if (toReturn.tv_nsec >= 1000000000L) {
+        toReturn.tv_sec += 1;
+        toReturn.tv_nsec -= 1000000000L;
+    }
+    return toReturn;
+}
+
+// Anchors the simulated start to the current wall-clock time
+ReplayClock::ReplayClock(const BloombergLP::blpapi::Datetime &p_start, double p_speed) :
+        start(p_start),
+        speed(p_speed),
+        steady_start(std::chrono::steady_clock::now()),
+        system_start(std::chrono::system_clock::now()),
+        current(p_start) {}
+
+// Paced clocks scale the time elapsed since the anchor, the fast clock returns wherever the replay has moved it
+BloombergLP::blpapi::Datetime ReplayClock::now() {
+    if (!paced()) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return current;
+    }
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - steady_start).count();
+    timespec time = date_funcs::to_timespec(start);
+    auto millis = static_cast<long long>(elapsed * speed) + time.tv_nsec / 1000000L;
+    time.tv_sec += static_cast<time_t>(millis / 1000);
+    time.tv_nsec = static_cast<long>(millis % 1000) * 1000000L;
+    return date_funcs::from_timespec(time);
+}
+
+// Converts the simulated time into a wall-clock deadline. When running as fast as possible the replay wakes the
+// event loop itself whenever it moves the clock, so this only needs to be a short backstop.
+timespec ReplayClock::deadline(const BloombergLP::blpapi::Datetime &when) {
+    std::chrono::system_clock::time_point target = paced() ?
+            system_start + std::chrono::microseconds(static_cast<long long>((millis_since_start(when) + 1) * 1000 / speed)) :
+            std::chrono::system_clock::now() + std::chrono::milliseconds(10);
+    auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(target.time_since_epoch()).count();
+    timespec toReturn{};
+    toReturn.tv_sec = static_cast<time_t>(since_epoch / 1000000000LL);
+    toReturn.tv_nsec = static_cast<long>(since_epoch % 1000000000LL);
+    return toReturn;
+}
+
+// The steady clock time at which a paced replay reaches the given simulated time
+std::chrono::steady_clock::time_point ReplayClock::real_time(const BloombergLP::blpapi::Datetime &when) const {
+    return steady_start + std::chrono::microseconds(static_cast<long long>(millis_since_start(when) * 1000 / speed));
+}
+
+// Only ever moves the time forwards
+void ReplayClock::advance(const BloombergLP::blpapi::Datetime &when) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (date_funcs::is_greater(when, current)) { current = when; }
+}
+
+// Difference of the two times in milliseconds
+double ReplayClock::millis_since_start(const BloombergLP::blpapi::Datetime &when) const {
+    timespec from = date_funcs::to_timespec(start);
+    timespec to = date_funcs::to_timespec(when);
+    return static_cast<double>(to.tv_sec - from.tv_sec) * 1000.0 + static_cast<double>(to.tv_nsec - from.tv_nsec) / 1000000.0;
+}
@@ -161,7 +161,8 @@ std::vector<BloombergLP::blpapi::Datetime> DateRules::get_date_times(const TimeR
             // Iterate through each date, incremented by day
             while (starttimet < endtimet) {
                 // Make sure the datetime is a weekday, so functions are not run on weekends
-                struct tm tempTime = *localtime(&starttimet);
+                struct tm tempTime{};
+                localtime_r(&starttimet, &tempTime);
                 if (tempTime.tm_wday > 0 && tempTime.tm_wday < 6) {
                     std::vector<BloombergLP::blpapi::Datetime> datesToPush = time_rules.get_time(
                             BloombergLP::blpapi::Datetime(
@@ -187,7 +188,8 @@ std::vector<BloombergLP::blpapi::Datetime> DateRules::get_date_times(const TimeR
             // Iterate through each date, incremented by day
             while (starttimet < endtimet) {
                 // Make sure the datetime is the right offset date
-                struct tm tempTime = *localtime(&starttimet);
+                struct tm tempTime{};
+                localtime_r(&starttimet, &tempTime);
                 if (tempTime.tm_wday == 1 + days_offset) {
                     std::vector<BloombergLP::blpapi::Datetime> datesToPush = time_rules.get_time(
                             BloombergLP::blpapi::Datetime(
@@ -213,7 +215,8 @@ std::vector<BloombergLP::blpapi::Datetime> DateRules::get_date_times(const TimeR
             // Iterate through each date, incremented by day
             while (starttimet < endtimet) {
                 // Make sure the datetime is on the right day of the week
-                struct tm tempTime = *localtime(&starttimet);
+                struct tm tempTime{};
+                localtime_r(&starttimet, &tempTime);
                  if (tempTime.tm_wday == 5 - days_offset) {
                      std::vector<BloombergLP::blpapi::Datetime> datesToPush = time_rules.get_time(
                              BloombergLP::blpapi::Datetime(
@@ -239,7 +242,8 @@ std::vector<BloombergLP::blpapi::Datetime> DateRules::get_date_times(const TimeR
             // Iterate through each date, incremented by day
             while (starttimet < endtimet) {
                 // Make sure the datetime is on the right day of the week
-                struct tm tempTime = *localtime(&starttimet);
+                struct tm tempTime{};
+                localtime_r(&starttimet, &tempTime);
                 if (tempTime.tm_mday - 1 == days_offset) {
                     std::vector<BloombergLP::blpapi::Datetime> datesToPush = time_rules.get_time(
                             BloombergLP::blpapi::Datetime(
@@ -265,7 +269,8 @@ std::vector<BloombergLP::blpapi::Datetime> DateRules::get_date_times(const TimeR
             // Iterate through each date, incremented by day
             while (starttimet < endtimet) {
                 // Make sure the datetime is on the right day of the week
-                struct tm tempTime = *localtime(&starttimet);
+                struct tm tempTime{};
+                localtime_r(&starttimet, &tempTime);
 
                 // To get days from end of month, need to specify for certain dates
                 int daysInMonth = 31;
@@ -329,13 +334,14 @@ BloombergLP::blpapi::Datetime add_seconds(const BloombergLP::blpapi::Datetime& c
     time_t initial_date = mktime(&timeinfo);
     time_t date_seconds = mktime(&timeinfo) + seconds;
     // Put the updated date back into a Bloomberg::blpapi::Datetime
-    timeinfo = *localtime(&date_seconds);
-    struct tm initialtimeinfo = *localtime(&initial_date);
+    localtime_r(&date_seconds, &timeinfo);
+    struct tm initialtimeinfo{};
+    localtime_r(&initial_date, &initialtimeinfo);
 
     // If looking for weekdays only continue checking, should only run twice
     while (weekDaysOnly && (timeinfo.tm_wday == 0 || timeinfo.tm_wday == 6)) {
         date_seconds = mktime(&timeinfo) + seconds;
-        timeinfo = *localtime(&date_seconds);
+        localtime_r(&date_seconds, &timeinfo);
     }
 
     // Compare the initial time and the updated time against the mode
@@ -401,10 +407,43 @@ BloombergLP::blpapi::Datetime add_seconds(const BloombergLP::blpapi::Datetime& c
 // Function for getting the current time as a Datetime
 BloombergLP::blpapi::Datetime get_now() {
     std::time_t t = std::time(nullptr);
-    std::tm* now = std::localtime(&t);
-    return BloombergLP::blpapi::Datetime((unsigned int)now->tm_year + 1900, (unsigned int)now->tm_mon + 1,
-                                             (unsigned int)now->tm_mday, (unsigned int)now->tm_hour,
-                                             (unsigned int)now->tm_min, (unsigned int)now->tm_sec);
+    std::tm now{};
+    localtime_r(&t, &now);
+    return BloombergLP::blpapi::Datetime((unsigned int)now.tm_year + 1900, (unsigned int)now.tm_mon + 1,
+                                             (unsigned int)now.tm_mday, (unsigned int)now.tm_hour,
+                                             (unsigned int)now.tm_min, (unsigned int)now.tm_sec);
+}
+
+// Converts a local Datetime into seconds and nanoseconds since epoch for timed waits
+timespec to_timespec(const BloombergLP::blpapi::Datetime& date) {
+    struct tm timeinfo = {0, 0, 0};
+    timeinfo.tm_year = date.year() - 1900;
+    timeinfo.tm_mon = date.month() - 1;
+    timeinfo.tm_mday = date.day();
+    timeinfo.tm_hour = date.hours();
+    timeinfo.tm_min = date.minutes();
+    timeinfo.tm_sec = date.seconds();
+    // Let mktime figure out whether daylight savings applies on that date
+    timeinfo.tm_isdst = -1;
+    timespec toReturn{};
+    toReturn.tv_sec = mktime(&timeinfo);
+    toReturn.tv_nsec = static_cast<long>(date.milliseconds()) * 1000000L;
+    return toReturn;
+}
+
+// Breaks seconds since epoch back down into a local Datetime with milliseconds
+BloombergLP::blpapi::Datetime from_timespec(const timespec& time) {
+    time_t seconds = time.tv_sec;
+    std::tm timeinfo{};
+    localtime_r(&seconds, &timeinfo);
+    return BloombergLP::blpapi::Datetime(
+            static_cast<unsigned int>(timeinfo.tm_year) + 1900,
+            static_cast<unsigned int>(timeinfo.tm_mon + 1),
+            static_cast<unsigned int>(timeinfo.tm_mday),
+            static_cast<unsigned int>(timeinfo.tm_hour),
+            static_cast<unsigned int>(timeinfo.tm_min),
+            static_cast<unsigned int>(timeinfo.tm_sec),
+            static_cast<unsigned int>(time.tv_nsec / 1000000L));
 }
 
 // Compares two dates, returning true if the first is greater than the second
@@ -437,4 +476,40 @@ bool is_greater(const BloombergLP::blpapi::Datetime& first, const BloombergLP::b
             }
         }
     }
-}
\ No newline at end of file
+
+// Converts a GMT datetime to local time by working out its seconds since epoch directly from the civil date
+// (there is no portable inverse of gmtime) and then breaking that down with localtime
+BloombergLP::blpapi::Datetime utc_to_local(const BloombergLP::blpapi::Datetime& utc) {
+    // Days since epoch of the civil date, counting years from March so leap days fall at the end of the year
+    long year = static_cast<long>(utc.year()) - (utc.month() <= 2 ? 1 : 0);
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long yoe = year - era * 400;
+    long doy = (153 * (utc.month() + (utc.month() > 2 ? -3 : 9)) + 2) / 5 + utc.day() - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    long days = era * 146097 + doe - 719468;
+    time_t seconds = static_cast<time_t>(days) * 24 * 60 * 60 + utc.hours() * 60 * 60 + utc.minutes() * 60 + utc.seconds();
+    std::tm timeinfo{};
+    localtime_r(&seconds, &timeinfo);
+    return BloombergLP::blpapi::Datetime(
+            static_cast<unsigned int>(timeinfo.tm_year) + 1900,
+            static_cast<unsigned int>(timeinfo.tm_mon + 1),
+            static_cast<unsigned int>(timeinfo.tm_mday),
+            static_cast<unsigned int>(timeinfo.tm_hour),
+            static_cast<unsigned int>(timeinfo.tm_min),
+            static_cast<unsigned int>(timeinfo.tm_sec), utc.milliseconds());
+}
+
+// Converts a local datetime to GMT using mktime and gmtime
+BloombergLP::blpapi::Datetime local_to_utc(const BloombergLP::blpapi::Datetime& local) {
+    time_t seconds = to_timespec(local).tv_sec;
+    std::tm timeinfo{};
+    gmtime_r(&seconds, &timeinfo);
+    return BloombergLP::blpapi::Datetime(
+            static_cast<unsigned int>(timeinfo.tm_year) + 1900,
+            static_cast<unsigned int>(timeinfo.tm_mon + 1),
+            static_cast<unsigned int>(timeinfo.tm_mday),
+            static_cast<unsigned int>(timeinfo.tm_hour),
+            static_cast<unsigned int>(timeinfo.tm_min),
+            static_cast<unsigned int>(timeinfo.tm_sec), local.milliseconds());
+}
+}
@@ -14,18 +14,27 @@ void Event::concise_what() { std::cout << "Date: " << datetime << ", Type: " <<
 // Market Event initializer list
 MarketEvent::MarketEvent(const std::vector<std::string> &p_symbols,
                          const std::unordered_map<std::string, double> &p_data,
-                         const BloombergLP::blpapi::Datetime &p_when) :
+                         const BloombergLP::blpapi::Datetime &p_when,
+                         std::unordered_set<std::string> p_stale) :
         Event("MARKET", p_when),
         symbols(p_symbols),
-        data(p_data) {}
+        data(p_data),
+        stale(std::move(p_stale)) {}
 
 // Print function for MarketEvent
 void MarketEvent::what() {
     std::cout << "Event: MARKET\nDatetime: " << datetime << "\nData: ";
-    for (const std::string &i : symbols) { std::cout << i << "=" << data.at(i) << ", "; };
+    for (const std::string &i : symbols) {
+        std::cout << i << "=" << data.at(i) << (is_stale(i) ? " (stale), " : ", ");
+    }
     std::cout << "\b\n\n";
 }
 
+// Looked up in the set, as it is for every symbol of every event that builds a per-bar series
+bool MarketEvent::is_stale(const std::string &symbol) const {
+    return stale.count(symbol) != 0;
+}
+
 // Signal Event initializer list
 SignalEvent::SignalEvent(const std::string &p_symbol, double p_percentage,
                          const BloombergLP::blpapi::Datetime &p_when) :
@@ -66,6 +75,32 @@ void FillEvent::what() {
               << "\nCost: " << cost << "\nSlippage: " << slippage << "\nCommission: " << commission << "\n";
 }
 
+// Rebalance Event initializer list
+RebalanceEvent::RebalanceEvent(const std::vector<std::pair<std::string, double>> &p_targets,
+                               const BloombergLP::blpapi::Datetime &when) :
+        Event("REBALANCE", when),
+        targets(p_targets) {}
+
+// Print function for the RebalanceEvent
+void RebalanceEvent::what() {
+    std::cout << "Event: REBALANCE\nDatetime: " << datetime << "\nTargets: ";
+    for (const auto& target : targets) { std::cout << target.first << "=" << target.second << "%, "; }
+    std::cout << "\b\n\n";
+}
+
+// Fills Event initializer list
+FillsEvent::FillsEvent(std::vector<FillEvent> p_fills, const BloombergLP::blpapi::Datetime &when) :
+        Event("FILLS", when),
+        fills(std::move(p_fills)) {}
+
+// Print function for the FillsEvent
+void FillsEvent::what() {
+    std::cout << "Event: FILLS\nDatetime: " << datetime << "\nFills: " << fills.size() << "\n";
+    for (const FillEvent& fill : fills) {
+        std::cout << "  " << fill.symbol << ": " << fill.quantity << " for " << fill.cost << "\n";
+    }
+}
+
 // Stop Event initializer list
 StopEvent::StopEvent(const std::string &p_reason, const BloombergLP::blpapi::Datetime& when) :
     Event("STOP", when),
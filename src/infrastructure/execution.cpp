@@ -21,11 +21,20 @@ ExecutionHandler::ExecutionHandler(std::queue<std::unique_ptr<events::Event>> *p
 // portfolio holdings are as up-to-date as possible.
 void ExecutionHandler::process_signal(const events::SignalEvent &event) {
 
-    // Before doing anything, recalculate portfolio holdings with a simulated MarketEvent
-    std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> recentprice =
-            std::move(data_manager->history({event.symbol}, {"PX_LAST"}, 4, "RECENT"));
-    auto data = recentprice->at(event.symbol).data.rbegin();
-    portfolio->update_market(events::MarketEvent({event.symbol}, {{event.symbol, data->second["PX_LAST"]}}, data->first));
+    // Before doing anything, recalculate portfolio holdings with a simulated MarketEvent. Use the live quote if
+    // there is one, otherwise the most recent price from history.
+    double price;
+    Quote quote;
+    if (get_quote(event.symbol, quote, event.datetime) && quote.mark() > 0) {
+        price = quote.mark();
+        portfolio->update_market(events::MarketEvent({event.symbol}, {{event.symbol, price}}, quote.time));
+    } else {
+        std::shared_ptr<const std::unordered_map<std::string, SymbolHistoricalData>> recentprice =
+                data_manager->history({event.symbol}, {"PX_LAST"}, 4, "RECENT");
+        auto data = recentprice->at(event.symbol).data.rbegin();
+        price = data->second.at("PX_LAST");
+        portfolio->update_market(events::MarketEvent({event.symbol}, {{event.symbol, price}}, data->first));
+    }
 
     // Determine what percentage of the portfolio must be filled based on the totalholdings, heldcash, and current holdings.
     double current_percent = portfolio->current_holdings[event.symbol] / portfolio->current_holdings[portfolio_fields::TOTAL_HOLDINGS];
@@ -35,8 +44,7 @@ void ExecutionHandler::process_signal(const events::SignalEvent &event) {
     // Convert the percent to a quantity of the stock, chopping off any decimals so that never go over the percent we
     // want, only up to (using floor when greater and ceil when less than 0)
     double cost = percent_needed * portfolio->current_holdings[portfolio_fields::TOTAL_HOLDINGS];
-    double noRoundQuantity = (cost / data->second["PX_LAST"] > 0) ?
-            std::floor(cost / data->second["PX_LAST"]) : std::ceil(cost / data->second["PX_LAST"]);
+    double noRoundQuantity = (cost / price > 0) ? std::floor(cost / price) : std::ceil(cost / price);
     int quantity = (event.percentage == 0) ?
             portfolio->current_positions[event.symbol] * -1 : static_cast<int>(noRoundQuantity);
     // Now build the order event and place it onto the STACK to be filled as soon as possible
@@ -49,22 +57,138 @@ void ExecutionHandler::process_signal(const events::SignalEvent &event) {
 // think that they have the same amount of cash available.
 void ExecutionHandler::process_order(const events::OrderEvent &event) {
 
-    // First, get the price of the stock (should be the most recent one as this event is run on the STACK after
-    // the stock data has already been updated for the signal order).
-    std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> recentprice =
-            std::move(data_manager->history({event.symbol}, {"PX_LAST"}, 4, "RECENT"));
-    double price = recentprice->at(event.symbol).data.rbegin()->second["PX_LAST"];
-
     // Make sure the market can handle the order as well. Orders should not get filled if they exceed a
     // certain amount of the market volume in a stock.
     // TODO: Implement market volume limit here
-    int quantity = event.quantity;
-    double cost = quantity * price;
+    Quote quote;
+    if (get_quote(event.symbol, quote, event.datetime) && quote.bid > 0 && quote.ask > 0) {
+        stack_eventlist->emplace(std::make_unique<events::FillEvent>(
+                fill_order(event.symbol, event.quantity, quote.mark(), &quote, event.datetime)));
+        return;
+    }
 
-    // Calculate slippage and transaction costs on the order cost
-    double slippage = Slippage::get_slippage(price * quantity);
-    double commission = TransactionCosts::get_IB_transaction_cost(quantity);
+    // Otherwise, get the price of the stock (should be the most recent one as this event is run on the STACK after
+    // the stock data has already been updated for the signal order)
+    std::shared_ptr<const std::unordered_map<std::string, SymbolHistoricalData>> recentprice =
+            data_manager->history({event.symbol}, {"PX_LAST"}, 4, "RECENT");
+    double price = recentprice->at(event.symbol).data.rbegin()->second.at("PX_LAST");
 
     // Place a fill event onto the STACK to be performed as soon as possible
-    stack_eventlist->emplace(std::make_unique<events::FillEvent>(event.symbol, quantity, cost, slippage, commission, event.datetime));
-}
\ No newline at end of file
+    stack_eventlist->emplace(std::make_unique<events::FillEvent>(
+            fill_order(event.symbol, event.quantity, price, nullptr, event.datetime)));
+}
+
+// Processes a Rebalance Event the way process_signal and process_order process each of its symbols, but with a
+// single revaluation of the portfolio and a single history call for the symbols without a quote.
+void ExecutionHandler::process_rebalance(const events::RebalanceEvent &event) {
+
+    // Net the targets so each symbol is ordered once, the last target requested for it winning
+    std::vector<std::string> symbols;
+    std::unordered_map<std::string, double> targets;
+    for (const auto& target : event.targets) {
+        if (targets.find(target.first) == targets.end()) { symbols.push_back(target.first); }
+        targets[target.first] = target.second;
+    }
+    if (symbols.empty()) { return; }
+
+    // Price every symbol from its live quote if it has one, and all of the rest from one history call
+    std::unordered_map<std::string, double> prices;
+    std::unordered_map<std::string, Quote> quoted;
+    std::vector<std::string> unquoted;
+    BloombergLP::blpapi::Datetime latest;
+    bool priced = false;
+    for (const std::string& symbol : symbols) {
+        Quote quote;
+        if (get_quote(symbol, quote, event.datetime) && quote.mark() > 0) {
+            prices[symbol] = quote.mark();
+            quoted[symbol] = quote;
+            if (!priced || latest < quote.time) { latest = quote.time; }
+            priced = true;
+        } else {
+            unquoted.push_back(symbol);
+        }
+    }
+    if (!unquoted.empty()) {
+        std::shared_ptr<const std::unordered_map<std::string, SymbolHistoricalData>> recentprices =
+                data_manager->history(unquoted, {"PX_LAST"}, 4, "RECENT");
+        for (const std::string& symbol : unquoted) {
+            auto data = recentprices->at(symbol).data.rbegin();
+            prices[symbol] = data->second.at("PX_LAST");
+            if (!priced || latest < data->first) { latest = data->first; }
+            priced = true;
+        }
+    }
+
+    // Recalculate the portfolio holdings with all the prices in one simulated MarketEvent
+    portfolio->update_market(events::MarketEvent(symbols, prices, latest));
+    const double total = portfolio->current_holdings[portfolio_fields::TOTAL_HOLDINGS];
+
+    // Size each order as process_signal does, but all from the total holdings before any of them are filled
+    std::vector<std::pair<std::string, int>> orders;
+    for (const std::string& symbol : symbols) {
+        double percent_needed = targets[symbol] - portfolio->current_holdings[symbol] / total;
+        if (std::abs(percent_needed) < 0.00001) { continue; }
+        double noRoundQuantity = percent_needed * total / prices[symbol];
+        noRoundQuantity = (noRoundQuantity > 0) ? std::floor(noRoundQuantity) : std::ceil(noRoundQuantity);
+        int quantity = (targets[symbol] == 0) ?
+                portfolio->current_positions[symbol] * -1 : static_cast<int>(noRoundQuantity);
+        if (quantity != 0) { orders.emplace_back(symbol, quantity); }
+    }
+    if (orders.empty()) { return; }
+
+    // Fill the sells first and then the buys, each in the order they were requested
+    std::stable_partition(orders.begin(), orders.end(),
+                          [](const std::pair<std::string, int>& order) { return order.second < 0; });
+    std::vector<events::FillEvent> fills;
+    fills.reserve(orders.size());
+    for (const auto& order : orders) {
+        auto quote = quoted.find(order.first);
+        fills.push_back(fill_order(order.first, order.second, prices[order.first],
+                                   quote != quoted.end() ? &quote->second : nullptr, event.datetime));
+    }
+
+    // Place all the fills onto the STACK together to be performed as soon as possible
+    stack_eventlist->emplace(std::make_unique<events::FillsEvent>(std::move(fills), event.datetime));
+}
+
+// With a two-sided live quote, the order is filled at the touch, booked as a cost at the mid plus the distance from
+// the mid to the ask (buying) or bid (selling) as slippage. Otherwise the slippage is simulated, or its expected
+// value if asked for.
+events::FillEvent ExecutionHandler::fill_order(const std::string &symbol, int quantity, double price,
+                                               const Quote *quote, const BloombergLP::blpapi::Datetime &when) {
+    double cost, slippage;
+    if (quote && quote->bid > 0 && quote->ask > 0) {
+        double mid = quote->mark();
+        double fill = (quantity > 0) ? quote->ask : quote->bid;
+        cost = quantity * mid;
+        slippage = std::abs(quantity * (fill - mid));
+    } else {
+        cost = quantity * price;
+        slippage = expected_slippage ? Slippage::get_expected_slippage(price * quantity) :
+                   Slippage::get_slippage(price * quantity);
+    }
+
+    // Calculate transaction costs on the order
+    double commission = TransactionCosts::get_IB_transaction_cost(quantity);
+    return events::FillEvent(symbol, quantity, cost, slippage, commission, when);
+}
+
+// Sets the quote book to price from
+void ExecutionHandler::use_quotes(const QuoteBook* p_quotes, pthread_mutex_t* p_mtx, unsigned int max_age) {
+    quotes = p_quotes;
+    quotes_mtx = p_mtx;
+    max_quote_age = max_age;
+}
+
+// Copies the quote out under the mutex so the feed thread cannot write it halfway through. A stale quote is passed
+// over, so the symbol is priced from history instead.
+bool ExecutionHandler::get_quote(const std::string &symbol, Quote &quote, const BloombergLP::blpapi::Datetime &when) {
+    if (!quotes) { return false; }
+    pthread_mutex_lock(quotes_mtx);
+    long index = quotes->index_of(symbol);
+    if (index >= 0) { quote = quotes->quotes[index]; }
+    pthread_mutex_unlock(quotes_mtx);
+    if (index < 0) { return false; }
+    return max_quote_age == 0 ||
+           date_funcs::to_timespec(when).tv_sec - date_funcs::to_timespec(quote.time).tv_sec <= max_quote_age;
+}
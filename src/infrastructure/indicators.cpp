@@ -0,0 +1,199 @@
+// Include corresponding header
+#include "indicators.hpp"
+// STL includes
+#include <algorithm>
+#include <cmath>
+
+// Allocates the whole window up front
+RollingIndicators::RollingIndicators(unsigned int window, unsigned int ema_span) :
+        values(std::max(1u, window)),
+        alpha(2.0 / ((ema_span ? ema_span : std::max(1u, window)) + 1)) {}
+
+// Removes the oldest value first when the window is full, shifting every position down by one, then adds the new
+// value at the end
+void RollingIndicators::update(double value) {
+    if (ready()) {
+        const double oldest = values[next];
+        weighted_sum -= average * count - oldest;
+        count--;
+        if (count == 0) {
+            average = m2 = 0;
+        } else {
+            const double delta = oldest - average;
+            average -= delta / count;
+            m2 -= delta * (oldest - average);
+        }
+    }
+    weighted_sum += value * count;
+    count++;
+    const double delta = value - average;
+    average += delta / count;
+    m2 += delta * (value - average);
+
+    values[next] = value;
+    next = (next + 1) % values.size();
+    if (next == 0) { refresh(); }
+
+    // Values which can no longer be the extreme are dropped from the back, and ones leaving the window from the front
+    while (!minima.empty() && minima.back().second >= value) { minima.pop_back(); }
+    while (!maxima.empty() && maxima.back().second <= value) { maxima.pop_back(); }
+    minima.emplace_back(sequence, value);
+    maxima.emplace_back(sequence, value);
+    sequence++;
+    while (minima.front().first + values.size() < sequence) { minima.pop_front(); }
+    while (maxima.front().first + values.size() < sequence) { maxima.pop_front(); }
+
+    smoothed = sequence == 1 ? value : smoothed + alpha * (value - smoothed);
+}
+
+// Two passes over the window, which is full and starts at slot 0 whenever this is called
+void RollingIndicators::refresh() {
+    double sum = 0;
+    for (double value : values) { sum += value; }
+    average = sum / count;
+    m2 = weighted_sum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        m2 += (values[i] - average) * (values[i] - average);
+        weighted_sum += values[i] * i;
+    }
+}
+
+// Counts back from the slot before the next one
+double RollingIndicators::back(size_t ago) const {
+    if (ago >= count) { throw std::runtime_error("Indicator window holds fewer values than asked back for!"); }
+    return values[(next + values.size() - 1 - ago) % values.size()];
+}
+
+// Running mean
+double RollingIndicators::mean() const { return average; }
+// Population variance, which is what the bands are conventionally built on
+double RollingIndicators::variance() const { return count ? std::max(0.0, m2 / count) : 0; }
+// Square root of the variance
+double RollingIndicators::stddev() const { return std::sqrt(variance()); }
+
+// The positions 0..n-1 have mean (n-1)/2 and sum of squared deviations n(n^2-1)/12, so only the sum of the values
+// times their positions needs to be kept
+double RollingIndicators::slope() const {
+    if (count < 2) { return 0; }
+    const auto n = static_cast<double>(count);
+    return (weighted_sum - (n - 1) / 2 * n * average) / (n * (n * n - 1) / 12);
+}
+// Passes through the means of the positions and the values
+double RollingIndicators::intercept() const { return average - slope() * (static_cast<double>(count) - 1) / 2; }
+// The regression line at the position
+double RollingIndicators::fitted(double position) const { return intercept() + slope() * position; }
+
+// Bands around the mean
+double RollingIndicators::upper_band(double deviations) const { return average + deviations * stddev(); }
+double RollingIndicators::lower_band(double deviations) const { return average - deviations * stddev(); }
+
+// Seeded with the first value
+double RollingIndicators::ema() const { return smoothed; }
+// Fronts of the monotonic queues
+double RollingIndicators::min() const { return minima.empty() ? 0 : minima.front().second; }
+double RollingIndicators::max() const { return maxima.empty() ? 0 : maxima.front().second; }
+
+// Zero while the window has no spread
+double RollingIndicators::zscore() const {
+    const double deviation = stddev();
+    return (count && deviation > 0) ? (back() - average) / deviation : 0;
+}
+
+// The window oldest first, then the EMA
+void RollingIndicators::write_checkpoint(checkpoint::Writer &writer) const {
+    std::vector<double> window_values(count);
+    for (size_t i = 0; i < count; ++i) { window_values[i] = back(count - 1 - i); }
+    writer.put<uint64_t>(values.size());
+    writer.put_array(window_values);
+    writer.put<uint64_t>(sequence);
+    writer.put(smoothed);
+}
+
+// Replays the window into an empty one, then puts back the EMA and count which cover more than the window
+void RollingIndicators::read_checkpoint(checkpoint::Reader &reader) {
+    if (reader.get<uint64_t>() != values.size()) {
+        throw std::runtime_error("Checkpoint indicators were written with a different window!");
+    }
+    const std::vector<double> window_values = reader.get_array<double>();
+    std::fill(values.begin(), values.end(), 0);
+    next = count = 0;
+    sequence = 0;
+    average = m2 = weighted_sum = 0;
+    minima.clear();
+    maxima.clear();
+    for (double value : window_values) { update(value); }
+
+    // Renumber the queues to carry on from the checkpointed count
+    const unsigned long long checkpointed = reader.get<uint64_t>();
+    for (auto& entry : minima) { entry.first += checkpointed - sequence; }
+    for (auto& entry : maxima) { entry.first += checkpointed - sequence; }
+    sequence = checkpointed;
+    smoothed = reader.get<double>();
+}
+
+// Numbers the symbols in order
+Indicators::Indicators(const std::vector<std::string> &symbols, unsigned int window, unsigned int ema_span) :
+        rolling(symbols.size(), RollingIndicators(window, ema_span)) {
+    for (size_t i = 0; i < symbols.size(); ++i) { ids[symbols[i]] = i; }
+}
+
+// Symbols not in the set, without a price, or whose price is only carried forward (e.g. after they delisted) are left
+// as they were, so a stale price never counts as another bar
+void Indicators::update(const events::MarketEvent &event) {
+    if (updated && !(latest < event.datetime)) { return; }
+    for (const std::string& symbol : event.symbols) {
+        auto symbol_id = ids.find(symbol);
+        auto price = event.data.find(symbol);
+        if (symbol_id == ids.end() || price == event.data.end() || std::isnan(price->second) ||
+            event.is_stale(symbol)) { continue; }
+        rolling[symbol_id->second].update(price->second);
+    }
+    updated = true;
+    latest = event.datetime;
+}
+
+// The bars are already in time order in each symbol's map
+void Indicators::seed(const std::unordered_map<std::string, SymbolHistoricalData> &history, const std::string &field) {
+    for (const auto& symbol : history) {
+        auto symbol_id = ids.find(symbol.first);
+        if (symbol_id == ids.end()) { continue; }
+        for (const auto& bar : symbol.second.data) {
+            if (updated && !(latest < bar.first)) { continue; }
+            auto value = bar.second.find(field);
+            if (value == bar.second.end() || std::isnan(value->second)) { continue; }
+            rolling[symbol_id->second].update(value->second);
+        }
+    }
+    // Only move the time on after every symbol has been seeded up to it
+    for (const auto& symbol : history) {
+        if (!symbol.second.data.empty() && (!updated || latest < symbol.second.data.rbegin()->first)) {
+            updated = true;
+            latest = symbol.second.data.rbegin()->first;
+        }
+    }
+}
+
+// Looks the symbol up in the ids
+size_t Indicators::id(const std::string &symbol) const {
+    auto symbol_id = ids.find(symbol);
+    if (symbol_id == ids.end()) { throw std::runtime_error("No indicators kept for " + symbol + "!"); }
+    return symbol_id->second;
+}
+
+// The time of the last update, then each symbol's indicators by id
+void Indicators::write_checkpoint(checkpoint::Writer &writer) const {
+    writer.put<uint8_t>(updated);
+    writer.put(latest);
+    writer.put<uint64_t>(rolling.size());
+    for (const RollingIndicators& indicators : rolling) { indicators.write_checkpoint(writer); }
+}
+
+// Reads back in the order written
+void Indicators::read_checkpoint(checkpoint::Reader &reader) {
+    updated = reader.get<uint8_t>() != 0;
+    latest = reader.get_datetime();
+    if (reader.get<uint64_t>() != rolling.size()) {
+        throw std::runtime_error("Checkpoint indicators were written for a different symbol list!");
+    }
+    for (RollingIndicators& indicators : rolling) { indicators.read_checkpoint(reader); }
+}
@@ -0,0 +1,119 @@
+// Include corresponding header
+#include "instrumentation.hpp"
+
+#ifdef BACKTESTER_INSTRUMENTATION
+
+// STL includes
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+// JSON includes
+#include <nlohmann/json.hpp>
+
+namespace instrumentation {
+
+namespace {
+    // Names of the categories as reported
+    const char* CATEGORY_NAMES[NUM_CATEGORIES] = {"MARKET", "SIGNAL", "ORDER", "FILL", "REBALANCE", "FILLS",
+                                                  "SCHEDULED", "STOP", "OTHER", "history()"};
+
+    // Prints one row of the table
+    void report_row(std::ostream& out, const std::string& name, const Timings& timings) {
+        out << std::left << std::setw(16) << name << std::right
+            << std::setw(12) << timings.count
+            << std::setw(14) << std::fixed << std::setprecision(3) << timings.total_ns / 1e6
+            << std::setw(12) << (timings.count ? timings.total_ns / timings.count : 0)
+            << std::setw(12) << timings.percentile(0.5)
+            << std::setw(12) << timings.percentile(0.99)
+            << std::setw(12) << timings.max_ns << "\n";
+    }
+
+    // One object of the dump
+    nlohmann::json dump_timings(const Timings& timings) {
+        // Only the buckets up to the highest one used, to keep the dump short
+        size_t used = timings.buckets.size();
+        while (used > 0 && timings.buckets[used - 1] == 0) { used--; }
+        return {{"count", timings.count},
+                {"total_ns", timings.total_ns},
+                {"max_ns", timings.max_ns},
+                {"p50_ns", timings.percentile(0.5)},
+                {"p99_ns", timings.percentile(0.99)},
+                {"log2_buckets", std::vector<uint64_t>(timings.buckets.begin(), timings.buckets.begin() + used)}};
+    }
+}
+
+// Walks the buckets until the fraction of counts is reached
+uint64_t Timings::percentile(double fraction) const {
+    if (count == 0) { return 0; }
+    const auto target = static_cast<uint64_t>(fraction * count);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen > target) { return i == 0 ? 0 : std::min(max_ns, (uint64_t(1) << i) - 1); }
+    }
+    return max_ns;
+}
+
+// There is only ever one registry, shared by every strategy in the process
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+// Matches the type strings the event loops dispatch on
+Category category(const std::string& type) {
+    for (unsigned int i = 0; i < OTHER; ++i) {
+        if (type == CATEGORY_NAMES[i]) { return static_cast<Category>(i); }
+    }
+    return OTHER;
+}
+
+// Prints the timings of every category and scheduled function that recorded anything, then the queue depths
+void report(std::ostream& out) {
+    const Registry& recorded = registry();
+    const std::ios_base::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::left << std::setw(16) << "Instrumented" << std::right << std::setw(12) << "count"
+        << std::setw(14) << "total ms" << std::setw(12) << "mean ns" << std::setw(12) << "p50 ns"
+        << std::setw(12) << "p99 ns" << std::setw(12) << "max ns" << "\n";
+    for (unsigned int i = 0; i < NUM_CATEGORIES; ++i) {
+        if (recorded.categories[i].count) { report_row(out, CATEGORY_NAMES[i], recorded.categories[i]); }
+    }
+    for (size_t i = 0; i < recorded.scheduled.size(); ++i) {
+        if (recorded.scheduled[i].count) { report_row(out, "scheduled[" + std::to_string(i) + "]", recorded.scheduled[i]); }
+    }
+    if (recorded.stack.samples) {
+        out << "STACK depth mean " << std::setprecision(1) << double(recorded.stack.total) / recorded.stack.samples
+            << ", max " << recorded.stack.max << "; HEAP depth mean "
+            << double(recorded.heap.total) / recorded.heap.samples << ", max " << recorded.heap.max << "\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+// Writes the registry as one JSON object, keyed by category name
+void dump(const std::string& filepath) {
+    const Registry& recorded = registry();
+    nlohmann::json output;
+    for (unsigned int i = 0; i < NUM_CATEGORIES; ++i) {
+        output["categories"][CATEGORY_NAMES[i]] = dump_timings(recorded.categories[i]);
+    }
+    output["scheduled"] = nlohmann::json::array();
+    for (const Timings& timings : recorded.scheduled) { output["scheduled"].push_back(dump_timings(timings)); }
+    for (const auto& queue : {std::make_pair("stack", &recorded.stack), std::make_pair("heap", &recorded.heap)}) {
+        output["queues"][queue.first] = {{"samples", queue.second->samples},
+                                         {"mean", queue.second->samples ? double(queue.second->total) / queue.second->samples : 0.0},
+                                         {"max", queue.second->max}};
+    }
+
+    std::ofstream file(filepath, std::ios_base::out | std::ios_base::trunc);
+    if (!file.is_open()) { throw std::runtime_error("Could not open instrumentation file " + filepath + "!"); }
+    file << std::setw(4) << output << std::endl;
+}
+
+// Replaces the registry with an empty one
+void reset() { registry() = Registry(); }
+
+}
+
+#endif
@@ -0,0 +1,461 @@
+// Include corresponding header
+#include "kernels.hpp"
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+// The AVX2 loops are only compiled for x86, and with GCC and Clang only for the functions marked with the target,
+// so the rest of the file still runs on processors without it
+#if defined(__x86_64__) || defined(_M_X64)
+#define BT_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define BT_TARGET_AVX2
+#else
+#define BT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace kernels {
+
+namespace {
+    // The loops each instruction set provides
+    struct Table {
+        Isa isa;
+        // Replaces the old row of the window with the new one, relative to the shift, updating the sums. The new
+        // value goes in at position `position`, and `dropping` is 1 when the old row is leaving a full window.
+        void (*panel_update)(size_t n, const double* row, const double* shift, double* slot, double* sum,
+                             double* sum_squares, double* weighted_sum, double position, double dropping);
+        void (*panel_mean)(size_t n, const double* sum, const double* shift, double inverse_count, double* out);
+        void (*panel_variance)(size_t n, const double* sum, const double* sum_squares, double inverse_count,
+                               double* out);
+        // With mean_position the mean of the positions, and inverse_spread one over their sum of squared deviations
+        void (*panel_slope)(size_t n, const double* sum, const double* weighted_sum, double mean_position,
+                            double inverse_spread, double* out);
+        void (*panel_intercept)(size_t n, const double* sum, const double* weighted_sum, const double* shift,
+                                double inverse_count, double mean_position, double inverse_spread, double* out);
+        double (*sum)(const double* in, size_t n);
+        double (*squared_deviations)(const double* in, size_t n, double mean);
+        // out = (in - subtract) * multiply
+        void (*affine)(const double* in, double* out, size_t n, double subtract, double multiply);
+        void (*clamp)(const double* in, double* out, size_t n, double lower, double upper);
+        // Sums of the products, and of their absolute values
+        double (*dot)(const double* a, const double* b, size_t n);
+        double (*gross)(const double* a, const double* b, size_t n);
+    };
+
+    // MARK: Scalar loops
+
+    void scalar_panel_update(size_t n, const double* row, const double* shift, double* slot, double* sum,
+                             double* sum_squares, double* weighted_sum, double position, double dropping) {
+        for (size_t i = 0; i < n; ++i) {
+            const double value = row[i] - shift[i];
+            const double old = slot[i];
+            weighted_sum[i] = weighted_sum[i] + (position * value - dropping * (sum[i] - old));
+            sum[i] = sum[i] + (value - old);
+            sum_squares[i] = sum_squares[i] + (value * value - old * old);
+            slot[i] = value;
+        }
+    }
+
+    void scalar_panel_mean(size_t n, const double* sum, const double* shift, double inverse_count, double* out) {
+        for (size_t i = 0; i < n; ++i) { out[i] = sum[i] * inverse_count + shift[i]; }
+    }
+
+    void scalar_panel_variance(size_t n, const double* sum, const double* sum_squares, double inverse_count,
+                               double* out) {
+        for (size_t i = 0; i < n; ++i) {
+            const double mean = sum[i] * inverse_count;
+            out[i] = std::max(sum_squares[i] * inverse_count - mean * mean, 0.0);
+        }
+    }
+
+    void scalar_panel_slope(size_t n, const double* sum, const double* weighted_sum, double mean_position,
+                            double inverse_spread, double* out) {
+        for (size_t i = 0; i < n; ++i) { out[i] = (weighted_sum[i] - mean_position * sum[i]) * inverse_spread; }
+    }
+
+    void scalar_panel_intercept(size_t n, const double* sum, const double* weighted_sum, const double* shift,
+                                double inverse_count, double mean_position, double inverse_spread, double* out) {
+        for (size_t i = 0; i < n; ++i) {
+            const double slope = (weighted_sum[i] - mean_position * sum[i]) * inverse_spread;
+            out[i] = (sum[i] * inverse_count + shift[i]) - slope * mean_position;
+        }
+    }
+
+    // Four running sums, in the same order as the AVX2 lanes add them up
+    double scalar_sum(const double* in, size_t n) {
+        double lanes[4] = {0, 0, 0, 0};
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) { for (size_t lane = 0; lane < 4; ++lane) { lanes[lane] += in[i + lane]; } }
+        double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for (; i < n; ++i) { total += in[i]; }
+        return total;
+    }
+
+    double scalar_squared_deviations(const double* in, size_t n, double mean) {
+        double lanes[4] = {0, 0, 0, 0};
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            for (size_t lane = 0; lane < 4; ++lane) { lanes[lane] += (in[i + lane] - mean) * (in[i + lane] - mean); }
+        }
+        double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for (; i < n; ++i) { total += (in[i] - mean) * (in[i] - mean); }
+        return total;
+    }
+
+    void scalar_affine(const double* in, double* out, size_t n, double subtract, double multiply) {
+        for (size_t i = 0; i < n; ++i) { out[i] = (in[i] - subtract) * multiply; }
+    }
+
+    void scalar_clamp(const double* in, double* out, size_t n, double lower, double upper) {
+        for (size_t i = 0; i < n; ++i) { out[i] = std::min(std::max(in[i], lower), upper); }
+    }
+
+    double scalar_dot(const double* a, const double* b, size_t n) {
+        double lanes[4] = {0, 0, 0, 0};
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            for (size_t lane = 0; lane < 4; ++lane) { lanes[lane] += a[i + lane] * b[i + lane]; }
+        }
+        double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for (; i < n; ++i) { total += a[i] * b[i]; }
+        return total;
+    }
+
+    double scalar_gross(const double* a, const double* b, size_t n) {
+        double lanes[4] = {0, 0, 0, 0};
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            for (size_t lane = 0; lane < 4; ++lane) { lanes[lane] += std::abs(a[i + lane] * b[i + lane]); }
+        }
+        double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for (; i < n; ++i) { total += std::abs(a[i] * b[i]); }
+        return total;
+    }
+
+    const Table SCALAR_TABLE = {SCALAR, scalar_panel_update, scalar_panel_mean, scalar_panel_variance,
+                                scalar_panel_slope, scalar_panel_intercept, scalar_sum, scalar_squared_deviations,
+                                scalar_affine, scalar_clamp, scalar_dot, scalar_gross};
+
+#ifdef BT_KERNELS_X86
+    // MARK: AVX2 loops
+    // Four symbols at a time, finishing the last few with the scalar loops
+
+    BT_TARGET_AVX2 void avx2_panel_update(size_t n, const double* row, const double* shift, double* slot, double* sum,
+                                          double* sum_squares, double* weighted_sum, double position, double dropping) {
+        const __m256d positions = _mm256_set1_pd(position), drops = _mm256_set1_pd(dropping);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const __m256d value = _mm256_sub_pd(_mm256_loadu_pd(row + i), _mm256_loadu_pd(shift + i));
+            const __m256d old = _mm256_loadu_pd(slot + i);
+            const __m256d sums = _mm256_loadu_pd(sum + i);
+            const __m256d weighted = _mm256_add_pd(_mm256_loadu_pd(weighted_sum + i),
+                    _mm256_sub_pd(_mm256_mul_pd(positions, value), _mm256_mul_pd(drops, _mm256_sub_pd(sums, old))));
+            _mm256_storeu_pd(weighted_sum + i, weighted);
+            _mm256_storeu_pd(sum + i, _mm256_add_pd(sums, _mm256_sub_pd(value, old)));
+            _mm256_storeu_pd(sum_squares + i, _mm256_add_pd(_mm256_loadu_pd(sum_squares + i),
+                    _mm256_sub_pd(_mm256_mul_pd(value, value), _mm256_mul_pd(old, old))));
+            _mm256_storeu_pd(slot + i, value);
+        }
+        scalar_panel_update(n - i, row + i, shift + i, slot + i, sum + i, sum_squares + i, weighted_sum + i,
+                            position, dropping);
+    }
+
+    BT_TARGET_AVX2 void avx2_panel_mean(size_t n, const double* sum, const double* shift, double inverse_count,
+                                        double* out) {
+        const __m256d inverse = _mm256_set1_pd(inverse_count);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(sum + i), inverse),
+                                                    _mm256_loadu_pd(shift + i)));
+        }
+        scalar_panel_mean(n - i, sum + i, shift + i, inverse_count, out + i);
+    }
+
+    BT_TARGET_AVX2 void avx2_panel_variance(size_t n, const double* sum, const double* sum_squares,
+                                            double inverse_count, double* out) {
+        const __m256d inverse = _mm256_set1_pd(inverse_count), zero = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const __m256d mean = _mm256_mul_pd(_mm256_loadu_pd(sum + i), inverse);
+            const __m256d variance = _mm256_sub_pd(_mm256_mul_pd(_mm256_loadu_pd(sum_squares + i), inverse),
+                                                   _mm256_mul_pd(mean, mean));
+            _mm256_storeu_pd(out + i, _mm256_max_pd(variance, zero));
+        }
+        scalar_panel_variance(n - i, sum + i, sum_squares + i, inverse_count, out + i);
+    }
+
+    BT_TARGET_AVX2 void avx2_panel_slope(size_t n, const double* sum, const double* weighted_sum, double mean_position,
+                                         double inverse_spread, double* out) {
+        const __m256d middle = _mm256_set1_pd(mean_position), inverse = _mm256_set1_pd(inverse_spread);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(weighted_sum + i),
+                                                                  _mm256_mul_pd(middle, _mm256_loadu_pd(sum + i))),
+                                                    inverse));
+        }
+        scalar_panel_slope(n - i, sum + i, weighted_sum + i, mean_position, inverse_spread, out + i);
+    }
+
+    BT_TARGET_AVX2 void avx2_panel_intercept(size_t n, const double* sum, const double* weighted_sum,
+                                             const double* shift, double inverse_count, double mean_position,
+                                             double inverse_spread, double* out) {
+        const __m256d middle = _mm256_set1_pd(mean_position), inverse = _mm256_set1_pd(inverse_spread);
+        const __m256d inverse_n = _mm256_set1_pd(inverse_count);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const __m256d sums = _mm256_loadu_pd(sum + i);
+            const __m256d slope = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(weighted_sum + i),
+                                                              _mm256_mul_pd(middle, sums)), inverse);
+            const __m256d mean = _mm256_add_pd(_mm256_mul_pd(sums, inverse_n), _mm256_loadu_pd(shift + i));
+            _mm256_storeu_pd(out + i, _mm256_sub_pd(mean, _mm256_mul_pd(slope, middle)));
+        }
+        scalar_panel_intercept(n - i, sum + i, weighted_sum + i, shift + i, inverse_count, mean_position,
+                               inverse_spread, out + i);
+    }
+
+    BT_TARGET_AVX2 double avx2_sum(const double* in, size_t n) {
+        __m256d lanes = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) { lanes = _mm256_add_pd(lanes, _mm256_loadu_pd(in + i)); }
+        double parts[4];
+        _mm256_storeu_pd(parts, lanes);
+        double total = (parts[0] + parts[1]) + (parts[2] + parts[3]);
+        for (; i < n; ++i) { total += in[i]; }
+        return total;
+    }
+
+    BT_TARGET_AVX2 double avx2_squared_deviations(const double* in, size_t n, double mean) {
+        const __m256d middle = _mm256_set1_pd(mean);
+        __m256d lanes = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const __m256d deviation = _mm256_sub_pd(_mm256_loadu_pd(in + i), middle);
+            lanes = _mm256_add_pd(lanes, _mm256_mul_pd(deviation, deviation));
+        }
+        double parts[4];
+        _mm256_storeu_pd(parts, lanes);
+        double total = (parts[0] + parts[1]) + (parts[2] + parts[3]);
+        for (; i < n; ++i) { total += (in[i] - mean) * (in[i] - mean); }
+        return total;
+    }
+
+    BT_TARGET_AVX2 void avx2_affine(const double* in, double* out, size_t n, double subtract, double multiply) {
+        const __m256d subtracted = _mm256_set1_pd(subtract), multiplied = _mm256_set1_pd(multiply);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(in + i), subtracted), multiplied));
+        }
+        scalar_affine(in + i, out + i, n - i, subtract, multiply);
+    }
+
+    BT_TARGET_AVX2 void avx2_clamp(const double* in, double* out, size_t n, double lower, double upper) {
+        const __m256d lowest = _mm256_set1_pd(lower), highest = _mm256_set1_pd(upper);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(out + i, _mm256_min_pd(_mm256_max_pd(_mm256_loadu_pd(in + i), lowest), highest));
+        }
+        scalar_clamp(in + i, out + i, n - i, lower, upper);
+    }
+
+    BT_TARGET_AVX2 double avx2_dot(const double* a, const double* b, size_t n) {
+        __m256d lanes = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            lanes = _mm256_add_pd(lanes, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        }
+        double parts[4];
+        _mm256_storeu_pd(parts, lanes);
+        double total = (parts[0] + parts[1]) + (parts[2] + parts[3]);
+        for (; i < n; ++i) { total += a[i] * b[i]; }
+        return total;
+    }
+
+    // Clears the sign bits for the absolute values
+    BT_TARGET_AVX2 double avx2_gross(const double* a, const double* b, size_t n) {
+        const __m256d sign = _mm256_set1_pd(-0.0);
+        __m256d lanes = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const __m256d product = _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+            lanes = _mm256_add_pd(lanes, _mm256_andnot_pd(sign, product));
+        }
+        double parts[4];
+        _mm256_storeu_pd(parts, lanes);
+        double total = (parts[0] + parts[1]) + (parts[2] + parts[3]);
+        for (; i < n; ++i) { total += std::abs(a[i] * b[i]); }
+        return total;
+    }
+
+    const Table AVX2_TABLE = {AVX2, avx2_panel_update, avx2_panel_mean, avx2_panel_variance, avx2_panel_slope,
+                              avx2_panel_intercept, avx2_sum, avx2_squared_deviations, avx2_affine, avx2_clamp,
+                              avx2_dot, avx2_gross};
+#endif
+
+    // Whether the processor, and the operating system saving its registers, support AVX2
+    bool has_avx2() {
+#if defined(BT_KERNELS_X86) && defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        const bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        return os_saves_ymm && (info[1] & (1 << 5));
+#elif defined(BT_KERNELS_X86)
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    // The table in use, which starts as the best the processor supports
+    const Table*& active() {
+#ifdef BT_KERNELS_X86
+        static const Table* table = has_avx2() ? &AVX2_TABLE : &SCALAR_TABLE;
+#else
+        static const Table* table = &SCALAR_TABLE;
+#endif
+        return table;
+    }
+}
+
+// Reads the table in use
+Isa isa() { return active()->isa; }
+
+// Falls back to the scalar loops when AVX2 is asked for but missing
+Isa use_isa(Isa requested) {
+#ifdef BT_KERNELS_X86
+    active() = (requested == AVX2 && has_avx2()) ? &AVX2_TABLE : &SCALAR_TABLE;
+#else
+    active() = &SCALAR_TABLE;
+#endif
+    return isa();
+}
+
+// Names as they appear in reports
+const char* isa_name(Isa which) { return which == AVX2 ? "AVX2" : "scalar"; }
+
+// MARK: RollingPanel
+
+// Allocates the whole window up front, zeroed so that rows not yet written drop nothing out of the sums
+RollingPanel::RollingPanel(size_t symbols, size_t p_window) :
+        width(symbols),
+        window(std::max<size_t>(1, p_window)),
+        rows(width * window, 0.0),
+        shift(width, 0.0),
+        sum(width, 0.0),
+        sum_squares(width, 0.0),
+        weighted_sum(width, 0.0) {}
+
+// The first row becomes the shift. Once the window is full, the oldest row is dropped as the new one goes in, which
+// moves every other row one position down.
+void RollingPanel::update(const double* row) {
+    if (count == 0 && next == 0) { std::copy(row, row + width, shift.begin()); }
+    const bool full = ready();
+    const double position = full ? static_cast<double>(window - 1) : static_cast<double>(count);
+    active()->panel_update(width, row, shift.data(), rows.data() + next * width, sum.data(), sum_squares.data(),
+                           weighted_sum.data(), position, full ? 1.0 : 0.0);
+    if (!full) { count++; }
+    next = (next + 1) % window;
+    if (next == 0) { refresh(); }
+}
+
+// The window is full and its oldest row is at the start whenever this is called
+void RollingPanel::refresh() {
+    std::fill(sum.begin(), sum.end(), 0.0);
+    std::fill(sum_squares.begin(), sum_squares.end(), 0.0);
+    std::fill(weighted_sum.begin(), weighted_sum.end(), 0.0);
+    for (size_t row = 0; row < window; ++row) {
+        const double* values = rows.data() + row * width;
+        for (size_t i = 0; i < width; ++i) {
+            sum[i] += values[i];
+            sum_squares[i] += values[i] * values[i];
+            weighted_sum[i] += values[i] * static_cast<double>(row);
+        }
+    }
+}
+
+// Mean of the shifted values plus the shift
+void RollingPanel::mean(double* out) const {
+    if (count == 0) { std::fill(out, out + width, 0.0); return; }
+    active()->panel_mean(width, sum.data(), shift.data(), 1.0 / count, out);
+}
+
+// The shift does not change the variance
+void RollingPanel::variance(double* out) const {
+    if (count == 0) { std::fill(out, out + width, 0.0); return; }
+    active()->panel_variance(width, sum.data(), sum_squares.data(), 1.0 / count, out);
+}
+
+// The positions 0..n-1 have mean (n-1)/2 and sum of squared deviations n(n^2-1)/12
+void RollingPanel::slope(double* out) const {
+    if (count < 2) { std::fill(out, out + width, 0.0); return; }
+    const auto n = static_cast<double>(count);
+    active()->panel_slope(width, sum.data(), weighted_sum.data(), (n - 1) / 2, 12 / (n * (n * n - 1)), out);
+}
+
+// The line passes through the mean of the positions and the mean of the values
+void RollingPanel::intercept(double* out) const {
+    if (count < 2) { mean(out); return; }
+    const auto n = static_cast<double>(count);
+    active()->panel_intercept(width, sum.data(), weighted_sum.data(), shift.data(), 1 / n, (n - 1) / 2,
+                              12 / (n * (n * n - 1)), out);
+}
+
+// MARK: Cross-sectional transforms
+
+// Sorts the indices by value, then gives each run of equal values the mean of the ranks it spans
+void rank(const double* in, double* out, size_t n) {
+    if (n == 0) { return; }
+    if (n == 1) { out[0] = 0.5; return; }
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [in](size_t a, size_t b) { return in[a] < in[b]; });
+    std::vector<double> ranks(n);
+    for (size_t start = 0; start < n;) {
+        size_t end = start + 1;
+        while (end < n && in[order[end]] == in[order[start]]) { end++; }
+        const double shared = (static_cast<double>(start + end - 1) / 2) / static_cast<double>(n - 1);
+        for (size_t i = start; i < end; ++i) { ranks[order[i]] = shared; }
+        start = end;
+    }
+    std::copy(ranks.begin(), ranks.end(), out);
+}
+
+// Two passes, the mean and then the squared deviations from it
+void moments(const double* in, size_t n, double& mean, double& variance) {
+    if (n == 0) { mean = variance = 0; return; }
+    mean = active()->sum(in, n) / static_cast<double>(n);
+    variance = active()->squared_deviations(in, n, mean) / static_cast<double>(n);
+}
+
+// Subtracts the mean and divides by the deviation in one pass
+void zscore(const double* in, double* out, size_t n) {
+    double mean, variance;
+    moments(in, n, mean, variance);
+    const double deviation = std::sqrt(variance);
+    if (deviation > 0) { active()->affine(in, out, n, mean, 1 / deviation); }
+    else { std::fill(out, out + n, 0.0); }
+}
+
+// Selects the two quantiles from a copy, then clamps
+void winsorize(const double* in, double* out, size_t n, double lower_quantile, double upper_quantile) {
+    if (n == 0) { return; }
+    std::vector<double> sorted(in, in + n);
+    auto at = [&sorted, n](double quantile) {
+        const auto index = static_cast<size_t>(std::lround(std::min(std::max(quantile, 0.0), 1.0) * (n - 1)));
+        std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+        return sorted[index];
+    };
+    const double lower = at(lower_quantile);
+    const double upper = at(upper_quantile);
+    active()->clamp(in, out, n, lower, upper);
+}
+
+// Hands the arrays to the table in use
+double dot(const double* a, const double* b, size_t n) { return active()->dot(a, b, n); }
+double gross(const double* a, const double* b, size_t n) { return active()->gross(a, b, n); }
+
+}
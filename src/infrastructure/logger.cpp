@@ -0,0 +1,185 @@
+// Include corresponding header
+#include "logger.hpp"
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace logging {
+
+std::atomic<int> runtime_level(LEVEL_INFO);
+
+namespace {
+    // A pre-formatted record on the ring, one cache line multiple so neighbouring writers do not share lines. The
+    // sequence number tells writers and the reader whose turn it is to use the slot.
+    struct alignas(64) Record {
+        std::atomic<size_t> sequence;
+        BloombergLP::blpapi::Datetime time;
+        Level level;
+        uint32_t length;
+        char text[200];
+    };
+
+    // Names of the levels as printed
+    const char* LEVEL_NAMES[] = {"TRACE", "DEBUG", "INFO ", "WARN ", "ERROR"};
+    // Ends a message which was too long for its record
+    const char TRUNCATED[] = "[...]";
+
+    // Bounded multiple-producer single-consumer ring. Writers claim a slot by advancing the write position with a
+    // compare and swap, fill it, then publish it by bumping its sequence; the background thread reads slots in order
+    // as they are published. Once the ring is empty the background thread sleeps on a condition variable, and only a
+    // writer which sees it asleep takes the mutex to wake it, so writing stays lock-free while it is busy.
+    class Logger {
+    public:
+        Logger() : records(CAPACITY) {
+            for (size_t i = 0; i < CAPACITY; ++i) { records[i].sequence.store(i, std::memory_order_relaxed); }
+            reader = std::thread(&Logger::drain, this);
+        }
+        // Outputs whatever is left on the ring before the program exits
+        ~Logger() {
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex);
+                stopping.store(true, std::memory_order_release);
+            }
+            wake.notify_one();
+            reader.join();
+        }
+
+        void push(Level level, const BloombergLP::blpapi::Datetime& time, const std::string& message) {
+            size_t position = write_position.load(std::memory_order_relaxed);
+            Record* record;
+            while (true) {
+                record = &records[position & (CAPACITY - 1)];
+                size_t sequence = record->sequence.load(std::memory_order_acquire);
+                auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (difference == 0) {
+                    // The slot is free, so try to claim it
+                    if (write_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) { break; }
+                } else if (difference < 0) {
+                    // The ring is full, so give the reader time to catch up
+                    std::this_thread::yield();
+                    position = write_position.load(std::memory_order_relaxed);
+                } else {
+                    // Another writer claimed the slot first
+                    position = write_position.load(std::memory_order_relaxed);
+                }
+            }
+            record->time = time;
+            record->level = level;
+            if (message.size() <= sizeof(record->text)) {
+                record->length = static_cast<uint32_t>(message.size());
+                std::memcpy(record->text, message.data(), record->length);
+            } else {
+                record->length = sizeof(record->text);
+                const size_t kept = sizeof(record->text) - (sizeof(TRUNCATED) - 1);
+                std::memcpy(record->text, message.data(), kept);
+                std::memcpy(record->text + kept, TRUNCATED, sizeof(TRUNCATED) - 1);
+            }
+            record->sequence.store(position + 1, std::memory_order_release);
+
+            // Pairs with the fence in drain, so either this sees the reader asleep or the reader sees the record
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> lock(wake_mutex);
+                wake.notify_one();
+            }
+        }
+
+        // Waits for the reader to have output everything claimed up to now
+        void flush() {
+            const size_t target = write_position.load(std::memory_order_acquire);
+            while (written_position.load(std::memory_order_acquire) < target) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+
+        void set_output(std::ostream* p_output) {
+            flush();
+            output.store(p_output, std::memory_order_release);
+        }
+
+    private:
+        // Formats published records into one buffer and writes it out whenever the ring runs dry, then sleeps until a
+        // writer publishes another
+        void drain() {
+            std::ostringstream batch;
+            while (true) {
+                Record& record = records[read_position & (CAPACITY - 1)];
+                if (record.sequence.load(std::memory_order_acquire) == read_position + 1) {
+                    batch << "[" << record.time << "] " << LEVEL_NAMES[record.level] << " ";
+                    batch.write(record.text, record.length);
+                    batch << "\n";
+                    record.sequence.store(read_position + CAPACITY, std::memory_order_release);
+                    read_position++;
+                    continue;
+                }
+                // Nothing left to read, so write the batch out
+                if (batch.tellp() > 0) {
+                    std::ostream* out = output.load(std::memory_order_acquire);
+                    const std::string text = batch.str();
+                    out->write(text.data(), text.size());
+                    out->flush();
+                    batch.str("");
+                    batch.clear();
+                }
+                written_position.store(read_position, std::memory_order_release);
+                if (stopping.load(std::memory_order_acquire) &&
+                    write_position.load(std::memory_order_acquire) == read_position) { return; }
+
+                // Say so before looking at the ring a last time. The mutex is held from that look until the wait
+                // releases it, so a writer which publishes in between cannot notify before the wait begins.
+                std::unique_lock<std::mutex> lock(wake_mutex);
+                sleeping.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                wake.wait(lock, [this, &record]() {
+                    return record.sequence.load(std::memory_order_acquire) == read_position + 1 ||
+                           stopping.load(std::memory_order_acquire);
+                });
+                sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        // Must be a power of two
+        static const size_t CAPACITY = 4096;
+        std::vector<Record> records;
+        alignas(64) std::atomic<size_t> write_position{0};
+        alignas(64) std::atomic<size_t> written_position{0};
+        size_t read_position = 0;
+        std::atomic<std::ostream*> output{&std::cout};
+        std::atomic<bool> stopping{false};
+        // Whether the background thread is asleep, and what wakes it
+        std::atomic<bool> sleeping{false};
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        std::thread reader;
+    };
+
+    // Started the first time anything is logged
+    Logger& logger() {
+        static Logger instance;
+        return instance;
+    }
+}
+
+// Changes the run-time level for every thread
+void set_level(Level level) { runtime_level.store(level, std::memory_order_relaxed); }
+
+// Switches the output once everything already logged has gone to the old one
+void set_output(std::ostream* output) { logger().set_output(output); }
+
+// Hands the record to the ring
+void write(Level level, const BloombergLP::blpapi::Datetime& time, const std::string& message) {
+    if (level < LEVEL_TRACE || level >= LEVEL_OFF) { return; }
+    logger().push(level, time, message);
+}
+
+// Waits for the background thread
+void flush() { logger().flush(); }
+
+}
@@ -0,0 +1,133 @@
+// Include corresponding header
+#include "notifier.hpp"
+// STL includes
+#include <cstdio>
+#include <iostream>
+#include <unordered_map>
+// Pipes to child processes
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+// Keeps the paths of the interpreter and the script
+SlackSink::SlackSink(const std::string &p_python, const std::string &p_script) :
+        python(p_python),
+        script(p_script) {}
+
+// Runs the script once for the whole batch, writing the messages to its standard input. None of their text is
+// ever put on a command line, so no character in a message is seen by the shell.
+void SlackSink::send(const std::vector<std::string> &messages) {
+    FILE* pipe = popen((python + " " + script).c_str(), "w");
+    if (!pipe) {
+        std::cerr << "Could not start " << script << "!" << std::endl;
+        return;
+    }
+    for (size_t i = 0; i < messages.size(); ++i) {
+        if (i > 0) { fputc('\n', pipe); }
+        fwrite(messages[i].data(), 1, messages[i].size(), pipe);
+    }
+    pclose(pipe);
+}
+
+// Opens the file for appending
+FileSink::FileSink(const std::string &filepath) : file(filepath, std::ios_base::out | std::ios_base::app) {
+    if (!file.is_open()) { throw std::runtime_error("Could not open notification file " + filepath + "!"); }
+}
+
+// Writes the batch and flushes it so a reader on the other end sees it straight away
+void FileSink::send(const std::vector<std::string> &messages) {
+    for (const std::string& message : messages) { file << message << "\n"; }
+    file.flush();
+}
+
+// Starts the dispatcher, which sleeps until there is something to send
+Notifier::Notifier(std::unique_ptr<NotificationSink> p_sink, size_t p_capacity, std::chrono::milliseconds p_window) :
+        sink(std::move(p_sink)),
+        capacity(p_capacity),
+        window(p_window) {
+    dispatcher = std::thread(&Notifier::dispatch_loop, this);
+}
+
+// Lets the dispatcher deliver what is left without waiting out the window
+Notifier::~Notifier() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_one();
+    dispatcher.join();
+}
+
+// Adds the message to the queue, making room by dropping the oldest one if the queue is full
+void Notifier::notify(const std::string &message) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (queue.size() >= capacity) {
+            queue.pop_front();
+            dropped++;
+            sent++;
+        }
+        queue.push_back(message);
+        queued++;
+    }
+    wake.notify_one();
+}
+
+// Asks the dispatcher to send now and waits for it to catch up
+void Notifier::flush() {
+    std::unique_lock<std::mutex> lock(mtx);
+    flush_requested = true;
+    wake.notify_one();
+    const unsigned long long target = queued;
+    delivered.wait(lock, [this, target] { return sent >= target; });
+}
+
+// Waits for a first message, then gives the rest of its burst the window to arrive before sending them all at once
+void Notifier::dispatch_loop() {
+    std::vector<std::string> batch;
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (!stopping && !flush_requested) {
+            wake.wait_for(lock, window, [this] { return stopping || flush_requested; });
+        }
+        bool finished = stopping;
+        flush_requested = false;
+        batch.assign(std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.end()));
+        queue.clear();
+        if (dropped > 0) {
+            batch.push_back("(" + std::to_string(dropped) + " notifications dropped)");
+            dropped = 0;
+        }
+        const unsigned long long batch_end = queued;
+
+        lock.unlock();
+        // A failing sink loses the batch but must not take the strategy down with it
+        try {
+            if (!batch.empty()) { sink->send(coalesce(batch)); }
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to send notifications: " << e.what() << std::endl;
+        }
+        batch.clear();
+        lock.lock();
+
+        sent = batch_end;
+        delivered.notify_all();
+        if (finished && queue.empty()) { return; }
+    }
+}
+
+// Counts each distinct message and suffixes the repeated ones with their count
+std::vector<std::string> Notifier::coalesce(const std::vector<std::string> &messages) {
+    std::vector<std::string> order;
+    std::unordered_map<std::string, unsigned int> counts;
+    for (const std::string& message : messages) {
+        if (counts[message]++ == 0) { order.push_back(message); }
+    }
+    for (std::string& message : order) {
+        const unsigned int count = counts[message];
+        if (count > 1) { message += " (x" + std::to_string(count) + ")"; }
+    }
+    return order;
+}
@@ -0,0 +1,292 @@
+// Include corresponding header
+#include "pipeline.hpp"
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+// Custom class includes
+#include "kernels.hpp"
+
+namespace {
+    const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    // Positions of the values which are numbers, which are all the cross-sectional kernels can take
+    std::vector<size_t> finite(const std::vector<double>& values) {
+        std::vector<size_t> positions;
+        positions.reserve(values.size());
+        for (size_t i = 0; i < values.size(); ++i) { if (std::isfinite(values[i])) { positions.push_back(i); } }
+        return positions;
+    }
+
+    // Runs a cross-sectional kernel over the values which are numbers only, leaving the rest NaN
+    template <class Kernel>
+    void cross_section(const std::vector<double>& in, std::vector<double>& out, Kernel kernel) {
+        const std::vector<size_t> positions = finite(in);
+        std::vector<double> compact(positions.size());
+        for (size_t i = 0; i < positions.size(); ++i) { compact[i] = in[positions[i]]; }
+        kernel(compact.data(), compact.data(), compact.size());
+        std::fill(out.begin(), out.end(), NaN);
+        for (size_t i = 0; i < positions.size(); ++i) { out[positions[i]] = compact[i]; }
+    }
+
+    // Feeds the rolling kernels one row of a series at a time, with the NaNs made 0 so the kernels can take them.
+    // Symbols which had a NaN anywhere in the window are marked so their statistics can be thrown away after.
+    class MaskedWindow {
+    public:
+        MaskedWindow(size_t width, size_t window) : rolling(width, window), clean(width), valid(width, true) {}
+
+        void update(const double* row) {
+            for (size_t i = 0; i < clean.size(); ++i) {
+                if (std::isfinite(row[i])) { clean[i] = row[i]; } else { clean[i] = 0; valid[i] = false; }
+            }
+            rolling.update(clean.data());
+        }
+        // Makes the statistics of the symbols marked NaN
+        void mask(std::vector<double>& out) const {
+            for (size_t i = 0; i < valid.size(); ++i) { if (!valid[i]) { out[i] = NaN; } }
+        }
+
+        kernels::RollingPanel rolling;
+    private:
+        std::vector<double> clean;
+        std::vector<bool> valid;
+    };
+}
+
+// The symbol is found by a linear search, as the table is read a few values at a time
+double PipelineOutput::get(const std::string &symbol, const std::string &column) const {
+    auto found = std::find(symbols.begin(), symbols.end(), symbol);
+    if (found == symbols.end()) { throw std::runtime_error("Symbol " + symbol + " is not in the pipeline output!"); }
+    auto name = std::find(columns.begin(), columns.end(), column);
+    if (name == columns.end()) { throw std::runtime_error("Column " + column + " is not in the pipeline output!"); }
+    return row(static_cast<size_t>(found - symbols.begin()))[name - columns.begin()];
+}
+
+// The key spells out everything which makes a term what it is, with the parameter at full precision so that
+// nearby values are not taken for the same term
+Term Pipeline::declare(const Node &node) {
+    std::ostringstream key;
+    key << std::setprecision(17) << node.op << '|' << node.field << '|' << node.window << '|' << node.parameter;
+    for (size_t input : node.inputs) { key << '|' << input; }
+    auto found = keys.find(key.str());
+    if (found != keys.end()) { return Term{found->second}; }
+    keys.emplace(key.str(), nodes.size());
+    nodes.push_back(node);
+    return Term{nodes.size() - 1};
+}
+
+// Fields are numbered in the order the pipeline first reads them
+Term Pipeline::on_field(Op op, const std::string &field, unsigned int window) {
+    if (op != LATEST && window == 0) { throw std::runtime_error("Pipeline windows must be at least one bar!"); }
+    auto found = std::find(panel_fields.begin(), panel_fields.end(), field);
+    if (found == panel_fields.end()) { found = panel_fields.insert(panel_fields.end(), field); }
+    Node node{op, {}};
+    node.field = static_cast<size_t>(found - panel_fields.begin());
+    node.window = window;
+    return declare(node);
+}
+
+// Handles from another pipeline would point at the wrong terms, or past the end
+size_t Pipeline::check(Term term) const {
+    if (term.id >= nodes.size()) { throw std::runtime_error("Term was not declared by this pipeline!"); }
+    return term.id;
+}
+
+// Factors on the panel's fields
+Term Pipeline::latest(const std::string &field) { return on_field(LATEST, field, 0); }
+Term Pipeline::returns(unsigned int window, const std::string &field) { return on_field(RETURNS, field, window); }
+Term Pipeline::moving_average(unsigned int window, const std::string &field) {
+    return on_field(MOVING_AVERAGE, field, window);
+}
+Term Pipeline::volatility(unsigned int window, const std::string &field) {
+    return on_field(VOLATILITY, field, window);
+}
+
+// Sums and the combinations of filters do not depend on the order of their inputs, so the inputs are sorted to
+// make a + b the same term as b + a
+Term Pipeline::add(Term first, Term second) {
+    return declare({ADD, {std::min(check(first), check(second)), std::max(first.id, second.id)}});
+}
+Term Pipeline::subtract(Term first, Term second) { return declare({SUBTRACT, {check(first), check(second)}}); }
+Term Pipeline::divide(Term numerator, Term denominator) {
+    return declare({DIVIDE, {check(numerator), check(denominator)}});
+}
+Term Pipeline::rank(Term factor) { return declare({RANK, {check(factor)}}); }
+Term Pipeline::zscore(Term factor) { return declare({ZSCORE, {check(factor)}}); }
+
+// Filters
+Term Pipeline::top(Term factor, unsigned int n) {
+    Node node{TOP, {check(factor)}};
+    node.window = n;
+    return declare(node);
+}
+Term Pipeline::bottom(Term factor, unsigned int n) {
+    Node node{BOTTOM, {check(factor)}};
+    node.window = n;
+    return declare(node);
+}
+Term Pipeline::greater_than(Term factor, double value) {
+    Node node{GREATER_THAN, {check(factor)}};
+    node.parameter = value;
+    return declare(node);
+}
+Term Pipeline::less_than(Term factor, double value) {
+    Node node{LESS_THAN, {check(factor)}};
+    node.parameter = value;
+    return declare(node);
+}
+Term Pipeline::all_of(Term first, Term second) {
+    return declare({ALL_OF, {std::min(check(first), check(second)), std::max(first.id, second.id)}});
+}
+Term Pipeline::any_of(Term first, Term second) {
+    return declare({ANY_OF, {std::min(check(first), check(second)), std::max(first.id, second.id)}});
+}
+
+// Classifiers
+Term Pipeline::quantiles(Term factor, unsigned int bins) {
+    if (bins == 0) { throw std::runtime_error("Quantiles need at least one bin!"); }
+    Node node{QUANTILES, {check(factor)}};
+    node.window = bins;
+    return declare(node);
+}
+
+// Adds the column
+void Pipeline::column(const std::string &name, Term term) { columns.emplace_back(name, check(term)); }
+// Sets the screen
+void Pipeline::screen(Term filter) {
+    screen_term = check(filter);
+    screened = true;
+}
+
+// Returns read one bar further back than their window, as do the one bar returns volatility is taken over
+unsigned int Pipeline::lookback() const {
+    unsigned int bars = 0;
+    for (const Node& node : nodes) {
+        if (node.op == RETURNS || node.op == VOLATILITY) { bars = std::max(bars, node.window); }
+        else if (node.op == MOVING_AVERAGE) { bars = std::max(bars, node.window - 1); }
+    }
+    return bars;
+}
+
+// Each kind of term, over every symbol at once
+void Pipeline::compute(const Node &node, const Panel &panel, const std::vector<size_t> &field_indices,
+                       const std::vector<std::vector<double>> &computed, std::vector<double> &out) const {
+    const size_t width = panel.symbols.size();
+    const size_t rows = panel.times.size();
+    const size_t last = rows - 1;
+    const std::vector<double>& first = node.inputs.empty() ? out : computed[node.inputs[0]];
+    const std::vector<double>& second = node.inputs.size() < 2 ? out : computed[node.inputs[1]];
+    const size_t field = node.inputs.empty() ? field_indices[node.field] : 0;
+
+    switch (node.op) {
+        case LATEST:
+            if (rows == 0) { std::fill(out.begin(), out.end(), NaN); break; }
+            std::copy(panel.row(field, last), panel.row(field, last) + width, out.begin());
+            break;
+        case RETURNS: {
+            if (rows <= node.window) { std::fill(out.begin(), out.end(), NaN); break; }
+            const double* now = panel.row(field, last);
+            const double* then = panel.row(field, last - node.window);
+            for (size_t i = 0; i < width; ++i) { out[i] = now[i] / then[i] - 1; }
+            break;
+        }
+        case MOVING_AVERAGE: {
+            if (rows < node.window) { std::fill(out.begin(), out.end(), NaN); break; }
+            MaskedWindow window(width, node.window);
+            for (size_t time = rows - node.window; time < rows; ++time) { window.update(panel.row(field, time)); }
+            window.rolling.mean(out.data());
+            window.mask(out);
+            break;
+        }
+        case VOLATILITY: {
+            if (rows <= node.window) { std::fill(out.begin(), out.end(), NaN); break; }
+            MaskedWindow window(width, node.window);
+            std::vector<double> returns(width);
+            for (size_t time = rows - node.window; time < rows; ++time) {
+                const double* now = panel.row(field, time);
+                const double* then = panel.row(field, time - 1);
+                for (size_t i = 0; i < width; ++i) { returns[i] = now[i] / then[i] - 1; }
+                window.update(returns.data());
+            }
+            window.rolling.variance(out.data());
+            for (double& value : out) { value = std::sqrt(value); }
+            window.mask(out);
+            break;
+        }
+        case ADD: for (size_t i = 0; i < width; ++i) { out[i] = first[i] + second[i]; } break;
+        case SUBTRACT: for (size_t i = 0; i < width; ++i) { out[i] = first[i] - second[i]; } break;
+        case DIVIDE: for (size_t i = 0; i < width; ++i) { out[i] = first[i] / second[i]; } break;
+        case RANK: cross_section(first, out, kernels::rank); break;
+        case ZSCORE: cross_section(first, out, kernels::zscore); break;
+        case TOP:
+        case BOTTOM: {
+            // Only the first n of the order are needed, so the order is only partly sorted
+            std::vector<size_t> order = finite(first);
+            const size_t n = std::min<size_t>(node.window, order.size());
+            const bool highest = node.op == TOP;
+            std::partial_sort(order.begin(), order.begin() + n, order.end(), [&](size_t a, size_t b) {
+                if (first[a] != first[b]) { return highest ? first[a] > first[b] : first[a] < first[b]; }
+                return a < b;
+            });
+            std::fill(out.begin(), out.end(), 0.0);
+            for (size_t i = 0; i < n; ++i) { out[order[i]] = 1; }
+            break;
+        }
+        // Comparisons with NaN are false, so symbols without values fail the filters
+        case GREATER_THAN: for (size_t i = 0; i < width; ++i) { out[i] = first[i] > node.parameter; } break;
+        case LESS_THAN: for (size_t i = 0; i < width; ++i) { out[i] = first[i] < node.parameter; } break;
+        case ALL_OF: for (size_t i = 0; i < width; ++i) { out[i] = first[i] == 1 && second[i] == 1; } break;
+        case ANY_OF: for (size_t i = 0; i < width; ++i) { out[i] = first[i] == 1 || second[i] == 1; } break;
+        case QUANTILES: {
+            cross_section(first, out, kernels::rank);
+            const double bins = node.window;
+            for (double& value : out) {
+                if (!std::isnan(value)) { value = std::min(bins - 1, std::floor(value * bins)); }
+            }
+            break;
+        }
+    }
+    // Dividing by 0 or by a missing price gives infinities, which are no more use than NaN
+    for (double& value : out) { if (!std::isfinite(value)) { value = NaN; } }
+}
+
+// Only the terms some column or the screen depends on are computed. As every term's inputs were declared before
+// it, one pass back through the terms finds them and one pass forward computes them.
+PipelineOutput Pipeline::run(const Panel &panel) const {
+    if (columns.empty()) { throw std::runtime_error("Pipeline has no columns to output!"); }
+    std::vector<size_t> field_indices;
+    for (const std::string& field : panel_fields) { field_indices.push_back(panel.field_index(field)); }
+
+    std::vector<bool> needed(nodes.size(), false);
+    for (const auto& column : columns) { needed[column.second] = true; }
+    if (screened) { needed[screen_term] = true; }
+    for (size_t id = nodes.size(); id-- > 0;) {
+        if (needed[id]) { for (size_t input : nodes[id].inputs) { needed[input] = true; } }
+    }
+    std::vector<std::vector<double>> computed(nodes.size());
+    for (size_t id = 0; id < nodes.size(); ++id) {
+        if (!needed[id]) { continue; }
+        computed[id].resize(panel.symbols.size());
+        compute(nodes[id], panel, field_indices, computed, computed[id]);
+    }
+
+    PipelineOutput output;
+    if (!panel.times.empty()) { output.datetime = panel.times.back(); }
+    for (const auto& column : columns) { output.columns.push_back(column.first); }
+    for (size_t i = 0; i < panel.symbols.size(); ++i) {
+        if (screened && computed[screen_term][i] != 1) { continue; }
+        output.symbols.push_back(panel.symbols[i]);
+        for (const auto& column : columns) { output.values.push_back(computed[column.second][i]); }
+    }
+    return output;
+}
+
+// Asks for calendar days rather than bars, so weekends and holidays are covered the same way the momentum strategy
+// covers them when seeding its indicators. Gaps are left NaN rather than filled forward, so a symbol missing bars in a
+// window (e.g. once it has delisted) is NaN in the terms over it instead of looking flat.
+PipelineOutput Pipeline::run(DataManager &data, const std::vector<std::string> &symbols) const {
+    const auto days = static_cast<unsigned int>(std::ceil((lookback() + 1) * 1.6)) + 5;
+    return run(data.history_panel(symbols, panel_fields, days, "DAILY", Panel::LEAVE_NAN));
+}
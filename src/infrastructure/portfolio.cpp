@@ -50,9 +50,12 @@ void Portfolio::reset_portfolio(unsigned int p_initial_capital, const BloombergL
 // Interprets the data from a market event and updates the holdings to reflect the latest price change.
 void Portfolio::update_market(const events::MarketEvent &event) {
 
-    // Get the data from the market event and update the current holdings
+    // Get the data from the market event and update the current holdings. Events shared between strategies carry
+    // symbols other portfolios trade, which have no holdings here and are skipped.
     for (const auto& symbol : event.symbols) {
-        current_holdings[symbol] = current_positions[symbol] * event.data.at(symbol);
+        auto holding = current_holdings.find(symbol);
+        if (holding == current_holdings.end()) { continue; }
+        holding->second = current_positions[symbol] * event.data.at(symbol);
     }
 
     // Update returns and total holdings
@@ -87,17 +90,50 @@ void Portfolio::calculate_returns() {
 // change in the filled stock.
 void Portfolio::update_fill(const events::FillEvent &event) {
 
-    // Update the positions first
-    current_positions[event.symbol] += event.quantity;
+    // Update the positions and holdings with the fill information
+    apply_fill(event);
 
-    // Update the holdings with calculated fill information
-    current_holdings[event.symbol] += event.cost;
-    current_holdings[portfolio_fields::COMMISSION] += event.commission;
-    current_holdings[portfolio_fields::SLIPPAGE] += event.slippage;
-    current_holdings[portfolio_fields::HELD_CASH] -= event.cost + event.commission + event.slippage;
+    // Calculate returns stream
+    calculate_returns();
+    // Now push all this data into the historical map
+    push_holdings_and_positions(event.datetime);
+}
+
+// Interprets every fill of a rebalance, so the total holdings and the historical maps are only updated once
+void Portfolio::update_fills(const events::FillsEvent &event) {
+    for (const events::FillEvent& fill : event.fills) { apply_fill(fill); }
 
     // Calculate returns stream
     calculate_returns();
     // Now push all this data into the historical map
     push_holdings_and_positions(event.datetime);
-}
\ No newline at end of file
+}
+
+// Updates the positions first, then the holdings with calculated fill information
+void Portfolio::apply_fill(const events::FillEvent &event) {
+    current_positions[event.symbol] += event.quantity;
+    current_holdings[event.symbol] += event.cost;
+    current_holdings[portfolio_fields::COMMISSION] += event.commission;
+    current_holdings[portfolio_fields::SLIPPAGE] += event.slippage;
+    current_holdings[portfolio_fields::HELD_CASH] -= event.cost + event.commission + event.slippage;
+}
+
+// The initial capital and start date are written with the maps so returns are calculated from the same base
+void Portfolio::write_checkpoint(checkpoint::Writer &writer) const {
+    writer.put(initial_capital);
+    writer.put(start_date);
+    writer.put(current_positions);
+    writer.put(current_holdings);
+    writer.put(all_positions);
+    writer.put(all_holdings);
+}
+
+// Replaces the whole portfolio with the checkpointed one
+void Portfolio::read_checkpoint(checkpoint::Reader &reader) {
+    initial_capital = reader.get<unsigned int>();
+    start_date = reader.get_datetime();
+    current_positions = reader.get_map<int>();
+    current_holdings = reader.get_map<double>();
+    all_positions = reader.get_history<int>();
+    all_holdings = reader.get_history<double>();
+}
@@ -0,0 +1,189 @@
+// Include corresponding header
+#include "resultsink.hpp"
+// STL includes
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+// Custom class includes
+#include "daterules.hpp"
+
+// Starts the writer thread, which sleeps until there are rows to write
+ResultSink::ResultSink(const std::string &p_directory, unsigned int p_formats, bool p_append, size_t p_flush_rows) :
+        directory(p_directory),
+        formats(p_formats),
+        append(p_append),
+        flush_rows(p_flush_rows) {
+    pending_rows.reserve(flush_rows);
+    writer = std::thread(&ResultSink::write_loop, this);
+}
+
+// Lets the writer thread drain the buffer one last time before joining it
+ResultSink::~ResultSink() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+}
+
+// Streams are added before running, while the writer thread has nothing to look at
+void ResultSink::add_stream(const std::string &name, const std::vector<std::string> &columns, bool labelled) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (stream_indices.count(name)) { throw std::runtime_error("Result stream " + name + " already exists!"); }
+    stream_indices[name] = streams.size();
+    auto stream = std::make_unique<Stream>();
+    stream->name = name;
+    stream->columns = columns;
+    stream->labelled = labelled;
+    streams.push_back(std::move(stream));
+}
+
+// Looks the stream up by name
+bool ResultSink::has_stream(const std::string &name) const { return stream_indices.count(name) > 0; }
+
+// Copies the row into the buffer and only wakes the writer once a batch has built up
+void ResultSink::push(const std::string &stream, const BloombergLP::blpapi::Datetime &time,
+                      std::initializer_list<double> values, const std::string &label) {
+    auto found = stream_indices.find(stream);
+    if (found == stream_indices.end()) { throw std::runtime_error("No result stream named " + stream + "!"); }
+    if (values.size() != streams[found->second]->columns.size()) {
+        throw std::runtime_error("Wrong number of values for result stream " + stream + "!");
+    }
+
+    bool batch_ready;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending_rows.push_back(Row{found->second, time, label, pending_values.size()});
+        pending_values.insert(pending_values.end(), values.begin(), values.end());
+        pushed++;
+        batch_ready = pending_rows.size() >= flush_rows;
+    }
+    if (batch_ready) { wake.notify_one(); }
+}
+
+// Asks the writer to write everything now and waits for it to catch up
+void ResultSink::flush() {
+    std::unique_lock<std::mutex> lock(mtx);
+    flush_requested = true;
+    wake.notify_one();
+    const unsigned long long target = pushed;
+    written.wait(lock, [this, target] { return flushed >= target; });
+}
+
+// Waits for a full batch, a flush, shutdown, or a second to pass, then swaps the buffers out and writes them
+// without holding the lock
+void ResultSink::write_loop() {
+    std::vector<Row> rows;
+    std::vector<double> values;
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        wake.wait_for(lock, std::chrono::seconds(1), [this] {
+            return stopping || flush_requested || pending_rows.size() >= flush_rows; });
+        bool finished = stopping;
+        flush_requested = false;
+        rows.swap(pending_rows);
+        values.swap(pending_values);
+        const unsigned long long batch_end = pushed;
+
+        lock.unlock();
+        // A failed write loses the batch but must not take the simulation down with it
+        try {
+            if (!rows.empty()) { write_rows(rows, values); }
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to write results: " << e.what() << std::endl;
+        }
+        rows.clear();
+        values.clear();
+        lock.lock();
+
+        flushed = batch_end;
+        written.notify_all();
+        if (finished && pending_rows.empty()) { return; }
+    }
+}
+
+// Builds every stream's output for the batch in memory first so each file gets one write
+void ResultSink::write_rows(const std::vector<Row> &rows, const std::vector<double> &values) {
+    std::vector<std::string> csv_out(streams.size()), binary_out(streams.size());
+    char number[32];
+    for (const Row& row : rows) {
+        const Stream& stream = *streams[row.stream];
+        const size_t num_columns = stream.columns.size();
+        if (formats & CSV) {
+            std::string& out = csv_out[row.stream];
+            snprintf(number, sizeof(number), "%04u-%02u-%02u %02u:%02u:%02u", row.time.year(), row.time.month(),
+                     row.time.day(), row.time.hours(), row.time.minutes(), row.time.seconds());
+            out += number;
+            if (stream.labelled) { out += ','; out += row.label; }
+            for (size_t i = 0; i < num_columns; ++i) {
+                snprintf(number, sizeof(number), ",%.10g", values[row.offset + i]);
+                out += number;
+            }
+            out += '\n';
+        }
+        if (formats & BINARY) {
+            std::string& out = binary_out[row.stream];
+            timespec time = date_funcs::to_timespec(row.time);
+            int64_t millis = static_cast<int64_t>(time.tv_sec) * 1000 + time.tv_nsec / 1000000;
+            auto label_length = static_cast<uint32_t>(row.label.size());
+            out.append(reinterpret_cast<const char*>(&millis), sizeof(millis));
+            out.append(reinterpret_cast<const char*>(&label_length), sizeof(label_length));
+            out.append(row.label);
+            out.append(reinterpret_cast<const char*>(&values[row.offset]), num_columns * sizeof(double));
+        }
+    }
+
+    // One write per file, then flush so the rows are on disk if the process dies
+    for (size_t i = 0; i < streams.size(); ++i) {
+        if (csv_out[i].empty() && binary_out[i].empty()) { continue; }
+        Stream& stream = *streams[i];
+        open_files(stream);
+        if (!csv_out[i].empty()) { stream.csv.write(csv_out[i].data(), csv_out[i].size()); stream.csv.flush(); }
+        if (!binary_out[i].empty()) {
+            stream.binary.write(binary_out[i].data(), binary_out[i].size());
+            stream.binary.flush();
+        }
+    }
+}
+
+// Headers are only written when a file is started, not when appending onto one which already has rows
+void ResultSink::open_files(Stream &stream) {
+    const std::ios_base::openmode mode = std::ios_base::out | (append ? std::ios_base::app : std::ios_base::trunc);
+    auto is_new = [this](const std::string& path) {
+        if (!append) { return true; }
+        std::ifstream existing(path, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+        return !existing.is_open() || existing.tellg() <= 0;
+    };
+    if ((formats & CSV) && !stream.csv.is_open()) {
+        const std::string path = directory + "/" + stream.name + ".csv";
+        const bool fresh = is_new(path);
+        stream.csv.open(path, mode);
+        if (!stream.csv.is_open()) { throw std::runtime_error("Could not open result file " + path + "!"); }
+        if (fresh) {
+            std::string header = "datetime";
+            if (stream.labelled) { header += ",label"; }
+            for (const std::string& column : stream.columns) { header += "," + column; }
+            stream.csv << header << "\n";
+        }
+    }
+    if ((formats & BINARY) && !stream.binary.is_open()) {
+        const std::string path = directory + "/" + stream.name + ".bin";
+        const bool fresh = is_new(path);
+        stream.binary.open(path, mode | std::ios_base::binary);
+        if (!stream.binary.is_open()) { throw std::runtime_error("Could not open result file " + path + "!"); }
+        if (fresh) {
+            std::string header("BTRS", 4);
+            const uint32_t version = 1;
+            auto num_columns = static_cast<uint32_t>(stream.columns.size());
+            header.append(reinterpret_cast<const char*>(&version), sizeof(version));
+            header.append(reinterpret_cast<const char*>(&num_columns), sizeof(num_columns));
+            for (const std::string& column : stream.columns) {
+                auto length = static_cast<uint32_t>(column.size());
+                header.append(reinterpret_cast<const char*>(&length), sizeof(length));
+                header.append(column);
+            }
+            stream.binary.write(header.data(), header.size());
+        }
+    }
+}
@@ -1,14 +1,14 @@
 import argparse
+import csv
 import matplotlib.pyplot as plt
 
 parser = argparse.ArgumentParser()
-parser.add_argument('-f', '--filepath', action='store', dest='filepath', help='Path of the file to read in and plot from.')
+parser.add_argument('-f', '--filepath', action='store', dest='filepath', help='Path of the result csv to read in and plot from.')
+parser.add_argument('-c', '--column', action='store', dest='column', default='equity_curve', help='Column of the result csv to plot.')
 args = parser.parse_args()
 
 with open(args.filepath, 'r') as f:
-    array = [[float(x) for x in line.split()] for line in f]
+    array = [float(row[args.column]) for row in csv.DictReader(f)]
     a = range(len(array))
     plt.plot(a, array)
     plt.show()
-
-
@@ -1,12 +1,15 @@
-import argparse, json
+import argparse, json, sys
 from slackclient import SlackClient
 
 with open('C:\\Users\\bloomberg\\CLionProjects\\bloomberg_backtester\\venv\\configuration.json') as f:
     data = json.load(f)
 
 parser = argparse.ArgumentParser()
-parser.add_argument('-m', '--message', action='store', dest='message', help='Message to send through Slack.')
+parser.add_argument('-m', '--message', action='store', dest='message',
+                    help='Message to send through Slack. Read from standard input when not given.')
 args = parser.parse_args()
+if args.message is None:
+    args.message = sys.stdin.read()
 
 sc = SlackClient(data['slackKey'])
 
@@ -18,4 +18,11 @@ double Slippage::get_slippage(double order_cost) {
     // Randomly sample a bps value from the distribution and return it as the slippage
     // We want the slippage to always be pessimistic, so distribution has more area above 0 (pos) or below 0 (neg)
     return abs(static_cast<int>(order_cost)) * distribution(generator) / 10000;
-}
\ No newline at end of file
+}
+
+// The mean of the log-normal distribution, exp(mean + sd^2 / 2), in the same bps of the order's value
+double Slippage::get_expected_slippage(double order_cost) {
+    const double bps = std::exp(simulation::SLIPPAGE_LN_MEAN +
+                                simulation::SLIPPAGE_LN_SD * simulation::SLIPPAGE_LN_SD / 2);
+    return abs(static_cast<int>(order_cost)) * bps / 10000;
+}
@@ -0,0 +1,123 @@
+// Include corresponding header
+#include "vectorized.hpp"
+// STL includes
+#include <cmath>
+#include <unordered_map>
+// Custom class includes
+#include "kernels.hpp"
+#include "slippage.hpp"
+#include "transactioncosts.hpp"
+
+// Each market event becomes a row, starting from a copy of the row before it so that missing prices carry forward
+PriceMatrix PriceMatrix::from_events(const std::vector<std::string> &symbols,
+                                     const std::list<std::unique_ptr<events::Event>> &events) {
+    PriceMatrix matrix;
+    matrix.symbols = symbols;
+    std::unordered_map<std::string, size_t> columns;
+    for (size_t i = 0; i < symbols.size(); ++i) { columns[symbols[i]] = i; }
+
+    std::vector<double> last(symbols.size(), 0.0);
+    for (const auto& event : events) {
+        if (event->type != "MARKET") { continue; }
+        auto market = dynamic_cast<const events::MarketEvent*>(event.get());
+        for (const auto& price : market->data) {
+            auto column = columns.find(price.first);
+            if (column != columns.end() && !std::isnan(price.second)) { last[column->second] = price.second; }
+        }
+        matrix.times.push_back(market->datetime);
+        matrix.prices.insert(matrix.prices.end(), last.begin(), last.end());
+    }
+    return matrix;
+}
+
+// The panel's layout is already the matrix's, so the field is copied over whole, with its NaNs made 0
+PriceMatrix PriceMatrix::from_panel(const Panel &panel, const std::string &field) {
+    PriceMatrix matrix;
+    matrix.symbols = panel.symbols;
+    matrix.times = panel.times;
+    const double* values = panel.field(panel.field_index(field));
+    matrix.prices.assign(values, values + panel.times.size() * panel.symbols.size());
+    for (double& price : matrix.prices) { if (std::isnan(price)) { price = 0; } }
+    return matrix;
+}
+
+// Holds onto the prices
+VectorizedBacktest::VectorizedBacktest(PriceMatrix p_prices, unsigned int p_initial_capital, bool p_random_slippage) :
+        matrix(std::move(p_prices)),
+        initial_capital(p_initial_capital),
+        random_slippage(p_random_slippage) {
+    if (matrix.prices.size() != matrix.times.size() * matrix.symbols.size()) {
+        throw std::runtime_error("Price matrix does not have a price for every symbol at every time!");
+    }
+}
+
+// Positions are kept as doubles so the holdings are one dot product of the positions and the row's prices
+VectorizedResult VectorizedBacktest::run(const WeightFunction &weights, double periods_per_year) const {
+    const size_t width = matrix.symbols.size();
+    VectorizedResult result;
+    result.equity.reserve(matrix.times.size());
+    result.returns.reserve(matrix.times.size());
+    Analytics analytics(periods_per_year);
+
+    std::vector<double> positions(width, 0.0), targets(width, 0.0);
+    double cash = initial_capital;
+    double previous = initial_capital;
+    // Performance is measured from the capital, before the first rebalance pays its costs
+    if (!matrix.times.empty()) { analytics.update(matrix.times.front(), initial_capital, 0); }
+    for (size_t time = 0; time < matrix.times.size(); ++time) {
+        const double* prices = matrix.row(time);
+        if (weights(time, matrix, targets.data())) {
+            const double total = cash + kernels::dot(positions.data(), prices, width);
+            for (size_t i = 0; i < width; ++i) {
+                if (prices[i] <= 0 || std::isnan(targets[i])) { continue; }
+                // As in process_signal, nothing is ordered for a negligible change, and the quantity is rounded
+                // towards zero so the target is never overshot, except that a target of 0 closes the position
+                const double needed = targets[i] - positions[i] * prices[i] / total;
+                if (std::abs(needed) < 0.00001) { continue; }
+                const double shares = needed * total / prices[i];
+                const double quantity = targets[i] == 0 ? -positions[i] :
+                                        (shares > 0 ? std::floor(shares) : std::ceil(shares));
+                if (quantity == 0) { continue; }
+
+                const double cost = quantity * prices[i];
+                const double slippage = random_slippage ? Slippage::get_slippage(cost) :
+                                        Slippage::get_expected_slippage(cost);
+                const double commission = TransactionCosts::get_IB_transaction_cost(static_cast<int>(quantity));
+                positions[i] += quantity;
+                cash -= cost + commission + slippage;
+                result.commission += commission;
+                result.slippage += slippage;
+                result.traded += std::abs(cost);
+                result.fills++;
+                analytics.update_fill(events::FillEvent(matrix.symbols[i], static_cast<int>(quantity), cost, slippage,
+                                                        commission, matrix.times[time]));
+            }
+        }
+
+        const double equity = cash + kernels::dot(positions.data(), prices, width);
+        result.equity.push_back(equity);
+        result.returns.push_back(previous != 0 ? equity / previous - 1 : 0);
+        previous = equity;
+        analytics.update(matrix.times[time], equity, kernels::gross(positions.data(), prices, width));
+    }
+
+    result.positions.assign(positions.begin(), positions.end());
+    result.stats = analytics.stats();
+    return result;
+}
+
+// Walks the rebalance rows alongside the prices
+VectorizedResult VectorizedBacktest::run(const std::vector<size_t> &rows, const std::vector<double> &weights,
+                                         double periods_per_year) const {
+    const size_t width = matrix.symbols.size();
+    if (weights.size() != rows.size() * width) {
+        throw std::runtime_error("Weight matrix does not have a weight for every symbol at every rebalance!");
+    }
+    size_t next = 0;
+    return run([&](size_t row, const PriceMatrix&, double* targets) {
+        while (next < rows.size() && rows[next] < row) { next++; }
+        if (next == rows.size() || rows[next] != row) { return false; }
+        std::copy(weights.begin() + next * width, weights.begin() + (next + 1) * width, targets);
+        return true;
+    }, periods_per_year);
+}
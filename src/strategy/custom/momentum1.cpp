@@ -7,7 +7,7 @@
 
 // Initialize the strategy to backtest
 ALGO_Momentum1::ALGO_Momentum1(const BloombergLP::blpapi::Datetime &start, const BloombergLP::blpapi::Datetime &end,
-                     unsigned int capital) :
+                     unsigned int capital, bool extending) :
         Strategy({"DIA US EQUITY", "QQQ US EQUITY", "LQD US EQUITY",
                   "HYG US EQUITY", "USO US EQUITY", "GLD US EQUITY",
                   "VNQ US EQUITY", "RWX US EQUITY", "UNG US EQUITY",
@@ -22,10 +22,11 @@ ALGO_Momentum1::ALGO_Momentum1(const BloombergLP::blpapi::Datetime &start, const
     dynamic_cast<HistoricalDataManager*>(data.get())->preload(symbol_list, {"PX_OPEN", "PX_LAST"}, start, end, 127);
     log("Backtest data pull complete.");
 
-    // Prepare performance csv
-    std::ofstream output;
-    output.open(R"(C:\Users\bloomberg\CLionProjects\bloomberg_backtester\saves\performance.csv)", std::ios_base::trunc | std::ios_base::out);
-    output.close();
+    // Record the performance into the saves folder, continuing the previous files when extending
+    record_results(R"(C:\Users\bloomberg\CLionProjects\bloomberg_backtester\saves)", extending);
+
+    // Bump whenever the trading logic changes, so an old checkpoint is not extended with new logic
+    strategy_version = "3";
 
     // Perform constant declarations and definitions here.
     context["lookback"] = 126;                                // The lookback for the moving average
@@ -35,6 +36,11 @@ ALGO_Momentum1::ALGO_Momentum1(const BloombergLP::blpapi::Datetime &start, const
     context["slopemin"] = 0.252;                              // Minimum slope on which to be trading on
     context["dailyvolatilitytarget"] = 0.025;                 // Target daily volatility, in percent
 
+    // Regress on the closes as they come in, starting from the lookback before the start
+    trend = &track_indicators((unsigned int) context["lookback"]);
+    trend->seed(*data->history(symbol_list, {"PX_LAST"}, (unsigned int) std::ceil(context["lookback"]*1.6), "DAILY"),
+                "PX_LAST");
+
     // Dictionary of weights, set for each security
     for (const std::string& sym : symbol_list) {
         symbolspecifics[sym]["weight"] = 0.0;
@@ -71,47 +77,30 @@ ALGO_Momentum1::ALGO_Momentum1(const BloombergLP::blpapi::Datetime &start, const
 //  1. Normalized slope over past [lookback] days is greater than [minslope]
 //  2. Price has crossed the regression line.
 void ALGO_Momentum1::regression() {
-    // Pull the past [lookback] of data from Bloomberg
-    std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> prices =
-            data->history(symbol_list, {"PX_OPEN"}, (unsigned int) std::ceil(context["lookback"]*1.6), "DAILY");
-
     // Iterate through each symbol to perform logic for each
     for (const std::string& symbol : symbol_list) {
-        // First build the vector for which regression can be calculated, along with a sd vairable
-        std::vector<double> x;
-        double sum_x1=0, sum_x2=0;
-        auto iter = prices->at(symbol).data.begin();
-        for (std::advance(iter, (prices->at(symbol).data.size() - (int)context["lookback"]));
-                iter != prices->at(symbol).data.end(); iter++) {
-            double val = (*iter).second["PX_OPEN"];
-            x.emplace_back(val);
-            sum_x1 += val;
-            sum_x2 += val * val;
-        }
+        // The regression line over the past [lookback] closes, updated with each day's close
+        const RollingIndicators& line = (*trend)[symbol];
+        if (!line.ready()) { continue; }
 
-        // Get the price series fo
-        // With the price vector built, perform the regression
-        std::pair<double, double> results = calcreg(x);
         // Get the normalized slope (return per year)
-        const double slope = results.first / results.second * 252.0;
+        const double slope = line.slope() / line.intercept() * 252.0;
         // Calculate the difference in actual price vs regression over the past 2 days
-        auto priceiter = prices->at(symbol).data.rbegin();
-        const double delta1 = (*priceiter).second["PX_OPEN"] - (results.first*context["lookback"] + results.second);
-        priceiter++;
-        const double delta2 = (*priceiter).second["PX_OPEN"] - (results.first*(context["lookback"]-1) + results.second);
+        const double delta1 = line.back() - line.fitted(context["lookback"]);
+        const double delta2 = line.back(1) - line.fitted(context["lookback"] - 1);
         // Also get the standard deviation of the price series
-        const double sd = sqrt((sum_x2 / context["lookback"]) - ((sum_x1 / context["lookback"]) * (sum_x1 / context["lookback"])));
+        const double sd = line.stddev();
 
         // If long but the slope turns down, exit
         if (symbolspecifics[symbol]["weight"] > 0 && slope < 0) {
             symbolspecifics[symbol]["weight"] = 0.0;
             symbolspecifics[symbol]["bought"] = 0;
-            log("v Slope turned bull " + symbol);
+            BT_DEBUG(current_time, "v Slope turned bull " + symbol);
         // If shortbut the slope turns up, exit
         } else if (symbolspecifics[symbol]["weight"] < 0 && slope > 0) {
             symbolspecifics[symbol]["weight"] = 0.0;
             symbolspecifics[symbol]["bought"] = 0;
-            log("v Slope turned bear " + symbol);
+            BT_DEBUG(current_time, "v Slope turned bear " + symbol);
         }
 
         // If the trend is up enough
@@ -122,13 +111,13 @@ void ALGO_Momentum1::regression() {
                 symbolspecifics[symbol]["stopprice"] = -100000000;
                 symbolspecifics[symbol]["weight"] = slope;
                 symbolspecifics[symbol]["bought"] = 0;
-                log(std::string("---------- Long  a = ") + std::to_string(slope * 100) + "% for " + symbol);
+                BT_INFO(current_time, std::string("---------- Long  a = ") + std::to_string(slope * 100) + "% for " + symbol);
             // If the price is greater than the profit take Bollinger Band and we are long in it
             } else if (delta1 > context["profittake"] * sd && symbolspecifics[symbol]["weight"] > 0) {
                 // Exit the position by setting the weight to 0
                 symbolspecifics[symbol]["weight"] = 0.0;
                 symbolspecifics[symbol]["bought"] = 0;
-                log("---- Exit long in " + symbol);
+                BT_INFO(current_time, "---- Exit long in " + symbol);
             }
         // If the trend is down enough
         } else if (slope < -context["slopemin"]) {
@@ -138,13 +127,13 @@ void ALGO_Momentum1::regression() {
                 symbolspecifics[symbol]["stopprice"] = -100000000;
                 symbolspecifics[symbol]["weight"] = slope;
                 symbolspecifics[symbol]["bought"] = 0;
-                log(std::string("---------- Short  a = ") + std::to_string(slope * 100) + "% for " + symbol);
+                BT_INFO(current_time, std::string("---------- Short  a = ") + std::to_string(slope * 100) + "% for " + symbol);
                 // If the price is less than the profit take Bollinger Band and we are short in it
             } else if (delta1 < -context["profittake"] * sd && symbolspecifics[symbol]["weight"] < 0) {
                 // Exit the position by setting the weight to 0
                 symbolspecifics[symbol]["weight"] = 0.0;
                 symbolspecifics[symbol]["bought"] = 0;
-                log("---- Exit short in " + symbol);
+                BT_INFO(current_time, "---- Exit short in " + symbol);
             }
         }
     }
@@ -153,16 +142,17 @@ void ALGO_Momentum1::regression() {
 // Exits positions where the trend seems to be fading. Conditions:
 //  1. Stop price is hit (the estimated price before the lookback period according to the regression)
 void ALGO_Momentum1::exitconditions() {
+    // The past couple of days of prices for every symbol, pulled once for all of them
+    std::shared_ptr<const std::unordered_map<std::string, SymbolHistoricalData>> prices =
+            data->history(symbol_list, {"PX_LAST"}, 4, "DAILY");
     // Again, iterate through the symbols to perform the calculations for each stock
     for (const std::string& symbol : symbol_list) {
         // Get the mean price over the past couple of days as a more robust statistic
-        std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> prices =
-                data->history(symbol_list, {"PX_LAST"}, 4, "DAILY");
         double price=0;
         double n = 0;
         for (auto &iter : prices->at(symbol).data) {
             n++;
-            price += iter.second["PX_LAST"];
+            price += iter.second.at("PX_LAST");
         }
 
         price /= n;
@@ -182,7 +172,7 @@ void ALGO_Momentum1::exitconditions() {
                 // Make sure the price is outside of the stop price anyways, if not then sell all shares
                 if (price < symbolspecifics[symbol]["stopprice"]) {
                     // Notify us of the exiting of the position
-                    log("x Long stop loss for " + symbol+ ", sell all shares.");
+                    BT_INFO(current_time, "x Long stop loss for " + symbol+ ", sell all shares.");
                     symbolspecifics[symbol]["weight"] = 0;
                     symbolspecifics[symbol]["bought"] = 0;
                     // We just use order percent here because we want to exit the trend immediately (not end of day)
@@ -200,7 +190,7 @@ void ALGO_Momentum1::exitconditions() {
                 // Make sure the price is outside of the stop price anyways, if not then sell all shares
                 if (price > symbolspecifics[symbol]["stopprice"]) {
                     // Notify us of the exiting of the position
-                    log("x Short stop loss for " + symbol+ ", sell all shares.");
+                    BT_INFO(current_time, "x Short stop loss for " + symbol+ ", sell all shares.");
                     symbolspecifics[symbol]["weight"] = 0;
                     symbolspecifics[symbol]["bought"] = 0;
                     // We just use order percent here because we want to exit the trend immediately (not end of day)
@@ -223,13 +213,14 @@ void ALGO_Momentum1::trade() {
     for (const std::string& sym : symbol_list) { if (symbolspecifics[sym]["weight"] != 0 ||
         (symbolspecifics[sym]["bought"] == 0 && symbolspecifics[sym]["weight"] == 0)) { nopositions++; } }
 
-    // Now iterate through the weights and perform the trades
+    // Now iterate through the weights and collect the trades, which are ordered together as a single rebalance
+    std::unordered_map<std::string, double> targets;
     for (const std::string& symbol : symbol_list) {
         // Only check if the symbol hasn't been bought yet
         if (symbolspecifics[symbol]["bought"] == 0) {
             if (symbolspecifics[symbol]["weight"] == 0) {
                 // Log the exiting of the position
-                order_target_percent(symbol, 0);
+                targets[symbol] = 0;
                 symbolspecifics[symbol]["bought"] = 1;
             } else if (symbolspecifics[symbol]["weight"] > 0) {
                 double percent =
@@ -237,10 +228,10 @@ void ALGO_Momentum1::trade() {
                          nopositions); // * vol_mult[symbol];
                 if (std::isnan(percent)) {
                     std::cout << "NaN trade value, skipping." << std::endl;
-                    return;
+                    break;
                 }
-                log(std::string("^ Go long ") + std::to_string(percent*100) + "% in " + symbol);
-                order_target_percent(symbol, percent);
+                BT_INFO(current_time, std::string("^ Go long ") + std::to_string(percent*100) + "% in " + symbol);
+                targets[symbol] = percent;
                 symbolspecifics[symbol]["bought"] = 1;
             } else if (symbolspecifics[symbol]["weight"] < 0) {
                 double percent =
@@ -248,33 +239,15 @@ void ALGO_Momentum1::trade() {
                          nopositions); // * vol_mult[symbol];
                 if (std::isnan(percent)) {
                     std::cout << "NaN trade value, skipping." << std::endl;
-                    return;
+                    break;
                 }
-                log(std::string("v Go short ") + std::to_string(percent*100) + "% in " + symbol);
-                order_target_percent(symbol, percent);
+                BT_INFO(current_time, std::string("v Go short ") + std::to_string(percent*100) + "% in " + symbol);
+                targets[symbol] = percent;
                 symbolspecifics[symbol]["bought"] = 1;
             }
         }
     }
-}
-
-// Performs a linear regression to get the slope and intercept of a line for a given vector
-// First element of tuple is the slope, second is the intercept.
-std::pair<double, double> ALGO_Momentum1::calcreg(std::vector<double> x) {
-    double xSum=0, ySum=0, xxSum=0, xySum=0, slope=0, intercept=0;
-    // Build a vector of increasing-by-one integers to act as the Y array
-    std::vector<int> y(x.size());
-    std::iota(std::begin(y), std::end(y), 0);
-    // Now find the slope and intercept
-    for (int i = 0; i < y.size(); i++) {
-        xSum += y[i];
-        ySum += x[i];
-        xxSum += y[i] * y[i];
-        xySum += y[i] * x[i];
-    }
-    slope = (y.size()*xySum - xSum*ySum) / (y.size()*xxSum - xSum*xSum);
-    intercept = (xxSum*ySum - xySum*xSum) / (y.size()*xxSum - xSum*xSum);
-    return std::make_pair(slope, intercept);
+    if (!targets.empty()) { order_target_percents(targets); }
 }
 
 // Reports the performance of the algorithm at end of every day.
@@ -284,9 +257,14 @@ void ALGO_Momentum1::reportperformance() {
         std::string(", Value: ") + std::to_string(portfolio.current_holdings[portfolio_fields::TOTAL_HOLDINGS]) +
         std::string(", Held Cash: ") + std::to_string(portfolio.current_holdings[portfolio_fields::HELD_CASH]));
 
-    // Build a .csv with the returns for plotting in Python
-    std::ofstream output;
-    output.open(R"(C:\Users\bloomberg\CLionProjects\bloomberg_backtester\saves\performance.csv)", std::ios_base::app | std::ios_base::out);
-    output << portfolio.current_holdings[portfolio_fields::EQUITY_CURVE] << "\n";
-    output.close();
+    // Record the day's results for plotting in Python
+    results->push(result_streams::EQUITY, current_time, {portfolio.current_holdings[portfolio_fields::EQUITY_CURVE],
+                                                         portfolio.current_holdings[portfolio_fields::TOTAL_HOLDINGS],
+                                                         portfolio.current_holdings[portfolio_fields::HELD_CASH]});
+    results->push(result_streams::RETURNS, current_time, {portfolio.current_holdings[portfolio_fields::RETURNS]});
+    for (const std::string& symbol : symbol_list) {
+        results->push(result_streams::POSITIONS, current_time,
+                      {static_cast<double>(portfolio.current_positions[symbol]), portfolio.current_holdings[symbol]},
+                      symbol);
+    }
 }
\ No newline at end of file
@@ -18,8 +18,10 @@
 // LOGIC: A simple strategy which buys 10% in SPY, AAPL, and CAT on the first day and then holds for duration.
 class ALGO_Momentum1 : public Strategy {
 public:
-    // Constructor initializes Strategy parent
-    ALGO_Momentum1(const BloombergLP::blpapi::Datetime& start, const BloombergLP::blpapi::Datetime& end, unsigned int capital);
+    // Constructor initializes Strategy parent. When extending a previous run, the result files are continued
+    // rather than started over.
+    ALGO_Momentum1(const BloombergLP::blpapi::Datetime& start, const BloombergLP::blpapi::Datetime& end, unsigned int capital,
+                   bool extending = false);
 
     // Trading logic goes here
     void regression();
@@ -31,8 +33,8 @@ public:
     void reportperformance();
 
 private:
-    // Calculates the slope and intercept beginning at a certain value until the end
-    std::pair<double, double> calcreg(std::vector<double> x);
+    // Rolling regression of each symbol's closes over the lookback, kept by the strategy
+    Indicators* trend;
 };
 
 #endif //BACKTESTER_MOMENTUM1_HPP
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <iomanip>
 #include <utility>
 
 //
@@ -27,6 +29,24 @@ void BaseStrategy::order_target_percent(const std::string &symbol, double percen
     stack_eventqueue.emplace(std::make_unique<events::SignalEvent>(symbol, percent, current_time));
 }
 
+// Orders every stock up to its target percentage with a single rebalance event, in the order of the symbol list
+void BaseStrategy::order_target_percents(const std::unordered_map<std::string, double> &percents) {
+    std::vector<std::pair<std::string, double>> targets;
+    targets.reserve(percents.size());
+    for (const std::string& symbol : symbol_list) {
+        auto percent = percents.find(symbol);
+        if (percent != percents.end()) { targets.emplace_back(symbol, percent->second); }
+    }
+    if (targets.size() != percents.size()) {
+        for (const auto& percent : percents) {
+            if (std::find(symbol_list.begin(), symbol_list.end(), percent.first) == symbol_list.end()) {
+                throw std::runtime_error(percent.first + " is not one of the strategy's symbols!");
+            }
+        }
+    }
+    stack_eventqueue.emplace(std::make_unique<events::RebalanceEvent>(targets, current_time));
+}
+
 // Saves the state of the strategy to the text file specified in JSON format
 void BaseStrategy::save_state(const std::string &filepath) {
     // Open the file, truncating first
@@ -69,11 +89,228 @@ void BaseStrategy::load_state(const std::string &filepath) {
     symbolspecifics = m5;
 }
 
+// Writes the state into a buffer and then out to the file at once
+void BaseStrategy::save_checkpoint(const std::string &filepath) {
+    checkpoint::Writer writer;
+    write_checkpoint(writer);
+    writer.save(filepath);
+}
+
+// Reads the whole checkpoint and replaces the current state with it
+void BaseStrategy::load_checkpoint(const std::string &filepath) {
+    checkpoint::Reader reader(filepath);
+    read_checkpoint(reader);
+    restored = true;
+}
+
+// The previous run went through all of its events, so its HEAP only ever holds events which are also on the new
+// HEAP. The new HEAP is kept instead, without the events up to where the previous run stopped.
+void BaseStrategy::extend_checkpoint(const std::string &filepath) {
+    std::list<std::unique_ptr<events::Event>> new_heap = std::move(heap_eventlist);
+    load_checkpoint(filepath);
+    const BloombergLP::blpapi::Datetime& stopped = current_time;
+    new_heap.remove_if([&stopped](const std::unique_ptr<events::Event>& event) {
+        return !date_funcs::is_greater(event->datetime, stopped); });
+    heap_eventlist = std::move(new_heap);
+}
+
+// FNV-1a over everything identifying the strategy, with maps walked in sorted order so the hash is stable
+const std::string& BaseStrategy::fingerprint() {
+    if (!strategy_fingerprint.empty()) { return strategy_fingerprint; }
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const void* data, size_t length) {
+        auto bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < length; ++i) { hash = (hash ^ bytes[i]) * 1099511628211ULL; }
+    };
+    auto mix_string = [&mix](const std::string& value) { mix(value.data(), value.size()); mix("", 1); };
+    auto mix_map = [&mix, &mix_string](const std::unordered_map<std::string, double>& values) {
+        for (const auto& value : std::map<std::string, double>(values.begin(), values.end())) {
+            mix_string(value.first);
+            mix(&value.second, sizeof(value.second));
+        }
+    };
+
+    mix_string(typeid(*this).name());
+    mix_string(strategy_version);
+    for (const std::string& symbol : symbol_list) { mix_string(symbol); }
+    mix(&initial_capital, sizeof(initial_capital));
+    size_t num_scheduled = schedule_size();
+    mix(&num_scheduled, sizeof(num_scheduled));
+    mix_map(context);
+    std::map<std::string, std::unordered_map<std::string, double>> specifics(symbolspecifics.begin(), symbolspecifics.end());
+    for (const auto& symbol : specifics) { mix_string(symbol.first); mix_map(symbol.second); }
+
+    std::stringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << hash;
+    strategy_fingerprint = hex.str();
+    return strategy_fingerprint;
+}
+
+// Stores where and how often to checkpoint
+void BaseStrategy::checkpoint_every(const std::string &filepath, unsigned long events) {
+    checkpointFileLocation = filepath;
+    checkpoint_interval = events;
+    events_since_checkpoint = 0;
+}
+
+// The summary is written first, then the symbols so a checkpoint is never restored into a strategy trading
+// different securities
+void BaseStrategy::write_checkpoint(checkpoint::Writer &writer) {
+    writer.put(fingerprint());
+    writer.put(current_time);
+    writer.put<uint64_t>(symbol_list.size());
+    for (const std::string& symbol : symbol_list) { writer.put(symbol); }
+    writer.put(start_date);
+    writer.put(end_date);
+    writer.put(context);
+    writer.put<uint64_t>(symbolspecifics.size());
+    for (const auto& specifics : symbolspecifics) { writer.put(specifics.first); writer.put(specifics.second); }
+    portfolio.write_checkpoint(writer);
+    analytics.write_checkpoint(writer);
+    writer.put<uint64_t>(benchmarks.size());
+    for (const BenchmarkOverlay& benchmark : benchmarks) { benchmark.write_checkpoint(writer); }
+    writer.put<uint64_t>(indicator_sets.size());
+    for (const auto& indicators : indicator_sets) { indicators->write_checkpoint(writer); }
+    checkpoint::put_events(writer, stack_eventqueue, heap_eventlist);
+}
+
+// Reads everything back in the order it was written. The end date stays the one the strategy was constructed with,
+// so a restored run can also be taken further than the one which wrote the checkpoint, but never shorter.
+void BaseStrategy::read_checkpoint(checkpoint::Reader &reader) {
+    if (reader.get_string() != fingerprint()) {
+        throw std::runtime_error("Checkpoint was written by a different strategy or with different parameters!");
+    }
+    current_time = reader.get_datetime();
+    std::vector<std::string> symbols(reader.get_count(sizeof(uint64_t)));
+    for (std::string& symbol : symbols) { symbol = reader.get_string(); }
+    if (symbols != symbol_list) { throw std::runtime_error("Checkpoint was written for a different symbol list!"); }
+    start_date = reader.get_datetime();
+    if (date_funcs::is_greater(reader.get_datetime(), end_date)) {
+        throw std::runtime_error("Checkpoint was written for a run ending after this one!");
+    }
+    context = reader.get_map<double>();
+    symbolspecifics.clear();
+    auto num_specifics = reader.get<uint64_t>();
+    for (uint64_t i = 0; i < num_specifics; ++i) {
+        std::string symbol = reader.get_string();
+        symbolspecifics[symbol] = reader.get_map<double>();
+    }
+    portfolio.read_checkpoint(reader);
+    analytics.read_checkpoint(reader);
+    if (reader.get<uint64_t>() != benchmarks.size()) {
+        throw std::runtime_error("Checkpoint was written against different benchmarks!");
+    }
+    for (BenchmarkOverlay& benchmark : benchmarks) { benchmark.read_checkpoint(reader, analytics); }
+    if (reader.get<uint64_t>() != indicator_sets.size()) {
+        throw std::runtime_error("Checkpoint was written with different indicators!");
+    }
+    for (auto& indicators : indicator_sets) { indicators->read_checkpoint(reader); }
+    checkpoint::get_events(reader, stack_eventqueue, heap_eventlist,
+            [this](uint32_t schedule_id, const BloombergLP::blpapi::Datetime& when) {
+                return scheduled_event(schedule_id, when); });
+}
+
+// Checkpoints are only taken between the STACK being emptied and the next HEAP event, so no half-processed
+// order is ever saved
+void BaseStrategy::count_checkpoint() {
+    if (checkpoint_interval == 0) { return; }
+    events_since_checkpoint++;
+    if (events_since_checkpoint >= checkpoint_interval && stack_eventqueue.empty()) {
+        before_checkpoint();
+        save_checkpoint(checkpointFileLocation);
+        events_since_checkpoint = 0;
+    }
+}
+
+// Builds the sink and its standard streams
+void BaseStrategy::record_results(const std::string &directory, bool append) {
+    results = std::make_unique<ResultSink>(directory, ResultSink::CSV | ResultSink::BINARY, append);
+    results->add_stream(result_streams::EQUITY, {portfolio_fields::EQUITY_CURVE, portfolio_fields::TOTAL_HOLDINGS,
+                                                 portfolio_fields::HELD_CASH});
+    results->add_stream(result_streams::RETURNS, {portfolio_fields::RETURNS});
+    results->add_stream(result_streams::TRADES, {"quantity", "cost", "slippage", "commission"}, true);
+    results->add_stream(result_streams::POSITIONS, {"quantity", "holdings"}, true);
+}
+
+// Pushes the fill's details labelled with its symbol
+void BaseStrategy::record_fill(const events::FillEvent &fill) {
+    if (!results) { return; }
+    results->push(result_streams::TRADES, fill.datetime,
+                  {static_cast<double>(fill.quantity), fill.cost, fill.slippage, fill.commission}, fill.symbol);
+}
+
+// Gross exposure is summed over the holdings of every symbol, as the portfolio sums its total. The benchmarks after
+// the first are updated before the strategy's analytics, which they copy on their first update.
+void BaseStrategy::update_analytics(const events::MarketEvent &event) {
+    double gross = 0;
+    for (const std::string& symbol : symbol_list) { gross += std::abs(portfolio.current_holdings[symbol]); }
+    const double equity = portfolio.current_holdings[portfolio_fields::TOTAL_HOLDINGS];
+    for (size_t i = 1; i < benchmarks.size(); ++i) { benchmarks[i].update(event, equity, gross, analytics); }
+    analytics.update(event.datetime, equity, gross,
+                     benchmarks.empty() ? std::numeric_limits<double>::quiet_NaN() : benchmarks.front().level(event));
+}
+
+// Only the benchmarks after the first have statistics of their own to print
+void BaseStrategy::report(std::ostream &out) const {
+    analytics.report(out);
+    for (size_t i = 1; i < benchmarks.size(); ++i) {
+        const PerformanceStats result = benchmarks[i].stats();
+        if (!result.has_benchmark) { continue; }
+        const std::ios_base::fmtflags flags = out.flags();
+        const std::streamsize precision = out.precision();
+        out << std::fixed << std::setprecision(2) << "Against " << benchmarks[i].symbol() << ":\n"
+            << "  Beta / alpha:        " << result.beta << " / " << result.alpha * 100 << "%\n"
+            << "  Correlation:         " << result.correlation << "\n"
+            << "  Tracking error / IR: " << result.tracking_error * 100 << "% / " << result.information_ratio << "\n";
+        out.flags(flags);
+        out.precision(precision);
+    }
+}
+
+// Without a data manager to pull from, only the strategy's own symbols can be compared against
+std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> BaseStrategy::benchmark_series(
+        const std::string &symbol) {
+    throw std::runtime_error("Benchmark " + symbol + " is not one of the strategy's symbols!");
+}
+
+// Builds the set over the strategy's symbols
+Indicators& BaseStrategy::track_indicators(unsigned int window, unsigned int ema_span) {
+    indicator_sets.emplace_back(std::make_unique<Indicators>(symbol_list, window, ema_span));
+    return *indicator_sets.back();
+}
+
 // Logs a message to the console with the current time
-void BaseStrategy::log(const std::string &message) { std::cout << "[" << current_time << "] " << message << std::endl; }
-// Logs a message to Slack with the current time (to be done later)
+void BaseStrategy::log(const std::string &message) { BT_INFO(current_time, message); }
+// Logs the message at the given level
+void BaseStrategy::log(logging::Level level, const std::string &message) { BT_LOG(level, current_time, message); }
+// Queues a message to Slack, starting the notifier if this is the first one
 void BaseStrategy::message(const std::string &message) {
-    system(std::string(R"(C:\python27\python.exe C:\Users\bloomberg\CLionProjects\bloomberg_backtester\src\python\slackmanagement.py -m=")").append(message + "\"").c_str());
+    if (!notifier) { notifier = std::make_unique<Notifier>(std::make_unique<SlackSink>()); }
+    notifier->notify(message);
+}
+// Replaces the notifier with one delivering to the sink, after sending anything the old one still has queued
+void BaseStrategy::notify_to(std::unique_ptr<NotificationSink> sink) {
+    notifier = std::make_unique<Notifier>(std::move(sink));
+}
+// Sets the instrumentation dump file
+void BaseStrategy::instrument_to(const std::string &filepath) { instrumentationFileLocation = filepath; }
+// Adds the benchmark, priced by the market events if the strategy trades it and by its series otherwise
+void BaseStrategy::compare_to(const std::string &symbol) {
+    for (const BenchmarkOverlay& benchmark : benchmarks) {
+        if (benchmark.symbol() == symbol) { throw std::runtime_error("Already comparing against " + symbol + "!"); }
+    }
+    if (std::find(symbol_list.begin(), symbol_list.end(), symbol) != symbol_list.end()) {
+        benchmarks.emplace_back(symbol);
+    } else {
+        benchmarks.emplace_back(symbol, benchmark_series(symbol));
+    }
+}
+// The first benchmark's statistics are the strategy's own
+PerformanceStats BaseStrategy::benchmark_stats(const std::string &symbol) const {
+    for (size_t i = 0; i < benchmarks.size(); ++i) {
+        if (benchmarks[i].symbol() == symbol) { return i == 0 ? analytics.stats() : benchmarks[i].stats(); }
+    }
+    throw std::runtime_error("Not comparing against " + symbol + "!");
 }
 
 // Builds the Strategy object with the given initial capital and start and end. To reformat the strategy,
@@ -86,10 +323,11 @@ Strategy::Strategy(const std::vector<std::string>& p_symbol_list,
                    const std::string& p_backtest_type) :
            BaseStrategy(p_symbol_list, p_initial_capital, p_start_date, p_end_date, p_saveFileLocation),
            backtest_type(p_backtest_type),
-           data(std::make_shared<HistoricalDataManager>(&current_time,
+           data(p_backtest_type == "INTRADAY" ?
+                   std::shared_ptr<DataManager>(std::make_shared<IntradayDataManager>(&current_time)) :
+                   std::make_shared<HistoricalDataManager>(&current_time,
                    // Ternary used for setting the correlation ID
-                   (p_backtest_type == "HISTORICAL" ? correlation_ids::HISTORICAL_REQUEST_CID :
-                    p_backtest_type == "INTRADAY" ? correlation_ids::INTRADAY_REQUEST_CID : correlation_ids::LIVE_REQUEST_CID)
+                   (p_backtest_type == "HISTORICAL" ? correlation_ids::HISTORICAL_REQUEST_CID : correlation_ids::LIVE_REQUEST_CID)
            )),
            execution_handler(&stack_eventqueue, &heap_eventlist, data, &portfolio) {
 
@@ -98,18 +336,53 @@ Strategy::Strategy(const std::vector<std::string>& p_symbol_list,
         // Make sure to fill the HEAP event list with the MarketEvents.
         auto hist_data = dynamic_cast<HistoricalDataManager*>(data.get());
         hist_data->fillHistory(symbol_list, start_date, end_date, &heap_eventlist);
+    } else if (backtest_type == "INTRADAY") {
+        // Bars are streamed onto the HEAP a day at a time while running rather than all filled in now
+        intraday_data = dynamic_cast<IntradayDataManager*>(data.get());
+        intraday_data->beginStream(symbol_list, start_date, end_date);
+        // Minute bars, of which there are 390 in a trading day
+        analytics.set_periods(252 * 390);
     }
 }
 
+// Builds the Strategy on a SyntheticDataManager, generating its market and filling the HEAP with it straight away
+Strategy::Strategy(const std::vector<std::string>& p_symbol_list,
+                   unsigned int p_initial_capital,
+                   const BloombergLP::blpapi::Datetime &p_start_date,
+                   const BloombergLP::blpapi::Datetime &p_end_date,
+                   const SyntheticMarket& p_market) :
+           BaseStrategy(p_symbol_list, p_initial_capital, p_start_date, p_end_date),
+           data(std::make_shared<SyntheticDataManager>(&current_time, p_market)),
+           backtest_type("SYNTHETIC"),
+           execution_handler(&stack_eventqueue, &heap_eventlist, data, &portfolio) {
+    dynamic_cast<SyntheticDataManager*>(data.get())->fillHistory(symbol_list, start_date, end_date, &heap_eventlist);
+    analytics.set_periods(p_market.bar_minutes ? 252.0 * 390 / p_market.bar_minutes : 252);
+}
+
+// Builds the Strategy on the host's data manager, leaving its HEAP empty for the functions it schedules
+Strategy::Strategy(const std::vector<std::string>& p_symbol_list,
+                   unsigned int p_initial_capital,
+                   const BloombergLP::blpapi::Datetime &p_start_date,
+                   const BloombergLP::blpapi::Datetime &p_end_date,
+                   std::shared_ptr<DataManager> p_shared_data) :
+           BaseStrategy(p_symbol_list, p_initial_capital, p_start_date, p_end_date),
+           data(std::move(p_shared_data)),
+           backtest_type("SHARED"),
+           execution_handler(&stack_eventqueue, &heap_eventlist, data, &portfolio) {}
+
 // Runs the strategy by iterating through the HEAP event list until it is empty
 void Strategy::run() {
-    // Load in data from the save state if necessary
-    if (!saveFileLocation.empty()) { load_state(saveFileLocation); }
-    // Place the iterator onto the heap eventlist
-    running = true;
+    if (backtest_type == "SHARED") {
+        throw std::runtime_error("Strategies on a shared data manager are run by their StrategyHost!");
+    }
+    start_run();
 
     // Use a boolean value to allow for exiting after a loop
-    while(running && (!heap_eventlist.empty() || !stack_eventqueue.empty())) {
+    while(running) {
+        // In intraday mode, pull in the next day of bars once the HEAP reaches it
+        if (intraday_data && stack_eventqueue.empty()) { intraday_data->streamBars(&heap_eventlist); }
+        if (heap_eventlist.empty() && stack_eventqueue.empty()) { break; }
+
         std::unique_ptr<events::Event> event;
         // If the STACK is empty, take in events on the HEAP and process them, otherwise go through
         // the events on the STACK until it is empty. STACk always starts out empty.
@@ -122,45 +395,122 @@ void Strategy::run() {
             event = std::move(heap_eventlist.front());
             heap_eventlist.pop_front();
         }
+        process(*event);
+    }
+
+    finish_run();
+}
 
-        // Set the current time to the datetime of the event
-        current_time = event->datetime;
-        // Now downcast the event and perform whatever function it requires
-        if (event->type == "MARKET") {
-            events::MarketEvent event_market = *dynamic_cast<events::MarketEvent *>(event.release());
+// Gets ready to take the first event
+void Strategy::start_run() {
+    // Identify the strategy before it changes any of its context
+    fingerprint();
+    // Load in data from the save state if necessary, unless continuing from a checkpoint
+    if (!saveFileLocation.empty() && !restored) { load_state(saveFileLocation); }
+    // Measure the performance from the holdings the run starts with, before anything is traded
+    if (!restored) { analytics.update(current_time, portfolio.current_holdings[portfolio_fields::TOTAL_HOLDINGS], 0); }
+    running = true;
+}
+
+// Processes one event taken off the STACK or HEAP
+void Strategy::process(events::Event &event) {
+    // Set the current time to the datetime of the event
+    current_time = event.datetime;
+    BT_SAMPLE_QUEUES(stack_eventqueue, heap_eventlist);
+    // Now downcast the event and perform whatever function it requires, timing it when instrumented
+    {
+        BT_PROBE_EVENT(event.type);
+        if (event.type == "MARKET") {
+            events::MarketEvent& event_market = *dynamic_cast<events::MarketEvent *>(&event);
             // Pass the market event into the portfolio to update holdings
             portfolio.update_market(event_market);
+            update_analytics(event_market);
+            for (auto& indicators : indicator_sets) { indicators->update(event_market); }
 
-        } else if (event->type == "SIGNAL") {
-            events::SignalEvent event_signal = *dynamic_cast<events::SignalEvent *>(event.release());
+        } else if (event.type == "SIGNAL") {
+            events::SignalEvent& event_signal = *dynamic_cast<events::SignalEvent *>(&event);
             // Pass the signal event into the execution handler to generate orders
             execution_handler.process_signal(event_signal);
 
-        } else if (event->type == "ORDER") {
-            events::OrderEvent event_order = *dynamic_cast<events::OrderEvent *>(event.release());
+        } else if (event.type == "ORDER") {
+            events::OrderEvent& event_order = *dynamic_cast<events::OrderEvent *>(&event);
             // Pass the order event into the execution handler to generate a fill
             execution_handler.process_order(event_order);
 
-        } else if (event->type == "FILL") {
-            events::FillEvent event_fill = *dynamic_cast<events::FillEvent *>(event.release());
+        } else if (event.type == "REBALANCE") {
+            // Pass the rebalance into the execution handler to fill all of its orders at once
+            execution_handler.process_rebalance(*dynamic_cast<events::RebalanceEvent *>(&event));
+
+        } else if (event.type == "FILLS") {
+            events::FillsEvent& event_fills = *dynamic_cast<events::FillsEvent *>(&event);
+            // Pass the fills into the portfolio to update holdings once for all of them
+            portfolio.update_fills(event_fills);
+            for (const events::FillEvent& event_fill : event_fills.fills) {
+                analytics.update_fill(event_fill);
+                record_fill(event_fill);
+            }
+
+        } else if (event.type == "FILL") {
+            events::FillEvent& event_fill = *dynamic_cast<events::FillEvent *>(&event);
             // Pass the fill event into the portfolio to update holdings
             portfolio.update_fill(event_fill);
+            analytics.update_fill(event_fill);
+            record_fill(event_fill);
 
-        } else if (event->type == "SCHEDULED") {
-            events::ScheduledEvent<Strategy> event_scheduled = *dynamic_cast<events::ScheduledEvent<Strategy>*>(event.release());
+        } else if (event.type == "SCHEDULED") {
+            auto& event_scheduled = *dynamic_cast<events::ScheduledEvent<Strategy> *>(&event);
             // Run the function referenced to in the schedule event
+            BT_PROBE_SCHEDULED(event_scheduled.schedule_id);
             event_scheduled.run();
-        } else if (event->type == "STOP") {
-            event->what();
+        } else if (event.type == "STOP") {
+            event.what();
             running = false;
         }
     }
 
+
+    // Write the periodic checkpoint if one is due. A hosted strategy's HEAP does not hold the market events, so its
+    // checkpoints could not be restored.
+    if (backtest_type != "SHARED") { count_checkpoint(); }
+}
+
+// Reports on the run once there is nothing left to process
+void Strategy::finish_run() {
     // Print out performance
     std::string mess = std::string("Backtest finished. Total return: ") + std::to_string(portfolio.current_holdings[portfolio_fields::EQUITY_CURVE] * 100) + "%";
+    if (results) { results->flush(); }
     if (sendStatusMessage) { message(mess); }
     if (!saveFileLocation.empty()) { save_state(saveFileLocation); }
+    logging::flush();
     std::cout << mess << std::endl;
+    report(std::cout);
+    BT_INSTRUMENTATION_REPORT(std::cout, instrumentationFileLocation);
+}
+
+
+// The events on the HEAP at the time were scheduled after the market events there, so the market event goes first,
+// as it would in run()
+void Strategy::step(events::MarketEvent* market, const BloombergLP::blpapi::Datetime &time) {
+    if (!running) { return; }
+    if (market) {
+        process(*market);
+        drain_stack();
+    }
+    while (running && !heap_eventlist.empty() && !date_funcs::is_greater(heap_eventlist.front()->datetime, time)) {
+        std::unique_ptr<events::Event> event = std::move(heap_eventlist.front());
+        heap_eventlist.pop_front();
+        process(*event);
+        drain_stack();
+    }
+}
+
+// Processes the STACK until it is empty or the strategy stops
+void Strategy::drain_stack() {
+    while (running && !stack_eventqueue.empty()) {
+        std::unique_ptr<events::Event> event = std::move(stack_eventqueue.front());
+        stack_eventqueue.pop();
+        process(*event);
+    }
 }
 
 // Schedules member functions by putting a ScheduledEvent with a reference to the member function and a reference
@@ -168,12 +518,63 @@ void Strategy::run() {
 void Strategy::schedule_function(std::function<void(Strategy*)> func, const DateRules& dateRules, const TimeRules& timeRules) {
     // Get the datetimes at which the functions should be scheduled
     std::vector<BloombergLP::blpapi::Datetime> dates = dateRules.get_date_times(timeRules);
+    // Number the function so its events can be checkpointed
+    auto schedule_id = static_cast<uint32_t>(scheduled_functions.size());
+    scheduled_functions.push_back(func);
     for (const auto& i : dates) {
         // Put the scheduled function onto the heap with a reference to the function and the strategy object to call it
         auto toInsertBefore = std::find_if(heap_eventlist.begin(), heap_eventlist.end(), first_date_greater(i));
         // If no object is found with a later date, the object is put on the end of the heap list
-        heap_eventlist.insert(toInsertBefore, std::make_unique<events::ScheduledEvent<Strategy>>(func, this, i));
+        heap_eventlist.insert(toInsertBefore, std::make_unique<events::ScheduledEvent<Strategy>>(func, this, i, schedule_id));
+    }
+}
+
+// Schedules the pipeline, which runs ahead of any function scheduled at the open after it
+void Strategy::attach_pipeline(Pipeline p_pipeline) {
+    if (pipeline) { throw std::runtime_error("A pipeline is already attached to the strategy!"); }
+    pipeline = std::make_unique<Pipeline>(std::move(p_pipeline));
+    schedule_function([](Strategy* x) { x->pipeline_output(); }, date_rules.every_day(), TimeRules::market_open());
+}
+
+// The output is kept until the day changes, so asking for it again during the day costs nothing
+const PipelineOutput& Strategy::pipeline_output() {
+    if (!pipeline) { throw std::runtime_error("No pipeline is attached to the strategy!"); }
+    const int day = current_time.year() * 10000 + current_time.month() * 100 + current_time.day();
+    if (day != pipeline_day) {
+        pipeline_results = pipeline->run(*data, symbol_list);
+        pipeline_day = day;
     }
+    return pipeline_results;
+}
+
+// Looks the function up by its number in the schedule
+std::unique_ptr<events::Event> Strategy::scheduled_event(uint32_t schedule_id, const BloombergLP::blpapi::Datetime &when) {
+    if (schedule_id >= scheduled_functions.size()) {
+        throw std::runtime_error("Checkpoint refers to a function which has not been scheduled!");
+    }
+    return std::make_unique<events::ScheduledEvent<Strategy>>(scheduled_functions[schedule_id], this, when, schedule_id);
+}
+
+// Adds the day the intraday stream has reached after the base state
+void Strategy::write_checkpoint(checkpoint::Writer &writer) {
+    BaseStrategy::write_checkpoint(writer);
+    writer.put<uint8_t>(intraday_data && intraday_data->hasLoadedDay());
+    if (intraday_data && intraday_data->hasLoadedDay()) { writer.put(intraday_data->loadedDay()); }
+}
+
+// Picks the intraday stream back up from the checkpointed day
+void Strategy::read_checkpoint(checkpoint::Reader &reader) {
+    BaseStrategy::read_checkpoint(reader);
+    if (reader.get<uint8_t>()) {
+        BloombergLP::blpapi::Datetime loaded_day = reader.get_datetime();
+        if (intraday_data) { intraday_data->resumeStream(symbol_list, loaded_day, end_date); }
+    }
+}
+
+// The series starts a week before the start, so the benchmark has a level at the first market event even if it did
+// not trade on that day
+std::vector<std::pair<BloombergLP::blpapi::Datetime, double>> Strategy::benchmark_series(const std::string &symbol) {
+    return data->price_series(symbol, date_funcs::add_seconds(start_date, -7 * 24 * 60 * 60), end_date);
 }
 
 // Turns on Slack messaging at end of algo run
@@ -191,48 +592,76 @@ LiveStrategy::LiveStrategy(const std::vector<std::string> &p_symbol_list,
                            const std::string& p_saveFileLocation) :
         BaseStrategy(p_symbol_list, p_initial_capital, p_start_date, p_end_date, p_saveFileLocation),
         mtx(PTHREAD_MUTEX_INITIALIZER),
+        cond(PTHREAD_COND_INITIALIZER),
         data(std::make_shared<HistoricalDataManager>(&current_time)),
+        clock(std::make_unique<WallClock>()),
         execution_handler(&stack_eventqueue, &heap_eventlist, data, &portfolio),
-        live_data(std::make_unique<RealTimeDataRetriever>(&mtx)) { }
+        live_data(std::make_unique<RealTimeDataRetriever>(&mtx, &cond)) {
 
-// Runs the live strategy by simply continually updating the current time, checking if the object in the front of
-// the event heap has a datetime less than or equal to the current time, and if so, interpreting that event. Once
-// the event is finished, the first event is popped off and the loop continues.
+    // Price orders off the live quotes instead of history calls
+    execution_handler.use_quotes(&live_data->quotes(), &mtx);
+    // Ticks come in far more often than minutes, so they are gathered into minute periods
+    analytics.set_periods(252 * 390, 60);
+}
+
+// Runs the live strategy by updating the current time, checking if the object in the front of the event heap has
+// a datetime less than or equal to the current time, and if so, interpreting that event. Once the event is finished,
+// the first event is popped off and the loop continues. When nothing is ready, rather than spinning on the clock,
+// the thread waits on the condition variable until either the data feed signals new ticks or the next event on the
+// HEAP (or the end date) comes due.
 void LiveStrategy::run() {
 
-    // Runs the subscription with Bloomberg realtime data (already in a separate thread)
-    live_data->runSubscription(symbol_list);
+    // Runs the subscription with Bloomberg realtime data (already in a separate thread), or starts the replay of
+    // the recorded ticks on the clock simulating their time
+    if (replay_file.empty()) {
+        live_data->runSubscription(symbol_list, subscription_fields);
+    } else {
+        auto replay_clock = std::make_unique<ReplayClock>(live_data->loadReplay(symbol_list, replay_file), replay_speed);
+        live_data->runReplay(replay_clock.get());
+        clock = std::move(replay_clock);
+    }
+
+    // Identify the strategy before it changes any of its context
+    fingerprint();
 
     // Sets the start date and current time to the current DateTime
-    BloombergLP::blpapi::Datetime initial = date_funcs::get_now();
+    BloombergLP::blpapi::Datetime initial = clock->now();
     running = true;
-    start_date = initial;
-    portfolio.reset_portfolio(initial_capital, initial);
-    // Load in data from the save state if necessary
-    if (!saveFileLocation.empty()) { load_state(saveFileLocation); }
-
-    // The datetime incrementing loop which continuously updates the current time
-    for (current_time = initial; running && date_funcs::is_greater(end_date, current_time); current_time = date_funcs::get_now()) {
-
-        // When there are new market events, put them into the heap
-        if (!live_data->buffer_queue.empty()) {
-            pthread_mutex_lock(&mtx);
-
-            // Pulls all the data from the queue in the live data feed into the event HEAP
-            while (!live_data->buffer_queue.empty()) {
-                // Get the first-in market event from the buffer queue
-                std::unique_ptr<events::Event> new_event = std::move(live_data->buffer_queue.front());
-                live_data->buffer_queue.pop();
-
-                // Put the scheduled function onto the heap with a reference to the function and the strategy object to call it
-                auto toInsertBefore = std::find_if(heap_eventlist.begin(), heap_eventlist.end(), first_date_greater(new_event->datetime));
-                // If no object is found with a later date, the object is put on the end of the heap list
-                heap_eventlist.insert(toInsertBefore, std::move(new_event));
-            }
+    if (restored) {
+        // Continuing from a checkpoint after a restart, so keep its portfolio. Scheduled functions which came due
+        // while the strategy was down are dropped rather than all run at once.
+        heap_eventlist.remove_if([&initial](const std::unique_ptr<events::Event>& event) {
+            return date_funcs::is_greater(initial, event->datetime); });
+    } else {
+        start_date = initial;
+        portfolio.reset_portfolio(initial_capital, initial);
+        // Load in data from the save state if necessary
+        if (!saveFileLocation.empty()) { load_state(saveFileLocation); }
+        analytics.update(initial, portfolio.current_holdings[portfolio_fields::TOTAL_HOLDINGS], 0);
+    }
 
-            // Once the buffer queue is empty, unlock the mutex
-            pthread_mutex_unlock(&mtx);
-        }
+    // The event loop holds the mutex whenever it is not processing an event, so the data feed can only write into
+    // the buffer queue while an event is being processed or while this thread is asleep on the condition variable.
+    current_time = initial;
+    // Throughput and latency of the market events processed, for the report at the end of the run. Only the
+    // latencies of the most recent market events are kept, in a ring, so a long session holds a fixed amount.
+    const size_t latency_window = 1u << 16;
+    std::vector<double> latencies;
+    size_t latency_next = 0;
+    double max_latency = 0;
+    unsigned long ticks = 0, market_events = 0;
+    std::chrono::steady_clock::time_point first_tick, last_tick;
+    pthread_mutex_lock(&mtx);
+    while (running && !stop_requested && date_funcs::is_greater(end_date, current_time)) {
+
+        // Pull everything the feed has received into the ordered tick list
+        drain_feed();
+
+        // Whichever of the HEAP and the tick list has the earlier front event is next in line. On a tie the HEAP
+        // goes first, so scheduled functions run before ticks with the same timestamp.
+        bool next_is_tick = !tick_eventlist.empty() && (heap_eventlist.empty() ||
+                date_funcs::is_greater(heap_eventlist.front()->datetime, tick_eventlist.begin()->first));
+        bool has_next = next_is_tick || !heap_eventlist.empty();
 
         // The event object to process
         std::unique_ptr<events::Event> event = nullptr;
@@ -242,57 +671,125 @@ void LiveStrategy::run() {
             // Grab the first event on the stack and remove it from the queue
             event = std::move(stack_eventqueue.front());
             stack_eventqueue.pop();
-        } else {
-            // If there is not event on the heap, keep updating the time and looking for new MarketEvents
-            if (heap_eventlist.empty()) {
-                continue;
-            } else {
-                // Compare the current date time to the date of the event on the front of the HEAP
-                if (date_funcs::is_greater(current_time, heap_eventlist.front()->datetime)) {
-                    event = std::move(heap_eventlist.front());
-                    heap_eventlist.pop_front();
-                } else {
-                    continue;
-                }
-            }
+        } else if (next_is_tick && date_funcs::is_greater(current_time, tick_eventlist.begin()->first)) {
+            // The earliest tick is due, so take it off
+            event = std::move(tick_eventlist.begin()->second);
+            tick_eventlist.erase(tick_eventlist.begin());
+        } else if (!next_is_tick && has_next && date_funcs::is_greater(current_time, heap_eventlist.front()->datetime)) {
+            // The front of the HEAP is due, so take it off
+            event = std::move(heap_eventlist.front());
+            heap_eventlist.pop_front();
         }
 
-        // Now downcast the event and perform whatever function it requires
-        if (event->type == "MARKET") {
-            events::MarketEvent event_market = *dynamic_cast<events::MarketEvent *>(event.release());
-            // Pass the market event into the portfolio to update holdings
-            portfolio.update_market(event_market);
+        // Nothing is ready to run, so sleep until the data feed signals or the clock says the next event is due.
+        // The mutex is released while waiting, so no signal from the feed is missed.
+        if (!event) {
+            const BloombergLP::blpapi::Datetime& next = next_is_tick ? tick_eventlist.begin()->first :
+                    has_next ? heap_eventlist.front()->datetime : end_date;
+            const BloombergLP::blpapi::Datetime& wake = date_funcs::is_greater(end_date, next) ? next : end_date;
+            timespec deadline = clock->deadline(wake);
+            pthread_cond_timedwait(&cond, &mtx, &deadline);
+            current_time = clock->now();
+            continue;
+        }
 
-        } else if (event->type == "SIGNAL") {
-            events::SignalEvent event_signal = *dynamic_cast<events::SignalEvent *>(event.release());
-            // Pass the signal event into the execution handler to generate orders
-            execution_handler.process_signal(event_signal);
+        // Let the data feed write into the buffer while the event is processed
+        pthread_mutex_unlock(&mtx);
+        BT_SAMPLE_QUEUES(stack_eventqueue, heap_eventlist);
+
+        // Now downcast the event and perform whatever function it requires, timing it when instrumented
+        {
+            BT_PROBE_EVENT(event->type);
+            if (event->type == "MARKET") {
+                events::MarketEvent& event_market = *dynamic_cast<events::MarketEvent *>(event.get());
+                // Pass the market event into the portfolio to update holdings
+                portfolio.update_market(event_market);
+                update_analytics(event_market);
+                for (auto& indicators : indicator_sets) { indicators->update(event_market); }
+                // Time from the data arriving to it being reflected in the holdings
+                last_tick = std::chrono::steady_clock::now();
+                if (ticks == 0) { first_tick = last_tick; }
+                ticks += event_market.symbols.size();
+                market_events++;
+                const double latency = std::chrono::duration<double, std::micro>(last_tick - event_market.received).count();
+                if (latencies.size() < latency_window) { latencies.push_back(latency); }
+                else { latencies[latency_next] = latency; }
+                latency_next = (latency_next + 1) % latency_window;
+                max_latency = std::max(max_latency, latency);
+
+            } else if (event->type == "SIGNAL") {
+                events::SignalEvent& event_signal = *dynamic_cast<events::SignalEvent *>(event.get());
+                // Pass the signal event into the execution handler to generate orders
+                execution_handler.process_signal(event_signal);
+
+            } else if (event->type == "ORDER") {
+                events::OrderEvent& event_order = *dynamic_cast<events::OrderEvent *>(event.get());
+                // Pass the order event into the execution handler to generate a fill
+                execution_handler.process_order(event_order);
+
+            } else if (event->type == "REBALANCE") {
+                // Pass the rebalance into the execution handler to fill all of its orders at once
+                execution_handler.process_rebalance(*dynamic_cast<events::RebalanceEvent *>(event.get()));
+
+            } else if (event->type == "FILLS") {
+                events::FillsEvent& event_fills = *dynamic_cast<events::FillsEvent *>(event.get());
+                // Pass the fills into the portfolio to update holdings once for all of them
+                portfolio.update_fills(event_fills);
+                for (const events::FillEvent& event_fill : event_fills.fills) {
+                    analytics.update_fill(event_fill);
+                    record_fill(event_fill);
+                }
 
-        } else if (event->type == "ORDER") {
-            events::OrderEvent event_order = *dynamic_cast<events::OrderEvent *>(event.release());
-            // Pass the order event into the execution handler to generate a fill
-            execution_handler.process_order(event_order);
+            } else if (event->type == "FILL") {
+                events::FillEvent& event_fill = *dynamic_cast<events::FillEvent *>(event.get());
+                // Pass the fill event into the portfolio to update holdings
+                portfolio.update_fill(event_fill);
+                analytics.update_fill(event_fill);
+                record_fill(event_fill);
+
+            } else if (event->type == "SCHEDULED") {
+                auto& event_scheduled = *dynamic_cast<events::ScheduledEvent<LiveStrategy> *>(event.get());
+                // Run the function referenced to in the schedule event
+                BT_PROBE_SCHEDULED(event_scheduled.schedule_id);
+                event_scheduled.run();
+            }  else if (event->type == "STOP") {
+                event->what();
+                running = false;
+            }
+        }
 
-        } else if (event->type == "FILL") {
-            events::FillEvent event_fill = *dynamic_cast<events::FillEvent *>(event.release());
-            // Pass the fill event into the portfolio to update holdings
-            portfolio.update_fill(event_fill);
+        // Write the periodic checkpoint if one is due
+        count_checkpoint();
 
-        } else if (event->type == "SCHEDULED") {
-            events::ScheduledEvent<LiveStrategy> event_scheduled = *dynamic_cast<events::ScheduledEvent<LiveStrategy>*>(event.release());
-            // Run the function referenced to in the schedule event
-            event_scheduled.run();
-        }  else if (event->type == "STOP") {
-            event->what();
-            running = false;
-        }
+        // Take the mutex back before looking at the buffer queue again
+        pthread_mutex_lock(&mtx);
+        current_time = clock->now();
     }
-
-    // Print out performance
+    unsigned long conflated = live_data->conflatedTicks();
+    pthread_mutex_unlock(&mtx);
+
+    // Print out the capacity of the feed: the sustained rate between the first and last market events, and the
+    // distribution of the time the most recent market events waited between arriving and being processed
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        double seconds = std::chrono::duration<double>(last_tick - first_tick).count();
+        std::stringstream report;
+        report << ticks << " ticks in " << market_events << " market events over " << seconds << "s";
+        if (seconds > 0) { report << " (" << static_cast<unsigned long>(ticks / seconds) << " ticks/sec)"; }
+        report << ". Latency p50 " << latencies[latencies.size() / 2] << "us, p99 "
+               << latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)] << "us over the last "
+               << latencies.size() << " market events, max " << max_latency << "us.";
+        log(report.str());
+    }
+    if (conflated > 0) { log(std::to_string(conflated) + " ticks conflated."); }
     std::string mess = std::string("Backtest finished. Total return: ") + std::to_string(portfolio.current_holdings[portfolio_fields::EQUITY_CURVE] * 100) + "%";
+    if (results) { results->flush(); }
     if (sendStatusMessage) { message(mess); }
     if (!saveFileLocation.empty()) { load_state(saveFileLocation); }
+    logging::flush();
     std::cout << mess << std::endl;
+    report(std::cout);
+    BT_INSTRUMENTATION_REPORT(std::cout, instrumentationFileLocation);
 }
 
 // Schedules a function in a LiveStrategy event loop. Is the exact same function as the normal Strategy's.
@@ -300,15 +797,101 @@ void LiveStrategy::schedule_function(std::function<void(LiveStrategy *)> func, c
                                      const TimeRules &timeRules) {
     // Get the datetimes at which the functions should be scheduled
     std::vector<BloombergLP::blpapi::Datetime> dates = dateRules.get_date_times(timeRules);
+    // Number the function so its events can be checkpointed
+    auto schedule_id = static_cast<uint32_t>(scheduled_functions.size());
+    scheduled_functions.push_back(func);
     for (const auto& i : dates) {
         // Only schedule for dates after the start
         if (date_funcs::is_greater(start_date, i)) { continue; }
         // Put the scheduled function onto the heap with a reference to the function and the strategy object to call it
         auto toInsertBefore = std::find_if(heap_eventlist.begin(), heap_eventlist.end(), first_date_greater(i));
         // If no object is found with a later date, the object is put on the end of the heap list
-        heap_eventlist.insert(toInsertBefore, std::make_unique<events::ScheduledEvent<LiveStrategy>>(func, this, i));
+        heap_eventlist.insert(toInsertBefore, std::make_unique<events::ScheduledEvent<LiveStrategy>>(func, this, i, schedule_id));
+    }
+}
+
+// Looks the function up by its number in the schedule
+std::unique_ptr<events::Event> LiveStrategy::scheduled_event(uint32_t schedule_id,
+                                                             const BloombergLP::blpapi::Datetime &when) {
+    if (schedule_id >= scheduled_functions.size()) {
+        throw std::runtime_error("Checkpoint refers to a function which has not been scheduled!");
+    }
+    return std::make_unique<events::ScheduledEvent<LiveStrategy>>(scheduled_functions[schedule_id], this, when, schedule_id);
+}
+
+// The ticks are written after the base state in their queued order. Only this thread touches the tick list, so it
+// needs no lock; before_checkpoint has already drained the feed into it. Ticks arriving while the checkpoint is being
+// written are after its cut, and go into the next one.
+void LiveStrategy::write_checkpoint(checkpoint::Writer &writer) {
+    BaseStrategy::write_checkpoint(writer);
+    writer.put<uint64_t>(tick_eventlist.size());
+    for (const auto& tick : tick_eventlist) { checkpoint::put_event(writer, *tick.second); }
+}
+
+// Reads the ticks back in the order they were queued, so ticks with equal timestamps keep their order
+void LiveStrategy::read_checkpoint(checkpoint::Reader &reader) {
+    BaseStrategy::read_checkpoint(reader);
+    tick_eventlist.clear();
+    auto num_ticks = reader.get_count(sizeof(uint8_t));
+    for (uint64_t i = 0; i < num_ticks; ++i) {
+        std::unique_ptr<events::Event> tick = checkpoint::get_event(reader,
+                [this](uint32_t schedule_id, const BloombergLP::blpapi::Datetime& when) {
+                    return scheduled_event(schedule_id, when); });
+        const BloombergLP::blpapi::Datetime when = tick->datetime;
+        tick_eventlist.emplace_hint(tick_eventlist.end(), when, std::move(tick));
     }
 }
 
+// Takes the mutex only for the drain, so the feed is not held up while the checkpoint is written
+void LiveStrategy::before_checkpoint() {
+    pthread_mutex_lock(&mtx);
+    drain_feed();
+    pthread_mutex_unlock(&mtx);
+}
+
+// Ticks almost always arrive in timestamp order, so hinting at the end makes each insertion constant time; a late
+// tick falls back to a logarithmic insertion. Ticks with equal timestamps keep their arrival order. When conflating,
+// whatever prices have come in since the last drain are batched up first.
+void LiveStrategy::drain_feed() {
+    live_data->flushConflated();
+    while (!live_data->buffer_queue.empty()) {
+        std::unique_ptr<events::Event> new_event = std::move(live_data->buffer_queue.front());
+        live_data->buffer_queue.pop();
+        const BloombergLP::blpapi::Datetime when = new_event->datetime;
+        tick_eventlist.emplace_hint(tick_eventlist.end(), when, std::move(new_event));
+    }
+}
+
+// Wakes the event loop to see the request, whether it is asleep or about to check the loop condition
+void LiveStrategy::stop() {
+    pthread_mutex_lock(&mtx);
+    stop_requested = true;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mtx);
+}
+
+// Passes the conflation setting through to the live data feed
+void LiveStrategy::conflate_ticks(bool conflate) { live_data->setConflation(conflate); }
+
+// Stores the fields to subscribe to when the strategy is run
+void LiveStrategy::subscribe_fields(const std::vector<std::string>& fields) { subscription_fields = fields; }
+
+// Stores the replay file and speed, the clock is only built when the run begins so paced time starts then
+void LiveStrategy::replay(const std::string& filepath, double speed) {
+    if (speed < 0) { throw std::runtime_error("Replay speed cannot be negative!"); }
+    replay_file = filepath;
+    replay_speed = speed;
+}
+
+// Copies the quote out of the live quote book under the mutex
+Quote LiveStrategy::quote(const std::string& symbol) {
+    Quote toReturn;
+    pthread_mutex_lock(&mtx);
+    long index = live_data->quotes().index_of(symbol);
+    if (index >= 0) { toReturn = live_data->quotes().quotes[index]; }
+    pthread_mutex_unlock(&mtx);
+    return toReturn;
+}
+
 // Scheduled function check
 void LiveStrategy::check() { std::cout << "Function ran on " << current_time << std::endl; }
\ No newline at end of file
@@ -0,0 +1,143 @@
+// Include corresponding header
+#include "strategyhost.hpp"
+// STL includes
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+// Generates the market straight away, with the bar length setting the strategies' periods per year
+StrategyHost::StrategyHost(std::vector<std::string> p_symbols,
+                           const BloombergLP::blpapi::Datetime &p_start,
+                           const BloombergLP::blpapi::Datetime &p_end,
+                           const SyntheticMarket &p_market) :
+        symbol_list(std::move(p_symbols)),
+        current_time(p_start),
+        shared_data(std::make_shared<SyntheticDataManager>(&current_time, p_market)),
+        periods(p_market.bar_minutes ? 252.0 * 390 / p_market.bar_minutes : 252) {
+    dynamic_cast<SyntheticDataManager*>(shared_data.get())->fillHistory(symbol_list, p_start, p_end, &market_events);
+}
+
+// Pulls the closes straight away
+StrategyHost::StrategyHost(std::vector<std::string> p_symbols,
+                           const BloombergLP::blpapi::Datetime &p_start,
+                           const BloombergLP::blpapi::Datetime &p_end) :
+        symbol_list(std::move(p_symbols)),
+        current_time(p_start),
+        shared_data(std::make_shared<HistoricalDataManager>(&current_time)) {
+    dynamic_cast<HistoricalDataManager*>(shared_data.get())->fillHistory(symbol_list, p_start, p_end, &market_events);
+}
+
+// A strategy on a data manager of its own would read history at the wrong time, and one trading symbols the host
+// does not price would never have them valued
+void StrategyHost::adopt(std::unique_ptr<Strategy> strategy) {
+    if (strategy->data != shared_data) {
+        throw std::runtime_error("Strategy is not built on the host's data manager!");
+    }
+    for (const std::string& symbol : strategy->symbol_list) {
+        if (std::find(symbol_list.begin(), symbol_list.end(), symbol) == symbol_list.end()) {
+            throw std::runtime_error(symbol + " is not one of the host's symbols!");
+        }
+    }
+    if (strategy->checkpoint_interval != 0) {
+        throw std::runtime_error("Strategies run by a host cannot be checkpointed!");
+    }
+    strategy->analytics.set_periods(periods);
+    strategies.push_back(std::move(strategy));
+}
+
+// Strategies which have stopped have nothing more to process
+bool StrategyHost::next_time(std::list<std::unique_ptr<events::Event>>::iterator market,
+                             BloombergLP::blpapi::Datetime &time) const {
+    bool found = false;
+    if (market != market_events.end()) {
+        time = (*market)->datetime;
+        found = true;
+    }
+    for (const auto& strategy : strategies) {
+        if (!strategy->running || strategy->heap_eventlist.empty()) { continue; }
+        const BloombergLP::blpapi::Datetime& front = strategy->heap_eventlist.front()->datetime;
+        if (!found || date_funcs::is_greater(time, front)) {
+            time = front;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// The strategies are dealt out to the threads once, thread i taking every strategy whose position is i modulo the
+// number of threads, and the threads are kept for the whole run rather than started at every time: the calling
+// thread wakes the others for each time, takes its own share, and waits for the rest to finish theirs. The first
+// exception thrown by any strategy stops the run and is rethrown here.
+void StrategyHost::run(unsigned int threads) {
+#ifdef BACKTESTER_INSTRUMENTATION
+    threads = 1;
+#endif
+    threads = std::max(1u, std::min(threads, static_cast<unsigned int>(strategies.size())));
+    for (auto& strategy : strategies) { strategy->start_run(); }
+
+    auto market = market_events.begin();
+    BloombergLP::blpapi::Datetime time;
+    events::MarketEvent* current = nullptr;
+    std::mutex mtx;
+    std::condition_variable wake, done;
+    std::exception_ptr failure;
+    unsigned long generation = 0;
+    unsigned int working = 0;
+    bool finished = false;
+    auto step = [&](size_t first) {
+        try {
+            for (size_t i = first; i < strategies.size(); i += threads) { strategies[i]->step(current, time); }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!failure) { failure = std::current_exception(); }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int thread = 1; thread < threads; ++thread) {
+        workers.emplace_back([&, thread]() {
+            unsigned long seen = 0;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    wake.wait(lock, [&]() { return finished || generation != seen; });
+                    if (finished) { return; }
+                    seen = generation;
+                }
+                step(thread);
+                std::lock_guard<std::mutex> lock(mtx);
+                if (--working == 0) { done.notify_one(); }
+            }
+        });
+    }
+
+    while (!failure && next_time(market, time)) {
+        // Move the shared clock, and find whether the next market event is at this time
+        current_time = time;
+        const bool at_market = market != market_events.end() && !date_funcs::is_greater((*market)->datetime, time);
+        current = at_market ? dynamic_cast<events::MarketEvent*>(market->get()) : nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            working = threads - 1;
+            generation++;
+        }
+        wake.notify_all();
+        step(0);
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            done.wait(lock, [&]() { return working == 0; });
+        }
+        if (at_market) { ++market; }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        finished = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) { worker.join(); }
+    if (failure) { std::rethrow_exception(failure); }
+    for (auto& strategy : strategies) { strategy->finish_run(); }
+}
@@ -0,0 +1,85 @@
+// Google Test include
+#include <gtest/gtest.h>
+// STL includes
+#include <cmath>
+#include <vector>
+// Include custom classes
+#include "analytics.hpp"
+
+// MARK: Helpers
+// Mean of the values, worked out in one pass over them
+static double mean_of(const std::vector<double>& values) {
+    double sum = 0;
+    for (double value : values) { sum += value; }
+    return sum / values.size();
+}
+// Sample covariance of two series of the same length, worked out from their means in a second pass
+static double covariance_of(const std::vector<double>& first, const std::vector<double>& second) {
+    const double first_mean = mean_of(first), second_mean = mean_of(second);
+    double sum = 0;
+    for (size_t i = 0; i < first.size(); ++i) { sum += (first[i] - first_mean) * (second[i] - second_mean); }
+    return sum / (first.size() - 1);
+}
+
+// MARK: Tests
+// Checks the streaming statistics against ones worked out by hand
+TEST(AnalyticsFixture, streaming_statistics) { // NOLINT(cert-err58-cpp)
+    Analytics analytics(252, 0, 2);
+    const double equities[] = {100, 110, 99, 121};
+    for (int day = 0; day < 4; ++day) {
+        analytics.update(BloombergLP::blpapi::Datetime(2010, 1, 4 + day, 16, 0, 0), equities[day], 50);
+    }
+    analytics.update_fill(events::FillEvent("IBM US EQUITY", 10, 100, 0, 0, BloombergLP::blpapi::Datetime(2010, 1, 4, 16, 0, 0)));
+    analytics.update_fill(events::FillEvent("IBM US EQUITY", -10, -120, 0, 0, BloombergLP::blpapi::Datetime(2010, 1, 5, 16, 0, 0)));
+
+    // Returns of +10%, -10% and +22.2%, of which only the second is below the risk free rate of 0
+    const std::vector<double> returns = {0.1, -0.1, 121.0 / 99 - 1};
+    const double deviation = std::sqrt(covariance_of(returns, returns));
+    const std::vector<double> last_two(returns.begin() + 1, returns.end());
+
+    PerformanceStats stats = analytics.stats();
+    EXPECT_EQ(stats.periods, 3u);
+    EXPECT_NEAR(stats.total_return, 0.21, 1e-12);
+    EXPECT_NEAR(stats.volatility, deviation * std::sqrt(252), 1e-12);
+    EXPECT_NEAR(stats.sharpe, mean_of(returns) / deviation * std::sqrt(252), 1e-9);
+    EXPECT_NEAR(stats.sortino, mean_of(returns) / std::sqrt(0.01 / 3) * std::sqrt(252), 1e-9);
+    EXPECT_NEAR(stats.rolling_volatility, std::sqrt(covariance_of(last_two, last_two)) * std::sqrt(252), 1e-9);
+    EXPECT_NEAR(stats.max_drawdown, 0.1, 1e-12);
+    EXPECT_EQ(stats.max_drawdown_periods, 1u);
+    EXPECT_NEAR(stats.current_drawdown, 0, 1e-12);
+    // 220 traded against an average equity of 110 over 3 periods, at 252 periods a year
+    EXPECT_NEAR(stats.turnover, 220.0 / 110 * 252 / 3, 1e-9);
+    EXPECT_NEAR(stats.exposure, (50.0 / 110 + 50.0 / 99 + 50.0 / 121) / 3, 1e-12);
+    EXPECT_NEAR(stats.current_exposure, 50.0 / 121, 1e-12);
+    EXPECT_EQ(stats.trades, 1u);
+    EXPECT_DOUBLE_EQ(stats.hit_rate, 1);
+    EXPECT_FALSE(stats.has_benchmark);
+}
+// Checks the statistics against a benchmark against ones worked out by hand
+TEST(AnalyticsFixture, benchmark_statistics) { // NOLINT(cert-err58-cpp)
+    Analytics analytics;
+    const double equities[] = {100, 110, 99, 121, 115};
+    const double benchmarks[] = {200, 210, 200, 220, 231};
+    for (int day = 0; day < 5; ++day) {
+        analytics.update(BloombergLP::blpapi::Datetime(2010, 1, 4 + day, 16, 0, 0), equities[day], 100,
+                         benchmarks[day]);
+    }
+
+    std::vector<double> returns, benchmark_returns, active;
+    for (int day = 1; day < 5; ++day) {
+        returns.push_back(equities[day] / equities[day - 1] - 1);
+        benchmark_returns.push_back(benchmarks[day] / benchmarks[day - 1] - 1);
+        active.push_back(returns.back() - benchmark_returns.back());
+    }
+    const double beta = covariance_of(returns, benchmark_returns) / covariance_of(benchmark_returns, benchmark_returns);
+    const double tracking_error = std::sqrt(covariance_of(active, active)) * std::sqrt(252);
+
+    PerformanceStats stats = analytics.stats();
+    ASSERT_TRUE(stats.has_benchmark);
+    EXPECT_NEAR(stats.beta, beta, 1e-9);
+    EXPECT_NEAR(stats.alpha, (mean_of(returns) - beta * mean_of(benchmark_returns)) * 252, 1e-9);
+    EXPECT_NEAR(stats.correlation, covariance_of(returns, benchmark_returns) /
+            std::sqrt(covariance_of(returns, returns) * covariance_of(benchmark_returns, benchmark_returns)), 1e-9);
+    EXPECT_NEAR(stats.tracking_error, tracking_error, 1e-9);
+    EXPECT_NEAR(stats.information_ratio, mean_of(active) * 252 / tracking_error, 1e-9);
+}
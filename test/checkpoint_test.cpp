@@ -0,0 +1,19 @@
+// Google Test include
+#include <gtest/gtest.h>
+// STL includes
+#include <cstdio>
+#include <stdexcept>
+// Include custom classes
+#include "checkpoint.hpp"
+
+// MARK: Tests
+// Checks that a corrupt length is rejected before anything is allocated for it
+TEST(CheckpointFixture, rejects_oversized_count) { // NOLINT(cert-err58-cpp)
+    checkpoint::Writer writer;
+    writer.put<uint64_t>(uint64_t(1) << 60);
+    writer.put<double>(1);
+    writer.save("oversized_checkpoint.bin");
+    checkpoint::Reader reader("oversized_checkpoint.bin");
+    EXPECT_THROW(reader.get_array<double>(), std::runtime_error);
+    std::remove("oversized_checkpoint.bin");
+}
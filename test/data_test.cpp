@@ -4,9 +4,17 @@
 
 // Google test include
 #include <gtest/gtest.h>
+// STL includes
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <thread>
 // Custom library includes
 #include "constants.hpp"
 #include "data.hpp"
+#include "replay.hpp"
 
 // Unit testing class for the Data Managers.
 
@@ -23,6 +31,23 @@ public:
     ~HistoricalDataManagerFixture() override = default;
 };
 
+// Counts the history it fetches, to tell memoized history() calls apart from fetched ones
+class CountingDataManager : public SyntheticDataManager {
+public:
+    explicit CountingDataManager(BloombergLP::blpapi::Datetime* p_currentTime) : SyntheticDataManager(p_currentTime) {}
+    std::atomic<unsigned int> fetches{0};
+    // How long each fetch takes, as a stand-in for a round trip to Bloomberg
+    std::chrono::milliseconds delay{0};
+protected:
+    std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> fetch_history(
+            const std::vector<std::string>& symbols, const std::vector<std::string>& fields,
+            unsigned int timeunitsback, const std::string& frequency) override {
+        fetches++;
+        std::this_thread::sleep_for(delay);
+        return SyntheticDataManager::fetch_history(symbols, fields, timeunitsback, frequency);
+    }
+};
+
 // MARK: TESTS
 // Makes sure the HistoricalDataManager fills the empty Event HEAP with MarketEvents
 TEST(HistoricalDataManagerFixture, builds_market_events) { // NOLINT(cert-err58-cpp)
@@ -51,7 +76,7 @@ TEST(HistoricalDataManagerFixture, history) { // NOLINT(cert-err58-cpp)
     HistoricalDataManager hdm(&current_time);
 
     // Now try pulling the historical data
-    std::unique_ptr<std::unordered_map<std::string, SymbolHistoricalData>> data;
+    std::shared_ptr<const std::unordered_map<std::string, SymbolHistoricalData>> data;
     EXPECT_NO_THROW(data = hdm.history({"IBM US EQUITY", "GOOG US EQUITY"}, {"PX_LAST"}, 20, "DAILY")); // NOLINT(cppcoreguidelines-avoid-goto)
 
 //    // Check the data
@@ -61,3 +86,207 @@ TEST(HistoricalDataManagerFixture, history) { // NOLINT(cert-err58-cpp)
 //        ++i;
 //    }
 }
+
+// Checks that repeated history requests at the same time are memoized, and fetched again once the clock moves
+TEST(HistoricalDataManagerFixture, memoized_history) { // NOLINT(cert-err58-cpp)
+    BloombergLP::blpapi::Datetime current_time(2017, 6, 1, 0, 0, 0);
+    CountingDataManager data(&current_time);
+    std::list<std::unique_ptr<events::Event>> heap;
+    data.fillHistory({"SYN00000 US EQUITY", "SYN00001 US EQUITY"}, BloombergLP::blpapi::Datetime(2017, 1, 3, 0, 0, 0),
+                     BloombergLP::blpapi::Datetime(2018, 1, 2, 0, 0, 0), &heap);
+
+    // The same request at the same time is fetched once, and every call shares the result
+    auto first = data.history({"SYN00000 US EQUITY", "SYN00001 US EQUITY"}, {"PX_LAST"}, 10, "DAILY");
+    auto second = data.history({"SYN00000 US EQUITY", "SYN00001 US EQUITY"}, {"PX_LAST"}, 10, "DAILY");
+    EXPECT_EQ(data.fetches, 1u);
+    EXPECT_EQ(first.get(), second.get());
+
+    // A different request, or the same one later, is fetched for itself
+    EXPECT_EQ(data.history({"SYN00000 US EQUITY"}, {"PX_LAST"}, 10, "DAILY")->size(), 1u);
+    EXPECT_LT(data.history({"SYN00000 US EQUITY"}, {"PX_LAST"}, 3, "DAILY")->at("SYN00000 US EQUITY").data.size(),
+              first->at("SYN00000 US EQUITY").data.size());
+    EXPECT_EQ(data.fetches, 3u);
+    current_time = BloombergLP::blpapi::Datetime(2017, 7, 3, 0, 0, 0);
+    auto later = data.history({"SYN00000 US EQUITY", "SYN00001 US EQUITY"}, {"PX_LAST"}, 10, "DAILY");
+    EXPECT_EQ(data.fetches, 4u);
+    EXPECT_NE(later->at("SYN00000 US EQUITY").data.rbegin()->second.at("PX_LAST"),
+              second->at("SYN00000 US EQUITY").data.rbegin()->second.at("PX_LAST"));
+
+    // Without memoization, every call fetches
+    data.memoize_history(false);
+    data.history({"SYN00000 US EQUITY", "SYN00001 US EQUITY"}, {"PX_LAST"}, 10, "DAILY");
+    data.history({"SYN00000 US EQUITY", "SYN00001 US EQUITY"}, {"PX_LAST"}, 10, "DAILY");
+    EXPECT_EQ(data.fetches, 6u);
+}
+// Checks that threads asking for the same history share one fetch, and that a memoized request is answered while
+// another is still being fetched
+TEST(HistoricalDataManagerFixture, memoized_history_threads) { // NOLINT(cert-err58-cpp)
+    BloombergLP::blpapi::Datetime current_time(2017, 6, 1, 0, 0, 0);
+    CountingDataManager data(&current_time);
+    std::list<std::unique_ptr<events::Event>> heap;
+    data.fillHistory({"SYN00000 US EQUITY", "SYN00001 US EQUITY"}, BloombergLP::blpapi::Datetime(2017, 1, 3, 0, 0, 0),
+                     BloombergLP::blpapi::Datetime(2018, 1, 2, 0, 0, 0), &heap);
+    data.delay = std::chrono::milliseconds(100);
+
+    std::vector<const void*> results(4);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&data, &results, i]() {
+            results[i] = data.history({"SYN00000 US EQUITY"}, {"PX_LAST"}, 10, "DAILY").get();
+        });
+    }
+    for (std::thread& thread : threads) { thread.join(); }
+    EXPECT_EQ(data.fetches, 1u);
+    for (const void* result : results) { EXPECT_EQ(result, results[0]); }
+
+    data.delay = std::chrono::milliseconds(1000);
+    std::atomic<bool> fetched{false};
+    std::thread slow([&data, &fetched]() {
+        data.history({"SYN00001 US EQUITY"}, {"PX_LAST"}, 10, "DAILY");
+        fetched = true;
+    });
+    while (data.fetches < 2) { std::this_thread::yield(); }
+    EXPECT_EQ(data.history({"SYN00000 US EQUITY"}, {"PX_LAST"}, 10, "DAILY").get(), results[0]);
+    EXPECT_FALSE(fetched);
+    slow.join();
+}
+
+// Checks that a panel holds the same values as the history maps, and fills the gaps between symbols' dates
+TEST(HistoricalDataManagerFixture, history_panel) { // NOLINT(cert-err58-cpp)
+    BloombergLP::blpapi::Datetime current_time(2017, 6, 1, 0, 0, 0);
+    SyntheticDataManager data(&current_time);
+    std::list<std::unique_ptr<events::Event>> heap;
+    const std::vector<std::string> symbols = {"SYN00000 US EQUITY", "SYN00001 US EQUITY"};
+    data.fillHistory(symbols, BloombergLP::blpapi::Datetime(2017, 1, 3, 0, 0, 0),
+                     BloombergLP::blpapi::Datetime(2018, 1, 2, 0, 0, 0), &heap);
+
+    auto maps = data.history(symbols, {"PX_LAST", "PX_OPEN"}, 10, "DAILY");
+    Panel panel = data.history_panel(symbols, {"PX_LAST", "PX_OPEN"}, 10, "DAILY");
+    ASSERT_EQ(panel.times.size(), maps->at(symbols[0]).data.size());
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        size_t time = 0;
+        for (auto& bar : maps->at(symbols[i]).data) {
+            EXPECT_EQ(panel.times[time], bar.first);
+            EXPECT_EQ(panel.at(panel.field_index("PX_LAST"), time, i), bar.second.at("PX_LAST"));
+            EXPECT_EQ(panel.at(panel.field_index("PX_OPEN"), time, i), bar.second.at("PX_OPEN"));
+            time++;
+        }
+    }
+    EXPECT_THROW(panel.field_index("PX_BID"), std::runtime_error); // NOLINT(cppcoreguidelines-avoid-goto)
+
+    // A field which is not generated is NaN throughout, however gaps are treated, as it is built from the maps
+    for (Panel::Gaps gaps : {Panel::FORWARD_FILL, Panel::LEAVE_NAN}) {
+        Panel dividends = data.history_panel(symbols, {"PX_LAST", "EQY_DVD_YLD"}, 10, "DAILY", gaps);
+        Panel from_maps = Panel::from_history(symbols, {"PX_LAST", "EQY_DVD_YLD"},
+                                              *data.history(symbols, {"PX_LAST", "EQY_DVD_YLD"}, 10, "DAILY"), gaps);
+        ASSERT_EQ(dividends.times, from_maps.times);
+        for (size_t time = 0; time < dividends.times.size(); ++time) {
+            for (size_t i = 0; i < symbols.size(); ++i) {
+                EXPECT_EQ(dividends.at(0, time, i), from_maps.at(0, time, i));
+                EXPECT_TRUE(std::isnan(dividends.at(1, time, i)) && std::isnan(from_maps.at(1, time, i)));
+            }
+        }
+    }
+
+    // The second symbol starts a day later and misses a day, which is filled or left as NaN
+    std::unordered_map<std::string, SymbolHistoricalData> history;
+    const BloombergLP::blpapi::Datetime day1(2017, 6, 1, 0, 0, 0), day2(2017, 6, 2, 0, 0, 0),
+            day3(2017, 6, 5, 0, 0, 0);
+    history["A"].data = {{day1, {{"PX_LAST", 1}}}, {day2, {{"PX_LAST", 2}}}, {day3, {{"PX_LAST", 3}}}};
+    history["B"].data = {{day2, {{"PX_LAST", 20}}}};
+    Panel filled = Panel::from_history({"A", "B"}, {"PX_LAST"}, history);
+    ASSERT_EQ(filled.times.size(), 3u);
+    EXPECT_TRUE(std::isnan(filled.at(0, 0, 1)));
+    EXPECT_EQ(filled.at(0, 2, 0), 3);
+    EXPECT_EQ(filled.at(0, 2, 1), 20);
+    Panel gaps = Panel::from_history({"A", "B"}, {"PX_LAST"}, history, Panel::LEAVE_NAN);
+    EXPECT_TRUE(std::isnan(gaps.at(0, 2, 1)));
+}
+// Checks that the MarketEvents cover the dates of every symbol, with symbols listing late left out until they list
+// and symbols without a price of their own at a date marked stale
+TEST(HistoricalDataManagerFixture, merges_calendars) { // NOLINT(cert-err58-cpp)
+    std::unordered_map<std::string, SymbolHistoricalData> history;
+    const BloombergLP::blpapi::Datetime day1(2017, 6, 1, 0, 0, 0), day2(2017, 6, 2, 0, 0, 0),
+            day3(2017, 6, 5, 0, 0, 0), day4(2017, 6, 6, 0, 0, 0);
+    history["A"].data = {{day1, {{"PX_LAST", 1}}}, {day2, {{"PX_LAST", 2}}}, {day3, {{"PX_OPEN", 3}}}};
+    history["B"].data = {{day3, {{"PX_LAST", 30}}}, {day4, {{"PX_LAST", 40}}}};
+    history["C"].data = {{day2, {{"PX_LAST", 200}}}};
+    std::list<std::unique_ptr<events::Event>> heap;
+    HistoricalDataManager::merge_market_events({"A", "B", "C", "D"}, history, &heap);
+
+    // The last day is only B's, and A has no last price on the third so carries its second day's forward
+    ASSERT_EQ(heap.size(), 4u);
+    std::vector<const events::MarketEvent*> market;
+    for (const auto& event : heap) { market.push_back(dynamic_cast<const events::MarketEvent*>(event.get())); }
+    EXPECT_EQ(market[0]->datetime, day1);
+    EXPECT_EQ(market[0]->symbols, std::vector<std::string>({"A"}));
+    EXPECT_EQ(market[1]->symbols, std::vector<std::string>({"A", "C"}));
+    EXPECT_EQ(market[2]->symbols, std::vector<std::string>({"A", "B", "C"}));
+    EXPECT_EQ(market[2]->data.at("A"), 2);
+    EXPECT_EQ(market[2]->data.at("C"), 200);
+    EXPECT_EQ(market[3]->datetime, day4);
+    EXPECT_EQ(market[3]->data.at("B"), 40);
+    EXPECT_EQ(market[3]->data.size(), 3u);
+
+    // C's data ends on the second day, so its price is stale from then on, as is A's wherever it has none
+    EXPECT_TRUE(market[0]->stale.empty());
+    EXPECT_TRUE(market[1]->stale.empty());
+    EXPECT_EQ(market[2]->stale, std::unordered_set<std::string>({"A", "C"}));
+    EXPECT_EQ(market[3]->stale, std::unordered_set<std::string>({"A", "C"}));
+    EXPECT_TRUE(market[3]->is_stale("C"));
+    EXPECT_FALSE(market[3]->is_stale("B"));
+}
+// Checks that a recorded tick file is played back in time order, with every trade queued as a MarketEvent at its
+// recorded time, quotes only updating the book, and a StopEvent after the last tick
+TEST(TickReplayerFixture, replays_in_order) { // NOLINT(cert-err58-cpp)
+    std::ofstream file("replay_test.csv");
+    file << "datetime,symbol,last,bid,ask,bid_size,ask_size,volume\n"
+         << "2019-01-31 09:30:01.500,IBM US EQUITY,134.5,,,,,\n"
+         << "2019-01-31 09:30:00.125,IBM US EQUITY,134.2,134.19,134.21,300,500,12000\n"
+         << "2019-01-31 09:30:01.000,AAPL US EQUITY,,166.1,166.2,,,\n"
+         << "2019-01-31 09:30:01.000,MSFT US EQUITY,105.1,,,,,\n"
+         << "2019-01-31 09:30:02.000,AAPL US EQUITY,166.15,,,,,\n";
+    file.close();
+
+    QuoteBook book;
+    book.reset({"IBM US EQUITY", "AAPL US EQUITY"});
+    pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    std::queue<std::unique_ptr<events::Event>> queue;
+    RealTimeDataHandler handler(&queue, &mtx, &cond, &book);
+    TickReplayer replayer("replay_test.csv", book);
+    ASSERT_FALSE(replayer.empty());
+    ReplayClock clock(replayer.first_time(), 0);
+    replayer.start(&handler, &clock);
+
+    // Wait for the StopEvent, which the replay queues after the last tick
+    bool stopped = false;
+    for (int i = 0; i < 500 && !stopped; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        pthread_mutex_lock(&mtx);
+        stopped = !queue.empty() && queue.back()->type == "STOP";
+        pthread_mutex_unlock(&mtx);
+    }
+    ASSERT_TRUE(stopped);
+    std::remove("replay_test.csv");
+
+    const std::vector<std::pair<std::string, BloombergLP::blpapi::Datetime>> expected = {
+            {"IBM US EQUITY", BloombergLP::blpapi::Datetime(2019, 1, 31, 9, 30, 0, 125)},
+            {"IBM US EQUITY", BloombergLP::blpapi::Datetime(2019, 1, 31, 9, 30, 1, 500)},
+            {"AAPL US EQUITY", BloombergLP::blpapi::Datetime(2019, 1, 31, 9, 30, 2, 0)}};
+    ASSERT_EQ(queue.size(), expected.size() + 1);
+    for (const auto& tick : expected) {
+        auto market = dynamic_cast<events::MarketEvent*>(queue.front().get());
+        ASSERT_NE(market, nullptr);
+        EXPECT_EQ(market->symbols, std::vector<std::string>({tick.first}));
+        EXPECT_EQ(market->datetime, tick.second);
+        queue.pop();
+    }
+    EXPECT_EQ(queue.front()->datetime, BloombergLP::blpapi::Datetime(2019, 1, 31, 9, 30, 2, 0));
+    EXPECT_DOUBLE_EQ(book.quotes[0].last, 134.5);
+    EXPECT_DOUBLE_EQ(book.quotes[0].bid, 134.19);
+    EXPECT_DOUBLE_EQ(book.quotes[1].ask, 166.2);
+    EXPECT_DOUBLE_EQ(book.quotes[1].last, 166.15);
+    // The clock is left a second past the last tick, so the strategy works through it
+    EXPECT_EQ(clock.now(), BloombergLP::blpapi::Datetime(2019, 1, 31, 9, 30, 3, 0));
+}
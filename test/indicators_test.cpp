@@ -0,0 +1,53 @@
+// Google Test include
+#include <gtest/gtest.h>
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+// Include custom classes
+#include "indicators.hpp"
+
+// MARK: Tests
+// Checks the incremental indicators against the same statistics computed over the window from scratch
+TEST(IndicatorsFixture, rolling_indicators) { // NOLINT(cert-err58-cpp)
+    RollingIndicators indicators(10);
+    std::vector<double> series;
+    for (int i = 0; i < 57; ++i) {
+        series.push_back(100 + i * 0.5 + 7 * std::sin(i * 1.3));
+        indicators.update(series.back());
+    }
+    const std::vector<double> window(series.end() - 10, series.end());
+    double mean = 0, slope_numerator = 0;
+    for (double value : window) { mean += value / 10; }
+    double variance = 0;
+    for (int i = 0; i < 10; ++i) {
+        variance += (window[i] - mean) * (window[i] - mean) / 10;
+        slope_numerator += (i - 4.5) * (window[i] - mean);
+    }
+
+    EXPECT_TRUE(indicators.ready());
+    EXPECT_NEAR(indicators.mean(), mean, 1e-9);
+    EXPECT_NEAR(indicators.variance(), variance, 1e-9);
+    EXPECT_NEAR(indicators.slope(), slope_numerator / 82.5, 1e-9);
+    EXPECT_NEAR(indicators.fitted(4.5), mean, 1e-9);
+    EXPECT_DOUBLE_EQ(indicators.min(), *std::min_element(window.begin(), window.end()));
+    EXPECT_DOUBLE_EQ(indicators.max(), *std::max_element(window.begin(), window.end()));
+    EXPECT_DOUBLE_EQ(indicators.back(1), window[8]);
+}
+// Checks that a price the market event marks stale, e.g. once the symbol has delisted, is not taken as another bar
+TEST(IndicatorsFixture, skips_stale_prices) { // NOLINT(cert-err58-cpp)
+    Indicators indicators({"A", "B"}, 3);
+    const double a[] = {1, 2, 2, 2};
+    for (int day = 0; day < 4; ++day) {
+        std::unordered_set<std::string> stale;
+        if (day >= 2) { stale.insert("A"); }
+        indicators.update(events::MarketEvent({"A", "B"}, {{"A", a[day]}, {"B", 10.0 + day}},
+                                              BloombergLP::blpapi::Datetime(2017, 6, 1 + day, 0, 0, 0), stale));
+    }
+
+    EXPECT_EQ(indicators["A"].size(), 2u);
+    EXPECT_FALSE(indicators["A"].ready());
+    EXPECT_DOUBLE_EQ(indicators["A"].slope(), 1);
+    EXPECT_TRUE(indicators["B"].ready());
+    EXPECT_DOUBLE_EQ(indicators["B"].mean(), 12);
+}
@@ -0,0 +1,51 @@
+// Google Test include
+#include <gtest/gtest.h>
+// STL includes
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+// Include custom classes
+#include "indicators.hpp"
+#include "kernels.hpp"
+
+// MARK: Tests
+// Checks the universe-wide kernels against the per-symbol indicators, with every instruction set available
+TEST(KernelsFixture, matches_indicators) { // NOLINT(cert-err58-cpp)
+    for (kernels::Isa isa : {kernels::SCALAR, kernels::AVX2}) {
+        kernels::use_isa(isa);
+        const size_t symbols = 7;
+        kernels::RollingPanel panel(symbols, 10);
+        std::vector<RollingIndicators> indicators(symbols, RollingIndicators(10));
+        std::vector<double> row(symbols);
+        for (int i = 0; i < 33; ++i) {
+            for (size_t j = 0; j < symbols; ++j) {
+                row[j] = 1000 * (j + 1) + i * 0.5 * j + 7 * std::sin(i * 1.3 + j);
+                indicators[j].update(row[j]);
+            }
+            panel.update(row.data());
+        }
+        std::vector<double> mean(symbols), variance(symbols), slope(symbols), intercept(symbols);
+        panel.mean(mean.data());
+        panel.variance(variance.data());
+        panel.slope(slope.data());
+        panel.intercept(intercept.data());
+        for (size_t j = 0; j < symbols; ++j) {
+            EXPECT_NEAR(mean[j], indicators[j].mean(), 1e-9);
+            EXPECT_NEAR(variance[j], indicators[j].variance(), 1e-7);
+            EXPECT_NEAR(slope[j], indicators[j].slope(), 1e-9);
+            EXPECT_NEAR(intercept[j], indicators[j].intercept(), 1e-7);
+        }
+
+        const std::vector<double> values = {3, 1, 4, 1, 5, 9, 2, 6, 5};
+        std::vector<double> ranks(values.size()), scores(values.size()), clamped(values.size());
+        kernels::rank(values.data(), ranks.data(), values.size());
+        EXPECT_DOUBLE_EQ(ranks[1], 0.0625);
+        EXPECT_DOUBLE_EQ(ranks[5], 1);
+        kernels::zscore(values.data(), scores.data(), values.size());
+        EXPECT_NEAR(std::accumulate(scores.begin(), scores.end(), 0.0), 0, 1e-12);
+        kernels::winsorize(values.data(), clamped.data(), values.size(), 0.2, 0.8);
+        EXPECT_DOUBLE_EQ(*std::min_element(clamped.begin(), clamped.end()), 2);
+        EXPECT_DOUBLE_EQ(*std::max_element(clamped.begin(), clamped.end()), 5);
+    }
+}
@@ -30,4 +30,26 @@ TEST(PortfolioFixture, builds_empty_portfolio) { // NOLINT(cert-err58-cpp)
     // Check that the portfolio in the strategy has only one entry
     EXPECT_EQ(portfolio.all_holdings.size(), 1);
     EXPECT_EQ(portfolio.all_holdings[BloombergLP::blpapi::Datetime(2010, 1, 1, 0, 0, 0)]["IBM US EQUITY"], 0);
-}
\ No newline at end of file
+}
+// Checks that a checkpointed portfolio comes back with the same current and historical holdings
+TEST(PortfolioFixture, checkpoint_round_trip) { // NOLINT(cert-err58-cpp)
+    Portfolio portfolio({"IBM US EQUITY"}, 100000, BloombergLP::blpapi::Datetime(2010, 1, 1, 0, 0, 0));
+    portfolio.update_market(events::MarketEvent({"IBM US EQUITY"}, {{"IBM US EQUITY", 130}},
+                                                BloombergLP::blpapi::Datetime(2010, 1, 4, 16, 0, 0)));
+    portfolio.update_fill(events::FillEvent("IBM US EQUITY", 10, 1300, 0.5, 1,
+                                            BloombergLP::blpapi::Datetime(2010, 1, 4, 16, 0, 0)));
+
+    // Write it out and read it into a portfolio built differently
+    checkpoint::Writer writer;
+    portfolio.write_checkpoint(writer);
+    writer.save("portfolio_checkpoint.bin");
+    Portfolio restored({"IBM US EQUITY"}, 1, BloombergLP::blpapi::Datetime(2000, 1, 1, 0, 0, 0));
+    checkpoint::Reader reader("portfolio_checkpoint.bin");
+    restored.read_checkpoint(reader);
+
+    EXPECT_EQ(restored.current_positions, portfolio.current_positions);
+    EXPECT_EQ(restored.current_holdings, portfolio.current_holdings);
+    EXPECT_EQ(restored.all_positions, portfolio.all_positions);
+    EXPECT_EQ(restored.all_holdings, portfolio.all_holdings);
+    std::remove("portfolio_checkpoint.bin");
+}
@@ -4,10 +4,15 @@
 
 // Include Google Test
 #include <gtest/gtest.h>
+// STL includes
+#include <cmath>
+#include <limits>
 // Include custom classes
 #include "constants.hpp"
 #include "strategy.hpp"
+#include "strategyhost.hpp"
 #include "strategy/custom/src/basic_algo.hpp"
+#include "vectorized.hpp"
 
 // Test class for strategy-related functions
 
@@ -24,6 +29,70 @@ public:
     ~StrategyFixture() override = default;
 };
 
+// Rebalances into an equal weight of every symbol at each open, for comparing against the vectorized engine, either
+// one symbol at a time or as a single batch
+class EqualWeightStrategy : public Strategy {
+public:
+    EqualWeightStrategy(const std::vector<std::string>& symbols, const BloombergLP::blpapi::Datetime& start,
+                        const BloombergLP::blpapi::Datetime& end, const SyntheticMarket& market,
+                        bool p_batched = false) :
+            Strategy(symbols, 1000000, start, end, market), batched(p_batched) { schedule(); }
+    EqualWeightStrategy(const std::vector<std::string>& symbols, const BloombergLP::blpapi::Datetime& start,
+                        const BloombergLP::blpapi::Datetime& end, std::shared_ptr<DataManager> shared_data,
+                        bool p_batched = false) :
+            Strategy(symbols, 1000000, start, end, std::move(shared_data)), batched(p_batched) { schedule(); }
+    void schedule() {
+        schedule_function([](Strategy* x)->void {
+            auto e = dynamic_cast<EqualWeightStrategy*>(x); if (e) e->rebalance(); },
+                          date_rules.every_day(), TimeRules::market_open(0, 1));
+    }
+    void rebalance() {
+        std::unordered_map<std::string, double> targets;
+        for (const std::string& symbol : symbol_list) { targets[symbol] = 0.95 / symbol_list.size(); }
+        if (batched) {
+            order_target_percents(targets);
+        } else {
+            for (const std::string& symbol : symbol_list) { order_target_percent(symbol, targets[symbol]); }
+        }
+    }
+    double total_holdings() { return portfolio.current_holdings[portfolio_fields::TOTAL_HOLDINGS]; }
+
+    const bool batched;
+};
+
+// Holds the two symbols with the best 20 day returns, as screened by a pipeline each morning
+class TopMomentumStrategy : public Strategy {
+public:
+    TopMomentumStrategy(const std::vector<std::string>& symbols, const BloombergLP::blpapi::Datetime& start,
+                        const BloombergLP::blpapi::Datetime& end, const SyntheticMarket& market) :
+            Strategy(symbols, 1000000, start, end, market) {
+        attach_pipeline(screen());
+        schedule_function([](Strategy* x)->void {
+            auto t = dynamic_cast<TopMomentumStrategy*>(x); if (t) t->rebalance(); },
+                          date_rules.every_day(), TimeRules::market_open(0, 1));
+    }
+    // The pipeline, with the 20 day returns asked for twice to check they are only computed once
+    static Pipeline screen() {
+        Pipeline pipeline;
+        const Term momentum = pipeline.returns(20);
+        pipeline.column("momentum", momentum);
+        pipeline.column("rank", pipeline.rank(pipeline.returns(20)));
+        pipeline.column("volatility", pipeline.volatility(20));
+        pipeline.screen(pipeline.top(momentum, 2));
+        return pipeline;
+    }
+    void rebalance() {
+        const PipelineOutput& output = pipeline_output();
+        sizes.push_back(output.size());
+        std::unordered_map<std::string, double> targets;
+        for (const std::string& symbol : symbol_list) { targets[symbol] = 0; }
+        for (const std::string& symbol : output.symbols) { targets[symbol] = 0.45; }
+        order_target_percents(targets);
+    }
+
+    std::vector<size_t> sizes;
+};
+
 // MARK: Tests
 // Checks the scheduling function to place the events on the stack correctly
 TEST(StrategyFixture, schedule_functions) { // NOLINT(cert-err58-cpp)
@@ -65,4 +134,215 @@ TEST(StrategyFixture, run_derived) { // NOLINT(cert-err58-cpp)
 
     // Run the function which should print out "CHECKED" several times
     EXPECT_NO_THROW(strat.run()); // NOLINT(cppcoreguidelines-avoid-goto)
-}
\ No newline at end of file
+}
+// Checks that a burst of messages reaches a file sink as one coalesced batch
+TEST(NotifierFixture, notifications) { // NOLINT(cert-err58-cpp)
+    const std::string filepath = "notifier_test.txt";
+    std::remove(filepath.c_str());
+    {
+        Notifier notifier(std::make_unique<FileSink>(filepath), 256, std::chrono::milliseconds(50));
+        notifier.notify("Stop loss hit");
+        notifier.notify("Stop loss hit");
+        notifier.notify("Backtest finished.");
+        notifier.flush();
+    }
+
+    // Read the lines back out of the file
+    std::ifstream file(filepath);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);) { lines.push_back(line); }
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0], "Stop loss hit (x2)");
+    EXPECT_EQ(lines[1], "Backtest finished.");
+}
+// Checks that the vectorized engine tracks the event engine running the same rebalances, bar by bar
+TEST(StrategyFixture, vectorized_matches_events) { // NOLINT(cert-err58-cpp)
+    const std::vector<std::string> symbols = {"SYN00000 US EQUITY", "SYN00001 US EQUITY", "SYN00002 US EQUITY",
+                                              "SYN00003 US EQUITY", "SYN00004 US EQUITY"};
+    SyntheticMarket market;
+    market.warmup_days = 30;
+    const BloombergLP::blpapi::Datetime start(2017, 1, 3, 0, 0, 0), end(2018, 1, 2, 0, 0, 0);
+    EqualWeightStrategy strategy(symbols, start, end, market, true);
+    strategy.use_expected_slippage();
+    strategy.run();
+
+    // The event engine trades at each open on the close before it, so the vectorized one trades on the same closes,
+    // from the last one before the start to the one before the last. The bars are generated from the same day on.
+    SyntheticMarket earlier = market;
+    earlier.warmup_days -= 7;
+    BloombergLP::blpapi::Datetime current_time = start;
+    SyntheticDataManager data(&current_time, earlier);
+    std::list<std::unique_ptr<events::Event>> heap;
+    data.fillHistory(symbols, date_funcs::add_seconds(start, -7 * 24 * 60 * 60), end, &heap);
+    VectorizedBacktest backtest(PriceMatrix::from_events(symbols, heap), 1000000);
+    const PriceMatrix& prices = backtest.prices();
+    size_t first = 0;
+    while (first + 1 < prices.times.size() && date_funcs::is_greater(start, prices.times[first + 1])) { first++; }
+    VectorizedResult result = backtest.run([first](size_t row, const PriceMatrix& prices, double* weights) {
+        std::fill(weights, weights + prices.symbols.size(), 0.95 / prices.symbols.size());
+        return row >= first && row + 1 < prices.times.size();
+    });
+
+    // Each rebalance's fills are recorded at the open, with the total holdings valued at the close they traded on,
+    // which is the vectorized equity at that close. The last close is after the last rebalance in both.
+    std::vector<double> rebalanced;
+    for (const auto& row : strategy.portfolio.all_holdings) {
+        if (row.first.hours() == 9) { rebalanced.push_back(row.second.at(portfolio_fields::TOTAL_HOLDINGS)); }
+    }
+    ASSERT_EQ(result.equity.size(), prices.times.size());
+    ASSERT_EQ(rebalanced.size() + 1, prices.times.size() - first);
+    for (size_t i = 0; i < rebalanced.size(); ++i) {
+        EXPECT_NEAR(result.equity[first + i], rebalanced[i], 0.01) << "at rebalance " << i;
+    }
+    EXPECT_NEAR(result.equity.back(), strategy.total_holdings(), 0.01);
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        EXPECT_EQ(result.positions[i], strategy.portfolio.current_positions[symbols[i]]) << symbols[i];
+    }
+    EXPECT_GT(result.fills, 0u);
+}
+// Checks that a batched rebalance fills the same targets as ordering one symbol at a time
+TEST(StrategyFixture, batched_rebalance) { // NOLINT(cert-err58-cpp)
+    const std::vector<std::string> symbols = {"SYN00000 US EQUITY", "SYN00001 US EQUITY", "SYN00002 US EQUITY",
+                                              "SYN00003 US EQUITY", "SYN00004 US EQUITY"};
+    SyntheticMarket market;
+    market.warmup_days = 30;
+    const BloombergLP::blpapi::Datetime start(2017, 1, 3, 0, 0, 0), end(2017, 7, 3, 0, 0, 0);
+    EqualWeightStrategy single(symbols, start, end, market);
+    single.run();
+    EqualWeightStrategy batched(symbols, start, end, market, true);
+    batched.run();
+
+    // Every symbol ends up near its target either way, and only the slippage differs between the two
+    for (const std::string& symbol : symbols) {
+        EXPECT_NEAR(batched.portfolio.current_holdings[symbol] / batched.total_holdings(), 0.19, 0.005);
+        EXPECT_NEAR(batched.portfolio.current_positions[symbol], single.portfolio.current_positions[symbol],
+                    std::abs(single.portfolio.current_positions[symbol]) * 0.01 + 1);
+    }
+    EXPECT_NEAR(batched.total_holdings() / single.total_holdings(), 1, 0.01);
+    EXPECT_THROW(batched.order_target_percents({{"NOT A SYMBOL", 0.5}}), std::runtime_error);
+}
+// Checks the pipeline's terms against the same statistics computed directly, and that a strategy gets its output
+TEST(StrategyFixture, pipeline) { // NOLINT(cert-err58-cpp)
+    const std::vector<std::string> symbols = {"SYN00000 US EQUITY", "SYN00001 US EQUITY", "SYN00002 US EQUITY",
+                                              "SYN00003 US EQUITY", "SYN00004 US EQUITY"};
+    SyntheticMarket market;
+    market.warmup_days = 60;
+    const BloombergLP::blpapi::Datetime start(2017, 1, 3, 0, 0, 0), end(2017, 4, 3, 0, 0, 0);
+    Pipeline pipeline = TopMomentumStrategy::screen();
+    EXPECT_EQ(pipeline.size(), 4u);
+    EXPECT_EQ(pipeline.lookback(), 20u);
+
+    BloombergLP::blpapi::Datetime current_time = start;
+    SyntheticDataManager data(&current_time, market);
+    std::list<std::unique_ptr<events::Event>> heap;
+    data.fillHistory(symbols, start, end, &heap);
+    const Panel panel = data.history_panel(symbols, {"PX_LAST"}, 50, "DAILY");
+    const PipelineOutput output = pipeline.run(panel);
+    ASSERT_EQ(output.size(), 2u);
+    EXPECT_EQ(output.columns, std::vector<std::string>({"momentum", "rank", "volatility"}));
+    const size_t last = panel.times.size() - 1;
+    std::vector<double> momentum;
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        momentum.push_back(panel.at(0, last, i) / panel.at(0, last - 20, i) - 1);
+    }
+    std::vector<double> sorted = momentum;
+    std::sort(sorted.begin(), sorted.end());
+    for (const std::string& symbol : output.symbols) {
+        const size_t i = panel.symbol_index(symbol);
+        EXPECT_NEAR(output.get(symbol, "momentum"), momentum[i], 1e-12);
+        EXPECT_GE(momentum[i], sorted[3]);
+        EXPECT_GE(output.get(symbol, "rank"), 0.75);
+        RollingIndicators returns(20);
+        for (size_t time = last - 19; time <= last; ++time) {
+            returns.update(panel.at(0, time, i) / panel.at(0, time - 1, i) - 1);
+        }
+        EXPECT_NEAR(output.get(symbol, "volatility"), std::sqrt(returns.variance()), 1e-9);
+    }
+    EXPECT_THROW(output.get("NOT A SYMBOL", "momentum"), std::runtime_error);
+
+    // A symbol with a missing price has no moving average, and is ranked among the others only by what it has
+    Panel gappy(symbols, {"PX_LAST"}, panel.times);
+    std::copy(panel.values.begin(), panel.values.end(), gappy.values.begin());
+    gappy.row(0, last - 2)[1] = std::numeric_limits<double>::quiet_NaN();
+    Pipeline averages;
+    averages.column("average", averages.moving_average(5));
+    averages.column("quintile", averages.quantiles(averages.moving_average(5), 5));
+    const PipelineOutput averaged = averages.run(gappy);
+    EXPECT_EQ(averaged.size(), symbols.size());
+    EXPECT_TRUE(std::isnan(averaged.get(symbols[1], "average")));
+    EXPECT_TRUE(std::isnan(averaged.get(symbols[1], "quintile")));
+    EXPECT_NEAR(averaged.get(symbols[0], "average"),
+                (panel.at(0, last, 0) + panel.at(0, last - 1, 0) + panel.at(0, last - 2, 0) +
+                 panel.at(0, last - 3, 0) + panel.at(0, last - 4, 0)) / 5, 1e-9);
+
+    TopMomentumStrategy strategy(symbols, start, end, market);
+    strategy.run();
+    ASSERT_FALSE(strategy.sizes.empty());
+    for (size_t size : strategy.sizes) { EXPECT_EQ(size, 2u); }
+}
+// Checks that strategies run by a host over one market end up where they would run on their own, on any number of
+// threads
+TEST(StrategyFixture, strategy_host) { // NOLINT(cert-err58-cpp)
+    const std::vector<std::string> symbols = {"SYN00000 US EQUITY", "SYN00001 US EQUITY", "SYN00002 US EQUITY",
+                                              "SYN00003 US EQUITY", "SYN00004 US EQUITY"};
+    SyntheticMarket market;
+    market.warmup_days = 30;
+    const BloombergLP::blpapi::Datetime start(2017, 1, 3, 0, 0, 0), end(2017, 7, 3, 0, 0, 0);
+    EqualWeightStrategy alone(symbols, start, end, market, true);
+    alone.run();
+    EqualWeightStrategy fewer({symbols[0], symbols[1]}, start, end, market, true);
+    fewer.run();
+
+    for (unsigned int threads : {1u, 3u}) {
+        StrategyHost host(symbols, start, end, market);
+        std::vector<EqualWeightStrategy*> hosted;
+        for (int i = 0; i < 4; ++i) {
+            hosted.push_back(&host.add(std::make_unique<EqualWeightStrategy>(symbols, start, end, host.data(), true)));
+        }
+        auto& pair = host.add(std::make_unique<EqualWeightStrategy>(
+                std::vector<std::string>({symbols[0], symbols[1]}), start, end, host.data(), true));
+        EXPECT_THROW(host.add(std::make_unique<EqualWeightStrategy>(symbols, start, end, market)), // NOLINT
+                     std::runtime_error);
+        EXPECT_THROW(pair.run(), std::runtime_error); // NOLINT(cppcoreguidelines-avoid-goto)
+        auto checkpointed = std::make_unique<EqualWeightStrategy>(symbols, start, end, host.data(), true);
+        checkpointed->checkpoint_every("host_checkpoint.bin", 10);
+        EXPECT_THROW(host.add(std::move(checkpointed)), std::runtime_error); // NOLINT(cppcoreguidelines-avoid-goto)
+        host.run(threads);
+
+        // Slippage is random, so only close rather than equal
+        for (EqualWeightStrategy* strategy : hosted) {
+            EXPECT_NEAR(strategy->total_holdings() / alone.total_holdings(), 1, 0.005);
+            for (const std::string& symbol : symbols) {
+                EXPECT_NEAR(strategy->portfolio.current_positions[symbol], alone.portfolio.current_positions[symbol],
+                            std::abs(alone.portfolio.current_positions[symbol]) * 0.01 + 1);
+            }
+        }
+        EXPECT_NEAR(pair.total_holdings() / fewer.total_holdings(), 1, 0.005);
+    }
+}
+// Checks that a strategy is measured against a symbol it trades and one it does not in the same run
+TEST(StrategyFixture, benchmark_overlay) { // NOLINT(cert-err58-cpp)
+    const std::vector<std::string> symbols = {"SYN00000 US EQUITY", "SYN00001 US EQUITY", "SYN00002 US EQUITY",
+                                              "SYN00003 US EQUITY"};
+    SyntheticMarket market;
+    market.warmup_days = 30;
+    const BloombergLP::blpapi::Datetime start(2017, 1, 3, 0, 0, 0), end(2017, 7, 3, 0, 0, 0);
+    EqualWeightStrategy strategy(symbols, start, end, market, true);
+    strategy.compare_to(symbols[0]);
+    strategy.compare_to("SYN00009 US EQUITY");
+    EXPECT_THROW(strategy.compare_to(symbols[0]), std::runtime_error); // NOLINT(cppcoreguidelines-avoid-goto)
+    strategy.run();
+
+    // The symbols are independent, so the strategy moves with the one it holds a quarter in and not the other
+    const PerformanceStats traded = strategy.benchmark_stats(symbols[0]);
+    const PerformanceStats untraded = strategy.benchmark_stats("SYN00009 US EQUITY");
+    ASSERT_TRUE(traded.has_benchmark);
+    ASSERT_TRUE(untraded.has_benchmark);
+    EXPECT_EQ(traded.beta, strategy.analytics.stats().beta);
+    EXPECT_EQ(untraded.periods, traded.periods);
+    EXPECT_EQ(untraded.total_return, traded.total_return);
+    EXPECT_GT(traded.correlation, 0.3);
+    EXPECT_LT(std::abs(untraded.correlation), 0.3);
+    EXPECT_GT(untraded.tracking_error, 0);
+    EXPECT_THROW(strategy.benchmark_stats("NOT A SYMBOL"), std::runtime_error); // NOLINT
+}